@@ -0,0 +1,1592 @@
+// Times the CPU side of the asset pipeline in Src/Common: procedural mesh
+// generation, glTF loading and attribute decoding, DDS header parsing, the
+// text mesh import and cache, mesh reordering, meshlets and their culling,
+// simplification, vertex quantization and streams, glTF scene packs and background
+// loading. Also times the Waves solver of the Blending sample and reports
+// thread pool utilization.
+//
+// Usage: common_bench [assetsDirectory]   (defaults to "Assets")
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../Common/AssetLoader.h"
+#include "../Common/DDS.h"
+#include "../Common/GeometryGenerator.h"
+#include "../Common/GLTFLoader.h"
+#include "../Common/Math.h"
+#include "../Common/MeshCache.h"
+#include "../Common/MeshImport.h"
+#include "../Common/MeshOptimize.h"
+#include "../Common/Meshlets.h"
+#include "../Common/MeshSimplify.h"
+#include "../Common/ScenePack.h"
+#include "../Common/ThreadPool.h"
+#include "../Common/VertexQuantize.h"
+#include "../Common/VertexStreams.h"
+#include "../Blending/Waves.h"
+#include "../Ext/json.hpp"
+
+namespace {
+    // Runs fn iterations times after one warm-up call and prints the mean and
+    // best time per iteration.
+    void Run(const char* name, int iterations, const std::function<size_t()>& fn) {
+        using Clock = std::chrono::steady_clock;
+
+        size_t work = fn();
+
+        double total = 0.0;
+        double best = 1e30;
+        for (int i = 0; i < iterations; ++i) {
+            auto start = Clock::now();
+            work = fn();
+            double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            total += ms;
+            best = std::min(best, ms);
+        }
+
+        printf("%-36s %8d %12.4f %12.4f %12zu\n", name, iterations, total / iterations, best, work);
+    }
+
+    std::vector<uint8_t> ReadFile(const std::filesystem::path& path) {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        std::vector<uint8_t> data(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(data.data()), data.size());
+        return data;
+    }
+
+    // Repacks a .gltf whose geometry is in a single external buffer as a .glb.
+    // Image URIs stay relative to the .gltf.
+    bool WriteGLB(const std::filesystem::path& gltfPath, const std::filesystem::path& glbPath) {
+        std::vector<uint8_t> text = ReadFile(gltfPath);
+        nlohmann::json document = nlohmann::json::parse(text.begin(), text.end(), nullptr, false);
+        if (document.is_discarded() || document["buffers"].size() != 1 || !document["buffers"][0].contains("uri")) {
+            return false;
+        }
+
+        std::filesystem::path binPath = gltfPath.parent_path() / document["buffers"][0]["uri"].get<std::string>();
+        if (!std::filesystem::exists(binPath)) {
+            return false;
+        }
+        std::vector<uint8_t> bin = ReadFile(binPath);
+        document["buffers"][0].erase("uri");
+
+        // Chunks are padded to 4 bytes, JSON with spaces and BIN with zeros.
+        std::string json = document.dump();
+        json.resize((json.size() + 3) & ~size_t(3), ' ');
+        bin.resize((bin.size() + 3) & ~size_t(3), 0);
+
+        const uint32_t header[] = {
+            0x46546C67, 2, uint32_t(12 + 8 + json.size() + 8 + bin.size()),
+            uint32_t(json.size()), 0x4E4F534A
+        };
+        const uint32_t binHeader[] = { uint32_t(bin.size()), 0x004E4942 };
+
+        std::ofstream file(glbPath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(header), sizeof(header));
+        file.write(json.data(), json.size());
+        file.write(reinterpret_cast<const char*>(binHeader), sizeof(binHeader));
+        file.write(reinterpret_cast<const char*>(bin.data()), bin.size());
+        return static_cast<bool>(file);
+    }
+
+    bool SameViews(const GLTFLoader& a, const GLTFLoader& b) {
+        std::vector<GLTFScenePrimitive> primitives = a.FlattenScene();
+        if (primitives.size() != b.FlattenScene().size()) {
+            return false;
+        }
+        for (const auto& scenePrimitive : primitives) {
+            MeshImport::SourceMesh meshA, meshB;
+            MeshImport::FromGLTF(a.GetPrimitiveView(scenePrimitive), meshA);
+            MeshImport::FromGLTF(b.GetPrimitiveView(scenePrimitive), meshB);
+            if (meshA.Indices != meshB.Indices ||
+                memcmp(meshA.Positions.data(), meshB.Positions.data(), meshA.Positions.size() * sizeof(DirectX::XMFLOAT3)) != 0 ||
+                meshA.Positions.size() != meshB.Positions.size()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void BenchGeometryGenerator() {
+        GeometryGenerator geoGen;
+
+        Run("GeometryGenerator::CreateBox", 200, [&]() {
+            return geoGen.CreateBox(1.0f, 1.0f, 1.0f, 3).Vertices.size();
+        });
+        Run("GeometryGenerator::CreateSphere", 200, [&]() {
+            return geoGen.CreateSphere(0.5f, 64, 64).Vertices.size();
+        });
+        Run("GeometryGenerator::CreateGeosphere", 50, [&]() {
+            return geoGen.CreateGeosphere(0.5f, 5).Vertices.size();
+        });
+        Run("GeometryGenerator::CreateCylinder", 200, [&]() {
+            return geoGen.CreateCylinder(0.5f, 0.3f, 3.0f, 64, 64).Vertices.size();
+        });
+        Run("GeometryGenerator::CreateGrid", 50, [&]() {
+            return geoGen.CreateGrid(160.0f, 160.0f, 512, 512).Vertices.size();
+        });
+    }
+
+    void BenchGLTF(const std::filesystem::path& assets) {
+        for (const char* model : { "Sponza/Sponza.gltf", "BoomBox/BoomBox.gltf" }) {
+            std::string filename = (assets / model).generic_string();
+            if (!std::filesystem::exists(filename)) {
+                printf("%-36s skipped, %s not found\n", "GLTFLoader", filename.c_str());
+                continue;
+            }
+
+            // Buffers may be missing from the checkout (Sponza.bin is not in the repo).
+            if (!GLTFLoader(filename).LoadModel()) {
+                printf("%-36s skipped, %s failed to load\n", "GLTFLoader", filename.c_str());
+                continue;
+            }
+
+            std::string name = std::string("GLTFLoader ") + std::filesystem::path(filename).filename().string();
+            Run(name.c_str(), 5, [&]() {
+                GLTFLoader loader(filename);
+                loader.LoadModel();
+
+                size_t vertexCount = 0;
+                for (const auto& sceneMesh : loader.LoadScene()) {
+                    vertexCount += sceneMesh.data.positions.size();
+                }
+                return vertexCount;
+            });
+
+            // The same model as a .glb, whose BIN chunk is mapped in place.
+            std::filesystem::path glbPath = std::filesystem::temp_directory_path() /
+                std::filesystem::path(filename).filename().replace_extension(".glb");
+            if (WriteGLB(filename, glbPath)) {
+                std::string glbFilename = glbPath.generic_string();
+                GLTFLoader gltfLoader(filename);
+                GLTFLoader glbLoader(glbFilename);
+                if (!glbLoader.LoadModel() || !gltfLoader.LoadModel() || !SameViews(gltfLoader, glbLoader)) {
+                    printf("%-36s FAILED, %s differs from the .gltf\n", "GLTFLoader", glbFilename.c_str());
+                }
+
+                name = std::string("GLTFLoader ") + glbPath.filename().string();
+                Run(name.c_str(), 5, [&]() {
+                    GLTFLoader loader(glbFilename);
+                    loader.LoadModel();
+
+                    size_t vertexCount = 0;
+                    for (const auto& sceneMesh : loader.LoadScene()) {
+                        vertexCount += sceneMesh.data.positions.size();
+                    }
+                    return vertexCount;
+                });
+                std::filesystem::remove(glbPath);
+            }
+
+            // Getting the primitives into the import pipeline, through
+            // GLTFPrimitiveData and straight from the accessor views.
+            GLTFLoader loader(filename);
+            loader.LoadModel();
+            name = std::string("GLTF copies ") + std::filesystem::path(filename).filename().string();
+            Run(name.c_str(), 20, [&]() {
+                size_t vertexCount = 0;
+                MeshImport::SourceMesh mesh;
+                for (const auto& sceneMesh : loader.LoadScene()) {
+                    MeshImport::FromGLTF(sceneMesh.data, mesh);
+                    vertexCount += mesh.VertexCount();
+                }
+                return vertexCount;
+            });
+            name = std::string("GLTF views ") + std::filesystem::path(filename).filename().string();
+            Run(name.c_str(), 20, [&]() {
+                size_t vertexCount = 0;
+                MeshImport::SourceMesh mesh;
+                for (const auto& scenePrimitive : loader.FlattenScene()) {
+                    MeshImport::FromGLTF(loader.GetPrimitiveView(scenePrimitive), mesh);
+                    vertexCount += mesh.VertexCount();
+                }
+                return vertexCount;
+            });
+
+            // The whole import, one primitive after another and then with
+            // primitives spread over the thread pool.
+            MeshImport::VertexLayout layout;
+            layout.Stride = sizeof(MeshCache::Vertex);
+            layout.PositionOffset = offsetof(MeshCache::Vertex, Pos);
+            layout.NormalOffset = offsetof(MeshCache::Vertex, Normal);
+            layout.TexCOffset = offsetof(MeshCache::Vertex, TexC);
+            layout.TangentOffset = offsetof(MeshCache::Vertex, TangentU);
+
+            auto importSerially = [&]() {
+                std::vector<MeshImport::ScenePrimitive> primitives;
+                for (const auto& scenePrimitive : loader.FlattenScene()) {
+                    MeshImport::SourceMesh mesh;
+                    MeshImport::FromGLTF(loader.GetPrimitiveView(scenePrimitive), mesh);
+                    MeshImport::Transform(mesh, DirectX::XMLoadFloat4x4(&scenePrimitive.world));
+                    MeshImport::Optimize(mesh);
+                    MeshImport::GenerateTangents(mesh);
+                    primitives.emplace_back();
+                    MeshImport::Pack(mesh, layout, primitives.back().Geometry);
+                }
+                return primitives;
+            };
+
+            std::vector<MeshImport::ScenePrimitive> expected = importSerially();
+            std::vector<MeshImport::ScenePrimitive> actual = MeshImport::ImportScene(loader, layout, MeshImport::Options());
+            bool same = expected.size() == actual.size();
+            for (size_t i = 0; same && i < expected.size(); ++i) {
+                same =
+                    expected[i].Geometry.VertexData == actual[i].Geometry.VertexData &&
+                    expected[i].Geometry.IndexData == actual[i].Geometry.IndexData;
+            }
+            if (!same) {
+                printf("%-36s FAILED, ImportScene differs from a serial import\n", "MeshImport::ImportScene");
+            }
+
+            name = std::string("Import serial ") + std::filesystem::path(filename).filename().string();
+            Run(name.c_str(), 10, [&]() {
+                return importSerially().size();
+            });
+            name = std::string("MeshImport::ImportScene ") + std::filesystem::path(filename).filename().string();
+            Run(name.c_str(), 10, [&]() {
+                return MeshImport::ImportScene(loader, layout, MeshImport::Options()).size();
+            });
+        }
+    }
+
+    // Decoding of quantized vertex attributes (KHR_mesh_quantization layouts)
+    // against float attributes, which are a copy. Checks every decoded value
+    // against the glTF spec's formulas.
+    void BenchAccessorDecode() {
+        const size_t count = 1 << 20;
+
+        std::vector<float> positions(count * 3);
+        std::vector<uint16_t> uvs(count * 2);
+        // VEC3 of shorts and bytes are padded to 4-byte strides.
+        std::vector<int16_t> normals16(count * 4);
+        std::vector<int8_t> normals8(count * 4);
+        for (size_t i = 0; i < count; ++i) {
+            for (int c = 0; c < 3; ++c) {
+                positions[i * 3 + c] = static_cast<float>(i * 3 + c);
+                normals16[i * 4 + c] = static_cast<int16_t>(i * 7 + c * 13 - 32768);
+                normals8[i * 4 + c] = static_cast<int8_t>(i * 5 + c * 3 - 128);
+            }
+            uvs[i * 2] = static_cast<uint16_t>(i);
+            uvs[i * 2 + 1] = static_cast<uint16_t>(i * 3);
+        }
+
+        auto makeView = [&](const void* data, int stride, int componentType, int componentCount, bool normalized) {
+            GLTFAccessorView view;
+            view.data = static_cast<const uint8_t*>(data);
+            view.count = count;
+            view.stride = stride;
+            view.componentType = componentType;
+            view.componentCount = componentCount;
+            view.normalized = normalized;
+            return view;
+        };
+        GLTFAccessorView positionView = makeView(positions.data(), 12, TINYGLTF_COMPONENT_TYPE_FLOAT, 3, false);
+        GLTFAccessorView uvView = makeView(uvs.data(), 4, TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT, 2, true);
+        GLTFAccessorView normal16View = makeView(normals16.data(), 8, TINYGLTF_COMPONENT_TYPE_SHORT, 3, true);
+        GLTFAccessorView normal8View = makeView(normals8.data(), 4, TINYGLTF_COMPONENT_TYPE_BYTE, 3, true);
+
+        std::vector<DirectX::XMFLOAT3> decoded3(count);
+        std::vector<DirectX::XMFLOAT2> decoded2(count);
+        float* out3 = reinterpret_cast<float*>(decoded3.data());
+        float* out2 = reinterpret_cast<float*>(decoded2.data());
+
+        bool correct = true;
+        uvView.DecodeTo(out2, 2, sizeof(DirectX::XMFLOAT2));
+        for (size_t i = 0; i < count * 2; ++i) {
+            correct = correct && out2[i] == uvs[i] / 65535.0f;
+        }
+        normal16View.DecodeTo(out3, 3, sizeof(DirectX::XMFLOAT3));
+        for (size_t i = 0; i < count; ++i) {
+            for (int c = 0; c < 3; ++c) {
+                correct = correct && out3[i * 3 + c] == std::max(normals16[i * 4 + c] / 32767.0f, -1.0f);
+            }
+        }
+        normal8View.DecodeTo(out3, 3, sizeof(DirectX::XMFLOAT3));
+        for (size_t i = 0; i < count; ++i) {
+            for (int c = 0; c < 3; ++c) {
+                correct = correct && out3[i * 3 + c] == std::max(normals8[i * 4 + c] / 127.0f, -1.0f);
+            }
+        }
+        positionView.DecodeTo(out3, 3, sizeof(DirectX::XMFLOAT3));
+        correct = correct && memcmp(out3, positions.data(), positions.size() * sizeof(float)) == 0;
+        if (!correct) {
+            printf("%-36s FAILED, decoded values differ from the spec\n", "GLTFAccessorView::DecodeTo");
+        }
+
+        Run("DecodeTo float3 (copy)", 20, [&]() {
+            positionView.DecodeTo(out3, 3, sizeof(DirectX::XMFLOAT3));
+            return count;
+        });
+        Run("DecodeTo unorm16x2", 20, [&]() {
+            uvView.DecodeTo(out2, 2, sizeof(DirectX::XMFLOAT2));
+            return count;
+        });
+        Run("DecodeTo snorm16x3", 20, [&]() {
+            normal16View.DecodeTo(out3, 3, sizeof(DirectX::XMFLOAT3));
+            return count;
+        });
+        Run("DecodeTo snorm8x3", 20, [&]() {
+            normal8View.DecodeTo(out3, 3, sizeof(DirectX::XMFLOAT3));
+            return count;
+        });
+
+        // Accessors are checked against the real length of a mapped .bin,
+        // not the placeholder tinygltf sees: three float3 fit in 36 bytes,
+        // four don't, nor three starting 4 bytes in. The 6 bytes after them
+        // are the indices 0, 1, 3.
+        std::filesystem::path directory = std::filesystem::temp_directory_path();
+        std::string gltfFilename = (directory / "bounds.gltf").generic_string();
+        {
+            const uint16_t indices[3] = { 0, 1, 3 };
+            std::ofstream bin(directory / "bounds.bin", std::ios::binary | std::ios::trunc);
+            bin.write(reinterpret_cast<const char*>(positions.data()), 36);
+            bin.write(reinterpret_cast<const char*>(indices), sizeof(indices));
+            std::ofstream gltf(gltfFilename, std::ios::trunc);
+            gltf << R"({"asset":{"version":"2.0"},"buffers":[{"uri":"bounds.bin","byteLength":42}],)"
+                R"("bufferViews":[{"buffer":0,"byteLength":36},{"buffer":0,"byteOffset":36,"byteLength":6}],"accessors":[)"
+                R"({"bufferView":0,"componentType":5126,"count":3,"type":"VEC3"},)"
+                R"({"bufferView":0,"componentType":5126,"count":4,"type":"VEC3"},)"
+                R"({"bufferView":0,"byteOffset":4,"componentType":5126,"count":3,"type":"VEC3"},)"
+                R"({"bufferView":1,"componentType":5123,"count":3,"type":"SCALAR"}],)"
+                R"("meshes":[{"primitives":[{"attributes":{"POSITION":0}},{"attributes":{"POSITION":0},"indices":3},)"
+                R"({"attributes":{"POSITION":1}}]}],"nodes":[{"mesh":0}],)"
+                R"("scenes":[{"nodes":[0]}],"scene":0})";
+        }
+        GLTFLoader loader(gltfFilename);
+        if (!loader.LoadModel() || loader.GetAccessorView(0).count != 3 ||
+            !loader.GetAccessorView(1).empty() || !loader.GetAccessorView(2).empty()) {
+            printf("%-36s FAILED, accessors past the end of their buffer aren't rejected\n", "GLTFLoader");
+        }
+
+        // The primitive without indices draws its three vertices; the one
+        // with an index past its last vertex, and the one whose positions
+        // were rejected, import as nothing.
+        MeshImport::VertexLayout layout;
+        layout.Stride = sizeof(MeshCache::Vertex);
+        layout.PositionOffset = offsetof(MeshCache::Vertex, Pos);
+        layout.NormalOffset = offsetof(MeshCache::Vertex, Normal);
+        layout.TexCOffset = offsetof(MeshCache::Vertex, TexC);
+        layout.TangentOffset = offsetof(MeshCache::Vertex, TangentU);
+        std::vector<MeshImport::ScenePrimitive> imported = MeshImport::ImportScene(loader, layout, MeshImport::Options());
+        if (imported.size() != 3 || imported[0].Geometry.IndexCount != 3 ||
+            imported[1].Geometry.IndexCount != 0 || imported[2].Geometry.IndexCount != 0) {
+            printf("%-36s FAILED, malformed glTF primitives aren't skipped\n", "MeshImport");
+        }
+        std::filesystem::remove(directory / "bounds.bin");
+        std::filesystem::remove(gltfFilename);
+    }
+
+    void BenchDDS(const std::filesystem::path& assets) {
+        std::vector<std::vector<uint8_t>> files;
+        if (std::filesystem::exists(assets)) {
+            for (const auto& entry : std::filesystem::recursive_directory_iterator(assets)) {
+                if (entry.is_regular_file() && entry.path().extension() == ".dds") {
+                    files.push_back(ReadFile(entry.path()));
+                }
+            }
+        }
+
+        if (files.empty()) {
+            printf("%-36s skipped, no .dds files under %s\n", "DDS::ParseHeader", assets.string().c_str());
+            return;
+        }
+
+        // Parses every header and walks the mip chain of each subresource, which
+        // is the CPU work the loader does before it touches the device.
+        Run("DDS::ParseHeader", 1000, [&]() {
+            size_t bytes = 0;
+            for (const auto& file : files) {
+                DDS::TextureInfo info;
+                if (!DDS::ParseHeader(file.data(), file.size(), info)) {
+                    continue;
+                }
+
+                for (uint32_t item = 0; item < info.ArraySize; ++item) {
+                    size_t w = info.Width;
+                    size_t h = info.Height;
+                    for (uint32_t mip = 0; mip < info.MipCount; ++mip) {
+                        size_t numBytes = 0;
+                        DDS::GetSurfaceInfo(w, h, info.Format, &numBytes, nullptr, nullptr);
+                        bytes += numBytes;
+                        w = std::max<size_t>(w >> 1, 1);
+                        h = std::max<size_t>(h >> 1, 1);
+                    }
+                }
+            }
+            return bytes;
+        });
+    }
+
+    void BenchMeshCache(const std::filesystem::path& assets) {
+        for (const char* model : { "car", "skull" }) {
+            std::string textFilename = (assets / (std::string(model) + ".txt")).string();
+            if (!std::filesystem::exists(textFilename)) {
+                printf("%-36s skipped, %s not found\n", "MeshCache", textFilename.c_str());
+                continue;
+            }
+
+            std::string name = std::string("MeshCache::LoadTextMesh ") + model;
+            Run(name.c_str(), 10, [&]() {
+                MeshCache::MeshData mesh;
+                MeshCache::LoadTextMesh(textFilename, mesh);
+                return mesh.Vertices.size();
+            });
+
+            // Written next to the binary rather than into the assets directory.
+            std::string cacheFilename = (std::filesystem::temp_directory_path() / (std::string(model) + ".mesh")).string();
+            if (!MeshCache::ConvertTextMesh(textFilename, cacheFilename)) {
+                printf("%-36s skipped, failed to write %s\n", "MeshCache", cacheFilename.c_str());
+                continue;
+            }
+
+            // Includes touching every byte, as uploading the buffers would.
+            name = std::string("MeshCache::File::Open ") + model;
+            Run(name.c_str(), 10, [&]() {
+                MeshCache::File file;
+                file.Open(cacheFilename);
+
+                size_t sum = 0;
+                auto bytes = static_cast<const uint8_t*>(file.VertexData());
+                for (size_t i = 0; i < file.VertexDataSize() + file.IndexDataSize(); i += 64) {
+                    sum += bytes[i];
+                }
+                return static_cast<size_t>(file.GetHeader().VertexCount) + (sum & 1);
+            });
+
+            std::filesystem::remove(cacheFilename);
+        }
+    }
+
+    // Cold start of a glTF scene: parsing and importing it against opening its
+    // precompiled pack.
+    void BenchScenePack(const std::filesystem::path& assets) {
+        for (const char* model : { "Sponza/Sponza.gltf", "BoomBox/BoomBox.gltf" }) {
+            std::string gltfFilename = (assets / model).generic_string();
+            std::string stem = std::filesystem::path(model).stem().string();
+
+            // Written next to the binary rather than into the assets directory.
+            std::string packFilename = (std::filesystem::temp_directory_path() / (stem + ".scene")).generic_string();
+            ScenePack::SceneData scene;
+            if (!ScenePack::Compile(gltfFilename, MeshImport::Options(), scene) || !ScenePack::Write(packFilename, scene)) {
+                printf("%-36s skipped, failed to compile %s\n", "ScenePack", gltfFilename.c_str());
+                continue;
+            }
+
+            // The pack must hold exactly what the import produces.
+            ScenePack::File file;
+            bool same =
+                file.Open(packFilename) &&
+                file.GetHeader().SubmeshCount == scene.Submeshes.size() &&
+                file.VertexDataSize() == scene.VertexData.size() &&
+                file.IndexDataSize() == scene.IndexData.size() &&
+                memcmp(file.VertexData(), scene.VertexData.data(), scene.VertexData.size()) == 0 &&
+                memcmp(file.IndexData(), scene.IndexData.data(), scene.IndexData.size()) == 0 &&
+                file.GetHeader().LodCount == scene.Lods.size() &&
+                memcmp(file.Lods(), scene.Lods.data(), scene.Lods.size() * sizeof(ScenePack::Lod)) == 0;
+            for (uint32_t i = 0; same && i < file.GetHeader().TextureCount; ++i) {
+                same = std::filesystem::absolute(file.TexturePath(i)) == std::filesystem::absolute(scene.Textures[i]).lexically_normal();
+            }
+            same = same && file.GetHeader().BufferFileCount == scene.BufferFiles.size();
+            for (uint32_t i = 0; same && i < file.GetHeader().BufferFileCount; ++i) {
+                same = std::filesystem::absolute(file.BufferFilePath(i)) == std::filesystem::absolute(scene.BufferFiles[i]).lexically_normal();
+            }
+            if (!same) {
+                printf("%-36s FAILED, %s differs from its scene\n", "ScenePack", packFilename.c_str());
+            }
+
+            // A pack compiled with other options is rebuilt.
+            MeshImport::Options unoptimized;
+            unoptimized.Optimize = false;
+            if (!ScenePack::OpenOrCompile(gltfFilename, packFilename, unoptimized, file) ||
+                file.GetHeader().OptionFlags != ScenePack::OptionFlags(unoptimized)) {
+                printf("%-36s FAILED, %s wasn't rebuilt for other options\n", "ScenePack", packFilename.c_str());
+            }
+            file = ScenePack::File();
+
+            // A write that fails, here because a directory is in the way of
+            // the rename, leaves no temporary file behind.
+            std::filesystem::path blocked = std::filesystem::temp_directory_path() / (stem + "Blocked.scene");
+            std::filesystem::create_directories(blocked / "Child");
+            if (ScenePack::Write(blocked.generic_string(), scene) || std::filesystem::exists(blocked.generic_string() + ".tmp")) {
+                printf("%-36s FAILED, a failed write left %s.tmp\n", "ScenePack", blocked.generic_string().c_str());
+            }
+            std::filesystem::remove_all(blocked);
+
+            std::string name = std::string("ScenePack::Compile ") + stem;
+            Run(name.c_str(), 5, [&]() {
+                ScenePack::SceneData compiled;
+                ScenePack::Compile(gltfFilename, MeshImport::Options(), compiled);
+                return compiled.Submeshes.size();
+            });
+
+            // Includes touching every byte, as uploading the buffers would.
+            name = std::string("ScenePack::File::Open ") + stem;
+            Run(name.c_str(), 20, [&]() {
+                ScenePack::File file;
+                file.Open(packFilename);
+
+                size_t sum = 0;
+                auto vertices = static_cast<const uint8_t*>(file.VertexData());
+                for (size_t i = 0; i < file.VertexDataSize(); i += 64) {
+                    sum += vertices[i];
+                }
+                auto indices = static_cast<const uint8_t*>(file.IndexData());
+                for (size_t i = 0; i < file.IndexDataSize(); i += 64) {
+                    sum += indices[i];
+                }
+                return static_cast<size_t>(file.GetHeader().SubmeshCount) + (sum & 1);
+            });
+
+            std::filesystem::remove(packFilename);
+        }
+    }
+
+    // Headless version of ShadowMapping's startup: Sponza's pack is opened on
+    // the asset loader, then its textures are read and parsed on the loader
+    // while this thread polls for them, as the render loop would. Reports the
+    // time until the geometry is usable, until the first texture is, and
+    // until everything is, against reading the textures serially.
+    void BenchAssetLoader(const std::filesystem::path& assets) {
+        using Clock = std::chrono::steady_clock;
+
+        std::string gltfFilename = (assets / "Sponza/Sponza.gltf").generic_string();
+        std::string packFilename = (std::filesystem::temp_directory_path() / "SponzaAsync.scene").generic_string();
+        // Compiling isn't part of startup once the pack exists.
+        if (!ScenePack::CompileFile(gltfFilename, packFilename, MeshImport::Options())) {
+            printf("%-36s skipped, failed to compile %s\n", "AssetLoader", gltfFilename.c_str());
+            return;
+        }
+
+        auto ms = [](Clock::time_point start) {
+            return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        };
+
+        auto start = Clock::now();
+        AssetLoader loader;
+        ScenePack::File pack;
+        std::future<bool> packOpened = loader.Submit([&]() { return pack.Open(packFilename); });
+        if (!packOpened.get()) {
+            printf("%-36s FAILED, %s didn't open\n", "AssetLoader", packFilename.c_str());
+            return;
+        }
+        double geometryReadyMs = ms(start);
+
+        double firstTextureReadyMs = 0.0;
+        uint32_t loaded = 0;
+        uint64_t loadedBytes = 0;
+        uint32_t textureCount = pack.GetHeader().TextureCount;
+        for (uint32_t i = 0; i < textureCount; ++i) {
+            loader.Submit(
+                [path = pack.TexturePath(i)]() { return AssetLoader::ReadTexture(path); },
+                [&](AssetLoader::TextureData& texture) {
+                    if (loaded == 0) {
+                        firstTextureReadyMs = ms(start);
+                    }
+                    loaded += texture.Loaded ? 1 : 0;
+                    loadedBytes += texture.FileData.size();
+                }
+            );
+        }
+        while (loader.GetProgress().Ready < loader.GetProgress().Submitted) {
+            if (loader.Poll() == 0) {
+                std::this_thread::yield();
+            }
+        }
+        double totalMs = ms(start);
+
+        auto serialStart = Clock::now();
+        for (uint32_t i = 0; i < textureCount; ++i) {
+            AssetLoader::ReadTexture(pack.TexturePath(i));
+        }
+        double serialMs = ms(serialStart);
+
+        printf("%-36s geometry %.3f ms, first texture %.3f ms, all %.3f ms (serial textures %.3f ms)\n",
+            "AssetLoader Sponza", geometryReadyMs, firstTextureReadyMs, totalMs, serialMs);
+        printf("%-36s %u of %u textures, %.1f MB, %u workers\n",
+            "AssetLoader Sponza", loaded, textureCount, loadedBytes / (1024.0 * 1024.0), loader.WorkerCount());
+
+        std::filesystem::remove(packFilename);
+    }
+
+    // Times each stage of the import pipeline on its own.
+    void BenchMeshImport(const std::filesystem::path& assets) {
+        std::string textFilename = (assets / "skull.txt").string();
+
+        MeshImport::SourceMesh source;
+        if (!MeshImport::LoadText(textFilename, source)) {
+            printf("%-36s skipped, %s not found\n", "MeshImport", textFilename.c_str());
+            return;
+        }
+
+        Run("MeshImport::LoadText skull", 10, [&]() {
+            MeshImport::SourceMesh mesh;
+            MeshImport::LoadText(textFilename, mesh);
+            return mesh.VertexCount();
+        });
+        Run("MeshImport::Transform skull", 50, [&]() {
+            MeshImport::SourceMesh mesh = source;
+            MeshImport::Transform(mesh, DirectX::XMMatrixScaling(2.0f, 2.0f, 2.0f));
+            return mesh.VertexCount();
+        });
+        Run("MeshImport::GenerateTangents skull", 50, [&]() {
+            MeshImport::GenerateTangents(source);
+            return source.Tangents.size();
+        });
+        Run("MeshImport::ComputeBounds skull", 50, [&]() {
+            DirectX::XMFLOAT3 center, extents;
+            MeshImport::ComputeBounds(source, center, extents);
+            return source.VertexCount();
+        });
+
+        MeshImport::VertexLayout layout;
+        layout.Stride = sizeof(MeshCache::Vertex);
+        layout.PositionOffset = offsetof(MeshCache::Vertex, Pos);
+        layout.NormalOffset = offsetof(MeshCache::Vertex, Normal);
+        layout.TexCOffset = offsetof(MeshCache::Vertex, TexC);
+        layout.TangentOffset = offsetof(MeshCache::Vertex, TangentU);
+
+        std::vector<MeshCache::Vertex> vertices(source.VertexCount());
+        Run("MeshImport::Pack skull", 50, [&]() {
+            MeshImport::Pack(source, layout, vertices.data());
+            return vertices.size();
+        });
+
+        // The skull's own order beats Tipsify's; Optimize must keep it rather
+        // than let the overdraw pass degrade it.
+        MeshImport::SourceMesh optimized = source;
+        MeshImport::OptimizeReport report = MeshImport::Optimize(optimized);
+        if (report.After.ACMR > 1.05f * report.Before.ACMR) {
+            printf("%-36s FAILED, Optimize took the skull's ACMR from %.3f to %.3f\n", "MeshImport", report.Before.ACMR, report.After.ACMR);
+        }
+
+        // A glTF quad without NORMAL gets a vertex per corner, each with the
+        // normal of its counterclockwise triangle.
+        GLTFPrimitiveData quad;
+        quad.positions = { { 0.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 1.0f, 1.0f, 0.0f }, { 0.0f, 1.0f, 0.0f } };
+        quad.uvs = { { 0.0f, 1.0f }, { 1.0f, 1.0f }, { 1.0f, 0.0f }, { 0.0f, 0.0f } };
+        quad.indices16 = { 0, 1, 2, 0, 2, 3 };
+        MeshImport::SourceMesh flat;
+        MeshImport::FromGLTF(quad, flat);
+        MeshImport::GenerateTangents(flat);
+        bool valid = flat.VertexCount() == 6 && flat.Normals.size() == 6 && flat.TexCoords.size() == 6;
+        for (size_t i = 0; valid && i < flat.VertexCount(); ++i) {
+            valid = flat.Normals[i].x == 0.0f && flat.Normals[i].y == 0.0f && flat.Normals[i].z == 1.0f &&
+                flat.Positions[i].x == quad.positions[quad.indices16[i]].x &&
+                flat.TexCoords[i].y == quad.uvs[quad.indices16[i]].y;
+        }
+        if (!valid) {
+            printf("%-36s FAILED, a primitive without normals didn't get flat ones\n", "MeshImport");
+        }
+    }
+
+    // Triangles of a list, each rotated to start at its smallest index (which
+    // keeps the winding) and sorted, for comparing two orders of a mesh.
+    std::vector<std::array<uint32_t, 3>> CanonicalTriangles(const std::vector<uint32_t>& indices) {
+        std::vector<std::array<uint32_t, 3>> triangles(indices.size() / 3);
+        for (size_t t = 0; t < triangles.size(); ++t) {
+            std::array<uint32_t, 3> triangle = { indices[3 * t], indices[3 * t + 1], indices[3 * t + 2] };
+            std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+            triangles[t] = triangle;
+        }
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    }
+
+    void PrintCacheStats(const char* name, const std::vector<uint32_t>& indices, size_t vertexCount) {
+        using MeshOptimize::CacheModel;
+        MeshOptimize::CacheStats fifo16 = MeshOptimize::SimulateVertexCache(indices, vertexCount, CacheModel::FIFO, 16);
+        MeshOptimize::CacheStats fifo32 = MeshOptimize::SimulateVertexCache(indices, vertexCount, CacheModel::FIFO, 32);
+        MeshOptimize::CacheStats lru16 = MeshOptimize::SimulateVertexCache(indices, vertexCount, CacheModel::LRU, 16);
+        printf("%-36s ACMR/ATVR FIFO16 %.3f/%.3f FIFO32 %.3f/%.3f LRU16 %.3f/%.3f\n", name,
+            fifo16.ACMR, fifo16.ATVR, fifo32.ACMR, fifo32.ATVR, lru16.ACMR, lru16.ATVR);
+    }
+
+    // Times the reordering passes and reports the simulated vertex cache
+    // efficiency before and after, on the text meshes and on a sphere whose
+    // triangles have been shuffled (the worst an exporter could do).
+    void BenchMeshOptimize(const std::filesystem::path& assets) {
+        std::vector<std::pair<std::string, MeshImport::SourceMesh>> meshes;
+        for (const char* model : { "skull.txt", "car.txt" }) {
+            MeshImport::SourceMesh mesh;
+            if (MeshImport::LoadText((assets / model).string(), mesh)) {
+                meshes.emplace_back(std::filesystem::path(model).stem().string(), std::move(mesh));
+            }
+        }
+        {
+            GeometryGenerator geoGen;
+            GeometryGenerator::MeshData sphere = geoGen.CreateSphere(1.0f, 256, 256);
+            MeshImport::SourceMesh mesh;
+            for (const auto& v : sphere.Vertices) {
+                mesh.Positions.push_back(v.Position);
+            }
+            std::vector<uint32_t> order(sphere.Indices32.size() / 3);
+            for (size_t t = 0; t < order.size(); ++t) {
+                order[t] = static_cast<uint32_t>(t);
+            }
+            // A fixed LCG shuffle, so that runs compare.
+            uint32_t state = 12345;
+            for (size_t t = order.size() - 1; t > 0; --t) {
+                state = state * 1664525u + 1013904223u;
+                std::swap(order[t], order[state % (t + 1)]);
+            }
+            for (uint32_t t : order) {
+                mesh.Indices.insert(mesh.Indices.end(), sphere.Indices32.begin() + 3 * t, sphere.Indices32.begin() + 3 * t + 3);
+            }
+            meshes.emplace_back("shuffled sphere", std::move(mesh));
+        }
+
+        for (const auto& [meshName, source] : meshes) {
+            const size_t vertexCount = source.VertexCount();
+
+            std::vector<uint32_t> cacheOrder = source.Indices;
+            MeshOptimize::OptimizeVertexCache(cacheOrder, vertexCount);
+            std::vector<uint32_t> overdrawOrder = cacheOrder;
+            MeshOptimize::OptimizeOverdraw(overdrawOrder, source.Positions);
+
+            if (CanonicalTriangles(cacheOrder) != CanonicalTriangles(source.Indices) ||
+                CanonicalTriangles(overdrawOrder) != CanonicalTriangles(source.Indices)) {
+                printf("%-36s FAILED, %s lost or changed triangles\n", "MeshOptimize", meshName.c_str());
+            }
+
+            PrintCacheStats((meshName + " as loaded").c_str(), source.Indices, vertexCount);
+            PrintCacheStats((meshName + " vertex cache").c_str(), cacheOrder, vertexCount);
+            PrintCacheStats((meshName + " + overdraw").c_str(), overdrawOrder, vertexCount);
+
+            std::string name = "OptimizeVertexCache " + meshName;
+            Run(name.c_str(), 10, [&]() {
+                std::vector<uint32_t> indices = source.Indices;
+                MeshOptimize::OptimizeVertexCache(indices, vertexCount);
+                return indices.size() / 3;
+            });
+            name = "OptimizeOverdraw " + meshName;
+            Run(name.c_str(), 10, [&]() {
+                std::vector<uint32_t> indices = cacheOrder;
+                MeshOptimize::OptimizeOverdraw(indices, source.Positions);
+                return indices.size() / 3;
+            });
+            name = "MeshImport::Optimize " + meshName;
+            Run(name.c_str(), 10, [&]() {
+                MeshImport::SourceMesh mesh = source;
+                MeshImport::Optimize(mesh);
+                return mesh.VertexCount();
+            });
+        }
+    }
+
+    // Whether meshlets cover the triangle list exactly, in order, within the
+    // limits, with spheres that hold their vertices, and whether their cones
+    // only cull meshlets whose triangles all face away from the eyes given.
+    bool CheckMeshlets(
+        const Meshlets::MeshletData& meshlets, const MeshImport::SourceMesh& mesh, const std::vector<DirectX::XMFLOAT3>& eyes
+    ) {
+        using namespace DirectX;
+
+        std::vector<uint32_t> indices;
+        for (size_t m = 0; m < meshlets.Meshlets.size(); ++m) {
+            const Meshlets::Meshlet& meshlet = meshlets.Meshlets[m];
+            const Meshlets::Bounds& bounds = meshlets.MeshletBounds[m];
+            if (meshlet.VertexCount > Meshlets::MaxVertices || meshlet.TriangleCount > Meshlets::MaxTriangles) {
+                return false;
+            }
+
+            for (uint32_t v = 0; v < meshlet.VertexCount; ++v) {
+                XMVECTOR p = XMLoadFloat3(&mesh.Positions[meshlets.Vertices[meshlet.VertexOffset + v]]);
+                float distance = XMVectorGetX(XMVector3Length(p - XMLoadFloat3(&bounds.Center)));
+                if (distance > bounds.Radius * 1.001f + 1e-5f) {
+                    return false;
+                }
+            }
+
+            for (uint32_t t = 0; t < meshlet.TriangleCount; ++t) {
+                uint32_t local[3];
+                Meshlets::UnpackTriangle(meshlets.Triangles[meshlet.TriangleOffset + t], local[0], local[1], local[2]);
+                for (uint32_t i : local) {
+                    indices.push_back(meshlets.Vertices[meshlet.VertexOffset + i]);
+                }
+            }
+
+            for (const XMFLOAT3& eyePosition : eyes) {
+                XMVECTOR eye = XMLoadFloat3(&eyePosition);
+                XMVECTOR view = XMVector3Normalize(XMLoadFloat3(&bounds.ConeApex) - eye);
+                if (bounds.ConeCutoff > 1.0f || XMVectorGetX(XMVector3Dot(view, XMLoadFloat3(&bounds.ConeAxis))) < bounds.ConeCutoff) {
+                    continue;
+                }
+                // Culled: every triangle must face away, up to rounding.
+                for (uint32_t t = 0; t < meshlet.TriangleCount; ++t) {
+                    uint32_t i0, i1, i2;
+                    Meshlets::UnpackTriangle(meshlets.Triangles[meshlet.TriangleOffset + t], i0, i1, i2);
+                    XMVECTOR p0 = XMLoadFloat3(&mesh.Positions[meshlets.Vertices[meshlet.VertexOffset + i0]]);
+                    XMVECTOR p1 = XMLoadFloat3(&mesh.Positions[meshlets.Vertices[meshlet.VertexOffset + i1]]);
+                    XMVECTOR p2 = XMLoadFloat3(&mesh.Positions[meshlets.Vertices[meshlet.VertexOffset + i2]]);
+                    XMVECTOR n = XMVector3Normalize(XMVector3Cross(p1 - p0, p2 - p0));
+                    if (XMVectorGetX(XMVector3Dot(n, XMVector3Normalize(p0 - eye))) < -1e-3f) {
+                        return false;
+                    }
+                }
+            }
+        }
+
+        return indices == mesh.Indices;
+    }
+
+    // Builds meshlets and culls them on the CPU, against the whole-mesh bounds
+    // that a SubmeshGeometry would be culled with.
+    void BenchMeshlets(const std::filesystem::path& assets) {
+        using namespace DirectX;
+
+        std::vector<std::pair<std::string, MeshImport::SourceMesh>> meshes;
+        MeshImport::SourceMesh skull;
+        if (MeshImport::LoadText((assets / "skull.txt").string(), skull)) {
+            meshes.emplace_back("skull", std::move(skull));
+        }
+        {
+            GeometryGenerator geoGen;
+            GeometryGenerator::MeshData sphere = geoGen.CreateSphere(10.0f, 256, 256);
+            MeshImport::SourceMesh mesh;
+            for (const auto& v : sphere.Vertices) {
+                mesh.Positions.push_back(v.Position);
+            }
+            mesh.Indices = sphere.Indices32;
+            meshes.emplace_back("sphere", std::move(mesh));
+        }
+
+        for (auto& [meshName, mesh] : meshes) {
+            MeshImport::Optimize(mesh);
+
+            XMFLOAT3 center, extents;
+            MeshImport::ComputeBounds(mesh, center, extents);
+            const float size = XMVectorGetX(XMVector3Length(XMLoadFloat3(&extents)));
+
+            // Eyes around the mesh at two distances, looking at its center.
+            std::vector<XMFLOAT3> eyes;
+            for (int i = 0; i < 16; ++i) {
+                float angle = Math::Pi * 2.0f * i / 16;
+                float distance = size * (i % 2 == 0 ? 1.5f : 4.0f);
+                eyes.push_back(XMFLOAT3(
+                    center.x + distance * cosf(angle), center.y + 0.3f * distance, center.z + distance * sinf(angle)
+                ));
+            }
+
+            Meshlets::MeshletData meshlets;
+            std::string name = "Meshlets::Build " + meshName;
+            Run(name.c_str(), 10, [&]() {
+                Meshlets::Build(mesh.Indices, mesh.Positions, meshlets);
+                return meshlets.Meshlets.size();
+            });
+
+            if (!CheckMeshlets(meshlets, mesh, eyes)) {
+                printf("%-36s FAILED, %s meshlets are wrong\n", "Meshlets", meshName.c_str());
+            }
+
+            size_t fullVertices = 0;
+            for (const auto& meshlet : meshlets.Meshlets) {
+                fullVertices += meshlet.VertexCount;
+            }
+            printf("%-36s %zu meshlets, %.1f triangles and %.1f vertices each\n", (meshName + " meshlets").c_str(),
+                meshlets.Meshlets.size(), double(mesh.Indices.size() / 3) / meshlets.Meshlets.size(),
+                double(fullVertices) / meshlets.Meshlets.size());
+
+            // A 45 degree camera at each eye; the mesh's box is always in view,
+            // so culling per submesh draws everything.
+            size_t frustumVisible = 0;
+            size_t coneVisible = 0;
+            std::vector<uint32_t> visible;
+            for (const XMFLOAT3& eyePosition : eyes) {
+                XMVECTOR eye = XMLoadFloat3(&eyePosition);
+                XMMATRIX view = XMMatrixLookAtLH(eye, XMLoadFloat3(&center), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+                BoundingFrustum frustum(XMMatrixPerspectiveFovLH(0.25f * Math::Pi, 16.0f / 9.0f, 0.1f, 1000.0f * size));
+                frustum.Transform(frustum, XMMatrixInverse(nullptr, view));
+
+                visible.clear();
+                frustumVisible += Meshlets::Cull(meshlets.MeshletBounds.data(), meshlets.MeshletBounds.size(), frustum, eye, false, visible);
+                visible.clear();
+                coneVisible += Meshlets::Cull(meshlets.MeshletBounds.data(), meshlets.MeshletBounds.size(), frustum, eye, true, visible);
+            }
+            printf("%-36s frustum %.1f%%, frustum + cone %.1f%% of meshlets drawn\n", (meshName + " culling").c_str(),
+                100.0 * frustumVisible / (eyes.size() * meshlets.Meshlets.size()),
+                100.0 * coneVisible / (eyes.size() * meshlets.Meshlets.size()));
+
+            XMVECTOR eye = XMLoadFloat3(&eyes[0]);
+            XMMATRIX view = XMMatrixLookAtLH(eye, XMLoadFloat3(&center), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+            BoundingFrustum frustum(XMMatrixPerspectiveFovLH(0.25f * Math::Pi, 16.0f / 9.0f, 0.1f, 1000.0f * size));
+            frustum.Transform(frustum, XMMatrixInverse(nullptr, view));
+            name = "Meshlets::Cull " + meshName;
+            Run(name.c_str(), 100, [&]() {
+                visible.clear();
+                return Meshlets::Cull(meshlets.MeshletBounds.data(), meshlets.MeshletBounds.size(), frustum, eye, true, visible);
+            });
+        }
+    }
+
+    // Vertices on open borders, as positions that are the first vertex of an
+    // edge that no triangle runs along the other way.
+    std::vector<std::array<float, 3>> BorderPositions(const std::vector<uint32_t>& indices, const std::vector<DirectX::XMFLOAT3>& positions) {
+        auto position = [&](uint32_t v) {
+            return std::array<float, 3>{ positions[v].x, positions[v].y, positions[v].z };
+        };
+        std::vector<std::array<std::array<float, 3>, 2>> edges;
+        for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+            for (int e = 0; e < 3; ++e) {
+                edges.push_back({ position(indices[i + e]), position(indices[i + (e + 1) % 3]) });
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+
+        std::vector<std::array<float, 3>> border;
+        for (const auto& edge : edges) {
+            if (!std::binary_search(edges.begin(), edges.end(), std::array<std::array<float, 3>, 2>{ edge[1], edge[0] })) {
+                border.push_back(edge[0]);
+            }
+        }
+        std::sort(border.begin(), border.end());
+        border.erase(std::unique(border.begin(), border.end()), border.end());
+        return border;
+    }
+
+    // Whether a level of detail indexes the mesh's vertices with no
+    // degenerate triangles, has fewer triangles than the mesh, and keeps every
+    // border vertex of the mesh on a border.
+    bool CheckLod(const MeshImport::SourceMesh& mesh, const std::vector<uint32_t>& indices) {
+        if (indices.size() % 3 != 0 || indices.size() >= mesh.Indices.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < indices.size(); i += 3) {
+            for (int c = 0; c < 3; ++c) {
+                if (indices[i + c] >= mesh.VertexCount()) {
+                    return false;
+                }
+            }
+            if (indices[i] == indices[i + 1] || indices[i + 1] == indices[i + 2] || indices[i + 2] == indices[i]) {
+                return false;
+            }
+        }
+
+        std::vector<std::array<float, 3>> before = BorderPositions(mesh.Indices, mesh.Positions);
+        std::vector<std::array<float, 3>> after = BorderPositions(indices, mesh.Positions);
+        return std::includes(after.begin(), after.end(), before.begin(), before.end());
+    }
+
+    // LOD chains of closed meshes with normals (the skull, the car), and of
+    // meshes with texture seams and an open border (a sphere, a grid).
+    void BenchMeshSimplify(const std::filesystem::path& assets) {
+        std::vector<std::pair<std::string, MeshImport::SourceMesh>> meshes;
+        for (const char* model : { "skull.txt", "car.txt" }) {
+            MeshImport::SourceMesh mesh;
+            if (MeshImport::LoadText((assets / model).string(), mesh)) {
+                meshes.emplace_back(std::filesystem::path(model).stem().string(), std::move(mesh));
+            }
+        }
+        {
+            GeometryGenerator geoGen;
+            for (auto& [meshName, generated] : {
+                std::make_pair(std::string("sphere"), geoGen.CreateSphere(1.0f, 128, 128)),
+                std::make_pair(std::string("grid"), geoGen.CreateGrid(10.0f, 10.0f, 128, 128))
+            }) {
+                MeshImport::SourceMesh mesh;
+                for (const auto& v : generated.Vertices) {
+                    mesh.Positions.push_back(v.Position);
+                    mesh.Normals.push_back(v.Normal);
+                    mesh.TexCoords.push_back(v.TexC);
+                }
+                mesh.Indices = generated.Indices32;
+                meshes.emplace_back(meshName, std::move(mesh));
+            }
+        }
+
+        for (auto& [meshName, mesh] : meshes) {
+            MeshImport::Optimize(mesh);
+
+            std::vector<MeshSimplify::Lod> lods;
+            std::string name = "MeshImport::BuildLods " + meshName;
+            Run(name.c_str(), 3, [&]() {
+                lods = MeshImport::BuildLods(mesh, 4);
+                return lods.size();
+            });
+
+            printf("%-36s %zu", (meshName + " LOD triangles (error)").c_str(), mesh.Indices.size() / 3);
+            for (const MeshSimplify::Lod& lod : lods) {
+                printf(" -> %zu (%.3g)", lod.Indices.size() / 3, lod.Error);
+            }
+            printf("\n");
+
+            for (size_t i = 0; i < lods.size(); ++i) {
+                if (!CheckLod(mesh, lods[i].Indices) || (i > 0 && lods[i].Error < lods[i - 1].Error)) {
+                    printf("%-36s FAILED, %s LOD %zu is wrong\n", "MeshSimplify", meshName.c_str(), i + 1);
+                }
+            }
+        }
+    }
+
+    // Packed vertices of the text meshes and of a sphere, checked against the
+    // precision of each format: half a snorm16 step of the bounds for
+    // positions, a hundredth of a degree for directions, and half an ulp of
+    // a half for texture coordinates.
+    void BenchVertexQuantize(const std::filesystem::path& assets) {
+        bool exact =
+            VertexQuantize::EncodeSnorm16(1.0f) == 32767 && VertexQuantize::EncodeSnorm16(-1.0f) == -32767 &&
+            VertexQuantize::EncodeSnorm16(0.0f) == 0 && VertexQuantize::DecodeSnorm16(-32768) == -1.0f;
+        for (DirectX::XMFLOAT3 axis : {
+            DirectX::XMFLOAT3(1.0f, 0.0f, 0.0f), DirectX::XMFLOAT3(0.0f, -1.0f, 0.0f),
+            DirectX::XMFLOAT3(0.0f, 0.0f, 1.0f), DirectX::XMFLOAT3(0.0f, 0.0f, -1.0f)
+        }) {
+            int16_t encoded[2];
+            VertexQuantize::EncodeOctahedral(axis, encoded);
+            DirectX::XMFLOAT3 decoded = VertexQuantize::DecodeOctahedral(encoded);
+            exact = exact && decoded.x == axis.x && decoded.y == axis.y && decoded.z == axis.z;
+        }
+        if (!exact) {
+            printf("%-36s FAILED, exact values don't round-trip\n", "VertexQuantize");
+        }
+
+        std::vector<std::pair<std::string, MeshCache::MeshData>> meshes;
+        for (const char* model : { "skull", "car" }) {
+            MeshCache::MeshData mesh;
+            if (MeshCache::LoadTextMesh((assets / (std::string(model) + ".txt")).string(), mesh)) {
+                meshes.emplace_back(model, std::move(mesh));
+            }
+        }
+        {
+            GeometryGenerator geoGen;
+            GeometryGenerator::MeshData sphere = geoGen.CreateSphere(3.0f, 256, 256);
+            MeshCache::MeshData mesh;
+            for (const auto& v : sphere.Vertices) {
+                mesh.Vertices.push_back({ v.Position, v.Normal, v.TexC, v.TangentU });
+            }
+            mesh.BoundsExtents = { 3.0f, 3.0f, 3.0f };
+            meshes.emplace_back("sphere", std::move(mesh));
+        }
+
+        for (auto& [meshName, mesh] : meshes) {
+            VertexQuantize::Bounds bounds;
+            bounds.Center = mesh.BoundsCenter;
+            bounds.Extents = mesh.BoundsExtents;
+
+            std::vector<VertexQuantize::PackedVertex> packed(mesh.Vertices.size());
+            std::string name = "VertexQuantize::Encode " + meshName;
+            Run(name.c_str(), 20, [&]() {
+                VertexQuantize::Encode(mesh.Vertices.data(), mesh.Vertices.size(), bounds, packed.data());
+                return packed.size();
+            });
+
+            VertexQuantize::ErrorStats error =
+                VertexQuantize::MeasureError(mesh.Vertices.data(), mesh.Vertices.size(), bounds, packed.data());
+            printf("%-36s %zu -> %zu bytes, position %.3g, normal %.3g deg, tangent %.3g deg, texC %.3g\n",
+                (meshName + " packed error").c_str(),
+                mesh.Vertices.size() * sizeof(MeshCache::Vertex), packed.size() * sizeof(VertexQuantize::PackedVertex),
+                error.Position, error.Normal, error.Tangent, error.TexC);
+
+            float extents = DirectX::XMVectorGetX(DirectX::XMVector3Length(DirectX::XMLoadFloat3(&bounds.Extents)));
+            float maxTexC = 1.0f;
+            for (const auto& v : mesh.Vertices) {
+                maxTexC = std::max({ maxTexC, fabsf(v.TexC.x), fabsf(v.TexC.y) });
+            }
+            if (error.Position > extents * (0.5f / 32767.0f) * 1.001f + 1e-6f ||
+                error.Normal > 0.01f || error.Tangent > 0.01f || error.TexC > maxTexC / 2048.0f) {
+                printf("%-36s FAILED, %s packed vertices are off\n", "VertexQuantize", meshName.c_str());
+            }
+        }
+    }
+
+    void BenchVertexStreams(const std::filesystem::path& assets) {
+        MeshCache::MeshData mesh;
+        if (!MeshCache::LoadTextMesh((assets / "skull.txt").string(), mesh)) {
+            GeometryGenerator geoGen;
+            GeometryGenerator::MeshData sphere = geoGen.CreateSphere(3.0f, 256, 256);
+            for (const auto& v : sphere.Vertices) {
+                mesh.Vertices.push_back({ v.Position, v.Normal, v.TexC, v.TangentU });
+            }
+            mesh.BoundsExtents = { 3.0f, 3.0f, 3.0f };
+        }
+        const uint32_t count = static_cast<uint32_t>(mesh.Vertices.size());
+
+        VertexQuantize::Bounds bounds;
+        bounds.Center = mesh.BoundsCenter;
+        bounds.Extents = mesh.BoundsExtents;
+        std::vector<VertexQuantize::PackedVertex> packed(count);
+        VertexQuantize::Encode(mesh.Vertices.data(), count, bounds, packed.data());
+
+        for (bool isPacked : { true, false }) {
+            VertexStreams::Layout interleaved = VertexStreams::Interleaved(count, isPacked);
+            VertexStreams::Layout split = VertexStreams::Split(count, isPacked);
+            const void* src = isPacked ? static_cast<const void*>(packed.data()) : mesh.Vertices.data();
+            const size_t srcSize = count * (isPacked ? sizeof(VertexQuantize::PackedVertex) : sizeof(MeshCache::Vertex));
+
+            std::vector<uint8_t> streams(VertexStreams::BufferSize(split));
+            std::string name = std::string("VertexStreams::Copy ") + (isPacked ? "packed" : "float");
+            Run(name.c_str(), 20, [&]() {
+                VertexStreams::Copy(src, interleaved, count, split, streams.data());
+                return streams.size();
+            });
+            printf("%-36s %zu -> %zu bytes, position stream %llu bytes\n",
+                (std::string("skull streams ") + (isPacked ? "packed" : "float")).c_str(),
+                srcSize, streams.size(), (unsigned long long)split.Streams[VertexStreams::Position].Size);
+
+            // Every stream aligned, tight, inside the buffer and apart from
+            // the others, and every interleaved stream inside the vertices.
+            bool valid = VertexStreams::BufferSize(interleaved) <= srcSize;
+            for (uint32_t a = 0; a < VertexStreams::AttributeCount; ++a) {
+                const VertexStreams::Stream& stream = split.Streams[a];
+                valid = valid && stream.Offset % VertexStreams::StreamAlignment == 0 &&
+                    stream.Stride == VertexStreams::FormatSize(stream.Format) &&
+                    stream.Size == uint64_t(count) * stream.Stride &&
+                    stream.Format == interleaved.Streams[a].Format &&
+                    (a == 0 || stream.Offset >= split.Streams[a - 1].Offset + split.Streams[a - 1].Size);
+            }
+
+            // Each element of a stream is the bytes of its attribute in the
+            // interleaved vertex.
+            for (uint32_t a = 0; valid && a < VertexStreams::AttributeCount; ++a) {
+                const VertexStreams::Stream& from = interleaved.Streams[a];
+                const VertexStreams::Stream& to = split.Streams[a];
+                for (uint32_t i = 0; valid && i < count; ++i) {
+                    valid = memcmp(
+                        streams.data() + to.Offset + uint64_t(i) * to.Stride,
+                        static_cast<const uint8_t*>(src) + from.Offset + uint64_t(i) * from.Stride, to.Stride
+                    ) == 0;
+                }
+            }
+
+            std::vector<VertexStreams::InputElement> shadow =
+                VertexStreams::InputLayout(isPacked, VertexStreams::PositionBit | VertexStreams::TexCBit);
+            valid = valid && shadow.size() == 2 &&
+                shadow[0].InputSlot == VertexStreams::Position && shadow[0].Format == split.Streams[VertexStreams::Position].Format &&
+                shadow[1].InputSlot == VertexStreams::TexC && shadow[1].Format == split.Streams[VertexStreams::TexC].Format;
+
+            if (!valid || VertexStreams::Copy(src, interleaved, count, VertexStreams::Split(count, !isPacked), streams.data())) {
+                printf("%-36s FAILED, %s streams don't match the vertices\n", "VertexStreams", isPacked ? "packed" : "float");
+            }
+        }
+    }
+
+    // Largest angle in degrees between the generated tangents and the
+    // analytic ones of a GeometryGenerator mesh.
+    float MaxTangentError(const GeometryGenerator::MeshData& generated) {
+        MeshImport::SourceMesh mesh;
+        for (const auto& v : generated.Vertices) {
+            mesh.Positions.push_back(v.Position);
+            mesh.Normals.push_back(v.Normal);
+            mesh.TexCoords.push_back(v.TexC);
+        }
+        mesh.Indices = generated.Indices32;
+        MeshImport::GenerateTangents(mesh);
+
+        float minCos = 1.0f;
+        for (size_t i = 0; i < generated.Vertices.size(); ++i) {
+            DirectX::XMVECTOR expected = DirectX::XMVector3Normalize(DirectX::XMLoadFloat3(&generated.Vertices[i].TangentU));
+            DirectX::XMVECTOR actual = DirectX::XMLoadFloat3(&mesh.Tangents[i]);
+            minCos = std::min(minCos, DirectX::XMVectorGetX(DirectX::XMVector3Dot(expected, actual)));
+        }
+        return DirectX::XMConvertToDegrees(acosf(std::min(minCos, 1.0f)));
+    }
+
+    void BenchTangents(const std::filesystem::path& assets) {
+        GeometryGenerator geoGen;
+
+        // The poles of a sphere have no well-defined tangent; the cylinder's
+        // caps and sides share no vertices, so it checks seams too.
+        printf("%-36s grid %.3f, cylinder %.3f degrees\n", "GenerateTangents max error",
+            MaxTangentError(geoGen.CreateGrid(10.0f, 10.0f, 64, 64)),
+            MaxTangentError(geoGen.CreateCylinder(1.0f, 0.5f, 3.0f, 64, 16)));
+
+        // Sponza.bin is not in the repo; BoomBox stands in when it's missing.
+        for (const char* model : { "Sponza/Sponza.gltf", "BoomBox/BoomBox.gltf" }) {
+            std::string filename = (assets / model).generic_string();
+            GLTFLoader loader(filename);
+            if (!std::filesystem::exists(filename) || !loader.LoadModel()) {
+                printf("%-36s skipped, %s failed to load\n", "GenerateTangents", filename.c_str());
+                continue;
+            }
+
+            std::vector<GLTFSceneMeshData> sceneMeshes = loader.LoadScene();
+            std::vector<MeshImport::SourceMesh> primitives(sceneMeshes.size());
+            for (size_t i = 0; i < sceneMeshes.size(); ++i) {
+                MeshImport::FromGLTF(sceneMeshes[i].data, primitives[i]);
+            }
+
+            std::string name = std::string("GenerateTangents ") + std::filesystem::path(filename).filename().string();
+            Run(name.c_str(), 20, [&]() {
+                size_t vertexCount = 0;
+                for (auto& primitive : primitives) {
+                    MeshImport::GenerateTangents(primitive);
+                    vertexCount += primitive.VertexCount();
+                }
+                return vertexCount;
+            });
+        }
+
+        GeometryGenerator::MeshData sphere = geoGen.CreateSphere(1.0f, 1024, 1024);
+        MeshImport::SourceMesh mesh;
+        for (const auto& v : sphere.Vertices) {
+            mesh.Positions.push_back(v.Position);
+            mesh.Normals.push_back(v.Normal);
+            mesh.TexCoords.push_back(v.TexC);
+        }
+        mesh.Indices = sphere.Indices32;
+
+        Run("GenerateTangents sphere 1M", 5, [&]() {
+            MeshImport::GenerateTangents(mesh);
+            return mesh.VertexCount();
+        });
+    }
+
+    // The ifstream parser that MeshCache::LoadTextMesh replaced, kept as the
+    // baseline for BenchTextMeshParser.
+    bool LoadTextMeshIfstream(const std::string& filename, MeshCache::MeshData& mesh) {
+        using namespace DirectX;
+
+        std::ifstream fin(filename);
+        if (!fin) {
+            return false;
+        }
+
+        uint32_t vcount = 0;
+        uint32_t tcount = 0;
+        std::string ignore;
+
+        fin >> ignore >> vcount;
+        fin >> ignore >> tcount;
+        fin >> ignore >> ignore >> ignore >> ignore;
+
+        XMFLOAT3 vMinf3(+Math::Infinity, +Math::Infinity, +Math::Infinity);
+        XMFLOAT3 vMaxf3(-Math::Infinity, -Math::Infinity, -Math::Infinity);
+
+        XMVECTOR vMin = XMLoadFloat3(&vMinf3);
+        XMVECTOR vMax = XMLoadFloat3(&vMaxf3);
+
+        mesh.Vertices.resize(vcount);
+        for (uint32_t i = 0; i < vcount; ++i) {
+            MeshCache::Vertex& v = mesh.Vertices[i];
+            fin >> v.Pos.x >> v.Pos.y >> v.Pos.z;
+            fin >> v.Normal.x >> v.Normal.y >> v.Normal.z;
+
+            v.TexC = { 0.0f, 0.0f };
+
+            XMVECTOR N = XMLoadFloat3(&v.Normal);
+            XMVECTOR up = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+            if (fabsf(XMVectorGetX(XMVector3Dot(N, up))) < 1.0f - 0.001f) {
+                XMStoreFloat3(&v.TangentU, XMVector3Normalize(XMVector3Cross(up, N)));
+            } else {
+                up = XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f);
+                XMStoreFloat3(&v.TangentU, XMVector3Normalize(XMVector3Cross(N, up)));
+            }
+
+            XMVECTOR P = XMLoadFloat3(&v.Pos);
+            vMin = XMVectorMin(vMin, P);
+            vMax = XMVectorMax(vMax, P);
+        }
+
+        XMStoreFloat3(&mesh.BoundsCenter, 0.5f*(vMin + vMax));
+        XMStoreFloat3(&mesh.BoundsExtents, 0.5f*(vMax - vMin));
+
+        fin >> ignore;
+        fin >> ignore;
+        fin >> ignore;
+
+        mesh.Indices.resize(3 * size_t(tcount));
+        for (uint32_t i = 0; i < tcount; ++i) {
+            fin >> mesh.Indices[i * 3 + 0] >> mesh.Indices[i * 3 + 1] >> mesh.Indices[i * 3 + 2];
+        }
+
+        return !fin.fail();
+    }
+
+    // Writes a grid of about 2M vertices and 4M triangles in the car.txt
+    // format, with the same 6 significant digits as the assets.
+    bool WriteSyntheticTextMesh(const std::string& filename) {
+        GeometryGenerator geoGen;
+        GeometryGenerator::MeshData grid = geoGen.CreateGrid(160.0f, 160.0f, 1415, 1415);
+
+        FILE* file = fopen(filename.c_str(), "w");
+        if (!file) {
+            return false;
+        }
+
+        fprintf(file, "VertexCount: %zu\n", grid.Vertices.size());
+        fprintf(file, "TriangleCount: %zu\n", grid.Indices32.size() / 3);
+        fprintf(file, "VertexList (pos, normal)\n{\n");
+        for (const auto& v : grid.Vertices) {
+            // Bend the normals so that they aren't all the same few strings.
+            float y = 0.3f*(v.Position.z*sinf(0.1f*v.Position.x) + v.Position.x*cosf(0.1f*v.Position.z));
+            float nx = -0.03f*v.Position.z*cosf(0.1f*v.Position.x);
+            float nz = 0.03f*v.Position.x*sinf(0.1f*v.Position.z);
+            float invLength = 1.0f / sqrtf(nx*nx + 1.0f + nz*nz);
+            fprintf(file, "\t%g %g %g %g %g %g\n", v.Position.x, y, v.Position.z, nx*invLength, invLength, nz*invLength);
+        }
+        fprintf(file, "}\nTriangleList\n{\n");
+        for (size_t i = 0; i < grid.Indices32.size(); i += 3) {
+            fprintf(file, "\t%u %u %u\n", grid.Indices32[i], grid.Indices32[i + 1], grid.Indices32[i + 2]);
+        }
+        fprintf(file, "}\n");
+
+        return fclose(file) == 0;
+    }
+
+    // MeshCache::LoadTextMesh reorders what it parses with MeshImport::Optimize,
+    // which only looks at positions and indices; applying it to the baseline's
+    // output makes the two comparable.
+    void Reorder(MeshCache::MeshData& mesh) {
+        MeshImport::SourceMesh source;
+        for (const auto& v : mesh.Vertices) {
+            source.Positions.push_back(v.Pos);
+            source.Normals.push_back(v.Normal);
+            source.TexCoords.push_back(v.TexC);
+            source.Tangents.push_back(v.TangentU);
+        }
+        source.Indices = mesh.Indices;
+
+        MeshImport::Optimize(source);
+
+        for (size_t i = 0; i < mesh.Vertices.size(); ++i) {
+            mesh.Vertices[i] = { source.Positions[i], source.Normals[i], source.TexCoords[i], source.Tangents[i] };
+        }
+        mesh.Indices = source.Indices;
+    }
+
+    bool SameMesh(const MeshCache::MeshData& a, const MeshCache::MeshData& b) {
+        return
+            a.Vertices.size() == b.Vertices.size() &&
+            a.Indices == b.Indices &&
+            memcmp(a.Vertices.data(), b.Vertices.data(), a.Vertices.size() * sizeof(MeshCache::Vertex)) == 0 &&
+            memcmp(&a.BoundsCenter, &b.BoundsCenter, sizeof(a.BoundsCenter)) == 0 &&
+            memcmp(&a.BoundsExtents, &b.BoundsExtents, sizeof(a.BoundsExtents)) == 0;
+    }
+
+    void BenchTextMeshParser() {
+        std::string filename = (std::filesystem::temp_directory_path() / "synthetic.txt").string();
+        if (!WriteSyntheticTextMesh(filename)) {
+            printf("%-36s skipped, failed to write %s\n", "TextMeshParser", filename.c_str());
+            return;
+        }
+
+        MeshCache::MeshData expected;
+        MeshCache::MeshData actual;
+        bool loaded = LoadTextMeshIfstream(filename, expected) && MeshCache::LoadTextMesh(filename, actual);
+        if (loaded) {
+            Reorder(expected);
+        }
+        if (!loaded || !SameMesh(expected, actual)) {
+            printf("%-36s FAILED, parsers disagree on %s\n", "TextMeshParser", filename.c_str());
+        }
+
+        Run("TextMesh ifstream synthetic", 3, [&]() {
+            MeshCache::MeshData mesh;
+            LoadTextMeshIfstream(filename, mesh);
+            return mesh.Vertices.size();
+        });
+        Run("TextMesh from_chars synthetic", 3, [&]() {
+            MeshCache::MeshData mesh;
+            MeshCache::LoadTextMesh(filename, mesh);
+            return mesh.Vertices.size();
+        });
+
+        // Corrupt files are rejected before anything indexes or allocates
+        // with them: a triangle past the last vertex, and counts that the
+        // file is too small to hold.
+        const char* corrupt[] = {
+            "VertexCount: 3\nTriangleCount: 1\nVertexList (pos, normal)\n{\n"
+            "0 0 0 0 1 0\n1 0 0 0 1 0\n0 0 1 0 1 0\n}\nTriangleList\n{\n0 1 3\n}\n",
+            "VertexCount: 4000000000\nTriangleCount: 1\nVertexList (pos, normal)\n{\n}\n",
+            "VertexCount: 3\nTriangleCount: 4000000000\nVertexList (pos, normal)\n{\n"
+            "0 0 0 0 1 0\n1 0 0 0 1 0\n0 0 1 0 1 0\n}\nTriangleList\n{\n}\n",
+        };
+        for (const char* text : corrupt) {
+            {
+                std::ofstream fout(filename, std::ios::binary);
+                fout << text;
+            }
+            MeshImport::SourceMesh mesh;
+            if (MeshImport::LoadText(filename, mesh)) {
+                printf("%-36s FAILED, loaded a corrupt mesh\n", "TextMeshParser");
+            }
+        }
+
+        std::filesystem::remove(filename);
+    }
+
+    // Whether two simulations are at bit-identical heights, normals and
+    // tangents.
+    bool SameWaves(const Waves& a, const Waves& b) {
+        if (a.VertexCount() != b.VertexCount()) {
+            return false;
+        }
+        for (int i = 0; i < a.VertexCount(); ++i) {
+            XMFLOAT3 pa = a.Position(i), pb = b.Position(i);
+            XMFLOAT3 na = a.Normal(i), nb = b.Normal(i);
+            XMFLOAT3 ta = a.TangentX(i), tb = b.TangentX(i);
+            if (memcmp(&pa, &pb, sizeof(pa)) != 0 || memcmp(&na, &nb, sizeof(na)) != 0 ||
+                memcmp(&ta, &tb, sizeof(ta)) != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void BenchWaves() {
+        const float timeStep = 0.03f;
+
+        // Every mode steps to the same state as the two sweeps, on grids
+        // that bands don't divide evenly and for step counts that leave a
+        // partial block.
+        struct Mode { const char* name; bool fused; int substeps; };
+        const Mode modes[] = { { "two sweeps", false, 1 }, { "fused", true, 1 }, { "blocked x4", true, 4 } };
+        for (int size : { 37, 130 }) {
+            for (int bandRows : { 1, 5, 32 }) {
+                std::vector<std::unique_ptr<Waves>> runs;
+                for (const Mode& mode : modes) {
+                    runs.push_back(std::make_unique<Waves>(size, size + 3, 1.0f, timeStep, 4.0f, 0.2f));
+                    runs.back()->SetFusedUpdate(mode.fused);
+                    runs.back()->SetTemporalBlocking(mode.substeps);
+                    runs.back()->SetTileSize(bandRows, 16);
+                    runs.back()->Disturb(size / 2, size / 3, 1.0f);
+                    runs.back()->Disturb(size / 4, size / 2, -0.5f);
+                }
+                for (int steps : { 1, 3, 4, 7 }) {
+                    for (auto& run : runs) {
+                        run->Step(steps);
+                    }
+                    for (size_t m = 1; m < runs.size(); ++m) {
+                        if (!SameWaves(*runs[0], *runs[m])) {
+                            printf("%-36s FAILED, %s differs from two sweeps on %dx%d, bands of %d, after Step(%d)\n",
+                                "Waves", modes[m].name, size, size + 3, bandRows, steps);
+                        }
+                    }
+                }
+            }
+        }
+
+        // 10 s of 60 Hz frames take 10 / 0.03 whole steps, and a 1 s hitch
+        // takes no more than the 4 steps of the default cap.
+        {
+            Waves waves(37, 37, 1.0f, timeStep, 4.0f, 0.2f);
+            waves.Disturb(18, 18, 1.0f);
+            int steps = 0;
+            bool valid = true;
+            for (int frame = 0; frame < 600; ++frame) {
+                steps += waves.Update(1.0f / 60.0f);
+                float t = waves.InterpolationFactor();
+                valid = valid && t >= 0.0f && t <= 1.0f;
+            }
+            int hitchSteps = waves.Update(1.0f);
+
+            // The ends of the blend are the two solutions.
+            std::vector<float> current(waves.VertexCount());
+            for (int i = 0; i < waves.VertexCount(); ++i) {
+                current[i] = waves.Position(i).y;
+                valid = valid && waves.InterpolatedPosition(i, 1.0f).y == current[i];
+            }
+            waves.Step(1);
+            for (int i = 0; i < waves.VertexCount(); ++i) {
+                valid = valid && waves.InterpolatedPosition(i, 0.0f).y == current[i];
+            }
+
+            if (steps != 333 || hitchSteps != 4 || !valid) {
+                printf("%-36s FAILED, Update took %d steps over 10 s and %d over a 1 s hitch\n", "Waves", steps, hitchSteps);
+            }
+        }
+
+        for (int size : { 128, 512, 1024 }) {
+            Waves waves(size, size, 1.0f, timeStep, 4.0f, 0.2f);
+            waves.Disturb(size / 2, size / 2, 1.0f);
+
+            ThreadPool::Default().ResetStats();
+
+            std::string name = "Waves::Update " + std::to_string(size) + "x" + std::to_string(size);
+            Run(name.c_str(), 100, [&]() {
+                waves.Update(timeStep);
+                return static_cast<size_t>(waves.VertexCount());
+            });
+
+            if (size == 1024) {
+                // 4 steps per frame, e.g. to raise the simulation rate.
+                for (const Mode& mode : modes) {
+                    waves.SetFusedUpdate(mode.fused);
+                    waves.SetTemporalBlocking(mode.substeps);
+
+                    std::string stepName = "Waves::Step(4) " + std::string(mode.name);
+                    Run(stepName.c_str(), 25, [&]() {
+                        waves.Step(4);
+                        return static_cast<size_t>(waves.VertexCount());
+                    });
+                }
+
+                // Same record as the Blending sample's Vertex.
+                struct Vertex { XMFLOAT3 Pos; XMFLOAT3 Normal; XMFLOAT2 TexC; XMFLOAT3 TangentU; };
+                std::vector<Vertex> vertices(waves.VertexCount());
+
+                Run("Waves per-vertex copy", 25, [&]() {
+                    for (int i = 0; i < waves.VertexCount(); ++i) {
+                        Vertex v;
+                        v.Pos = waves.Position(i);
+                        v.Normal = waves.Normal(i);
+                        v.TexC.x = 0.5f + v.Pos.x / waves.Width();
+                        v.TexC.y = 0.5f - v.Pos.z / waves.Depth();
+                        v.TangentU = waves.TangentX(i);
+                        memcpy(&vertices[i], &v, sizeof(Vertex));
+                    }
+                    return vertices.size();
+                });
+
+                Waves::VertexLayout layout;
+                layout.Stride = sizeof(Vertex);
+                layout.PositionOffset = offsetof(Vertex, Pos);
+                layout.NormalOffset = offsetof(Vertex, Normal);
+                layout.TexCOffset = offsetof(Vertex, TexC);
+                layout.TangentOffset = offsetof(Vertex, TangentU);
+                Run("Waves::WriteVertices", 25, [&]() {
+                    waves.WriteVertices(vertices.data(), layout);
+                    return vertices.size();
+                });
+
+                auto stats = ThreadPool::Default().GetStats();
+                for (size_t i = 0; i < stats.size(); ++i) {
+                    std::string worker = i + 1 < stats.size() ? "worker " + std::to_string(i) : "callers";
+                    printf("  %-10s tasks %8llu steals %8llu busy %8.3f s utilization %5.1f%%\n",
+                        worker.c_str(),
+                        static_cast<unsigned long long>(stats[i].tasks),
+                        static_cast<unsigned long long>(stats[i].steals),
+                        stats[i].busySeconds,
+                        stats[i].utilization * 100.0);
+                }
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    std::filesystem::path assets = argc > 1 ? argv[1] : "Assets";
+
+    printf("%-36s %8s %12s %12s %12s\n", "benchmark", "iters", "mean (ms)", "best (ms)", "work");
+
+    BenchGeometryGenerator();
+    BenchGLTF(assets);
+    BenchAccessorDecode();
+    BenchDDS(assets);
+    BenchMeshCache(assets);
+    BenchScenePack(assets);
+    BenchAssetLoader(assets);
+    BenchMeshImport(assets);
+    BenchMeshOptimize(assets);
+    BenchMeshlets(assets);
+    BenchMeshSimplify(assets);
+    BenchVertexQuantize(assets);
+    BenchVertexStreams(assets);
+    BenchTangents(assets);
+    BenchTextMeshParser();
+    BenchWaves();
+
+    return 0;
+}
@@ -4,6 +4,7 @@
 #include "../Common/GeometryGenerator.h"
 #include "../Common/DDSTextureLoader.h"
 #include "../Common/Camera.h"
+#include "../Common/MeshCache.h"
 #include "FrameResource.h"
 #include "RenderItem.h"
 #include "Waves.h"
@@ -409,86 +410,41 @@ void BlendingApp::BuildGeometry() {
 }
 
 void BlendingApp::BuildMainModelGeometry() {
-  std::ifstream fin("Assets/car.txt");
-
-  if (!fin) {
+  // The binary cache is built from the text mesh on first run, or when the
+  // text mesh changes, and memory-mapped after that.
+  MeshCache::File meshFile;
+  if (!MeshCache::OpenOrConvert("Assets/car.txt", "Assets/car.mesh", meshFile)) {
       MessageBox(0, L"Assets/car.txt not found.", 0, 0);
       return;
   }
 
-  UINT vcount = 0;
-  UINT tcount = 0;
-  std::string ignore;
-
-  fin >> ignore >> vcount;
-  fin >> ignore >> tcount;
-  fin >> ignore >> ignore >> ignore >> ignore;
-
-  XMFLOAT3 vMinf3(+Math::Infinity, +Math::Infinity, +Math::Infinity);
-  XMFLOAT3 vMaxf3(-Math::Infinity, -Math::Infinity, -Math::Infinity);
-
-  XMVECTOR vMin = XMLoadFloat3(&vMinf3);
-  XMVECTOR vMax = XMLoadFloat3(&vMaxf3);
-
-  std::vector<Vertex> vertices(vcount);
-  for (UINT i = 0; i < vcount; ++i) {
-    fin >> vertices[i].Pos.x >> vertices[i].Pos.y >> vertices[i].Pos.z;
-    fin >> vertices[i].Normal.x >> vertices[i].Normal.y >> vertices[i].Normal.z;
+  static_assert(sizeof(Vertex) == sizeof(MeshCache::Vertex), "Vertex must match the mesh cache layout");
 
-    vertices[i].TexC = { 0.0f, 0.0f };
-
-    XMVECTOR P = XMLoadFloat3(&vertices[i].Pos);
-
-    XMVECTOR N = XMLoadFloat3(&vertices[i].Normal);
-
-    XMVECTOR up = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
-    if(fabsf(XMVectorGetX(XMVector3Dot(N, up))) < 1.0f - 0.001f) {
-        XMVECTOR T = XMVector3Normalize(XMVector3Cross(up, N));
-        XMStoreFloat3(&vertices[i].TangentU, T);
-    } else {
-        up = XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f);
-        XMVECTOR T = XMVector3Normalize(XMVector3Cross(N, up));
-        XMStoreFloat3(&vertices[i].TangentU, T);
-    }
-    
-    vMin = XMVectorMin(vMin, P);
-    vMax = XMVectorMax(vMax, P);
-  }
+  const MeshCache::Header& header = meshFile.GetHeader();
 
   BoundingBox bounds;
-  XMStoreFloat3(&bounds.Center, 0.5f*(vMin + vMax));
-  XMStoreFloat3(&bounds.Extents, 0.5f*(vMax - vMin));
-
-  fin >> ignore;
-  fin >> ignore;
-  fin >> ignore;
-
-  std::vector<std::int32_t> indices(3 * tcount);
-  for (UINT i = 0; i < tcount; ++i) {
-      fin >> indices[i * 3 + 0] >> indices[i * 3 + 1] >> indices[i * 3 + 2];
-  }
+  bounds.Center = header.BoundsCenter;
+  bounds.Extents = header.BoundsExtents;
 
-  fin.close();
+  const UINT vbByteSize = (UINT)meshFile.VertexDataSize();
 
-  const UINT vbByteSize = (UINT)vertices.size() * sizeof(Vertex);
-
-  const UINT ibByteSize = (UINT)indices.size() * sizeof(std::int32_t);
+  const UINT ibByteSize = (UINT)meshFile.IndexDataSize();
 
   auto geo = std::make_unique<MeshGeometry>();
   geo->Name = "mainModelGeo";
 
   ThrowIfFailed(D3DCreateBlob(vbByteSize, &geo->VertexBufferCPU));
-  CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
+  CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), meshFile.VertexData(), vbByteSize);
 
   ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
-  CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
+  CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), meshFile.IndexData(), ibByteSize);
 
   geo->VertexBufferGPU = d3dUtil::CreateDefaultBuffer(
-    md3dDevice.Get(), mCommandList.Get(), vertices.data(), vbByteSize, geo->VertexBufferUploader
+    md3dDevice.Get(), mCommandList.Get(), meshFile.VertexData(), vbByteSize, geo->VertexBufferUploader
   );
 
   geo->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(
-    md3dDevice.Get(), mCommandList.Get(), indices.data(), ibByteSize, geo->IndexBufferUploader
+    md3dDevice.Get(), mCommandList.Get(), meshFile.IndexData(), ibByteSize, geo->IndexBufferUploader
   );
 
   geo->VertexByteStride = sizeof(Vertex);
@@ -497,7 +453,7 @@ void BlendingApp::BuildMainModelGeometry() {
   geo->IndexBufferByteSize = ibByteSize;
 
   SubmeshGeometry submesh;
-  submesh.IndexCount = (UINT)indices.size();
+  submesh.IndexCount = header.IndexCount;
   submesh.StartIndexLocation = 0;
   submesh.BaseVertexLocation = 0;
   submesh.Bounds = bounds;
@@ -774,18 +730,15 @@ void BlendingApp::UpdateWaves(const GameTimer& gt) {
 
 	mWaves->Update(gt.DeltaTime());
 
+	// Stream the solution straight into this frame's mapped vertex buffer.
 	auto currWavesVB = mCurrFrameResource->WavesVB.get();
-	for (int i = 0; i < mWaves->VertexCount(); ++i) {
-		Vertex v;
-
-		v.Pos = mWaves->Position(i);
-		v.Normal = mWaves->Normal(i);
-		
-		v.TexC.x = 0.5f + v.Pos.x / mWaves->Width();
-		v.TexC.y = 0.5f - v.Pos.z / mWaves->Depth();
-
-		currWavesVB->CopyData(i, v);
-	}
+	Waves::VertexLayout layout;
+	layout.Stride = currWavesVB->ElementByteSize();
+	layout.PositionOffset = offsetof(Vertex, Pos);
+	layout.NormalOffset = offsetof(Vertex, Normal);
+	layout.TexCOffset = offsetof(Vertex, TexC);
+	layout.TangentOffset = offsetof(Vertex, TangentU);
+	mWaves->WriteVertices(currWavesVB->MappedData(), layout);
 
 	mWavesRenderItem->Geo->VertexBufferGPU = currWavesVB->Resource();
 }
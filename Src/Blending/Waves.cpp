@@ -1,13 +1,149 @@
 // Waves.cpp by Frank Luna (C) 2011 All Rights Reserved.
 
 #include "Waves.h"
-#include <ppl.h>
+#include "../Common/ThreadPool.h"
 #include <algorithm>
 #include <vector>
 #include <cassert>
+#include <cmath>
+#include <cstring>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define WAVES_SIMD 1
+#define WAVES_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define WAVES_SIMD 1
+#define WAVES_SSE2 1
+#elif defined(__ARM_NEON) && (defined(__aarch64__) || defined(_M_ARM64))
+#include <arm_neon.h>
+#define WAVES_SIMD 1
+#define WAVES_NEON 1
+#else
+#define WAVES_SIMD 0
+#endif
 
 using namespace DirectX;
 
+namespace
+{
+    // Thin wrappers over the widest float vector the target was compiled for, so
+    // the row kernels below are written once. The repo's builds enable AVX2
+    // (/arch:AVX2 in d3d12.vcxproj, -mavx2 in CMake on x86-64) and process 8
+    // columns per instruction; builds without it use SSE2 or NEON and process 4.
+#if defined(WAVES_AVX)
+    using FloatV = __m256;
+    constexpr int kLanes = 8;
+    inline FloatV Load(const float* p) { return _mm256_loadu_ps(p); }
+    inline void Store(float* p, FloatV v) { _mm256_storeu_ps(p, v); }
+    inline FloatV Splat(float f) { return _mm256_set1_ps(f); }
+    inline FloatV Add(FloatV a, FloatV b) { return _mm256_add_ps(a, b); }
+    inline FloatV Sub(FloatV a, FloatV b) { return _mm256_sub_ps(a, b); }
+    inline FloatV Mul(FloatV a, FloatV b) { return _mm256_mul_ps(a, b); }
+    inline FloatV Div(FloatV a, FloatV b) { return _mm256_div_ps(a, b); }
+    inline FloatV Sqrt(FloatV a) { return _mm256_sqrt_ps(a); }
+#elif defined(WAVES_SSE2)
+    using FloatV = __m128;
+    constexpr int kLanes = 4;
+    inline FloatV Load(const float* p) { return _mm_loadu_ps(p); }
+    inline void Store(float* p, FloatV v) { _mm_storeu_ps(p, v); }
+    inline FloatV Splat(float f) { return _mm_set1_ps(f); }
+    inline FloatV Add(FloatV a, FloatV b) { return _mm_add_ps(a, b); }
+    inline FloatV Sub(FloatV a, FloatV b) { return _mm_sub_ps(a, b); }
+    inline FloatV Mul(FloatV a, FloatV b) { return _mm_mul_ps(a, b); }
+    inline FloatV Div(FloatV a, FloatV b) { return _mm_div_ps(a, b); }
+    inline FloatV Sqrt(FloatV a) { return _mm_sqrt_ps(a); }
+#elif defined(WAVES_NEON)
+    using FloatV = float32x4_t;
+    constexpr int kLanes = 4;
+    inline FloatV Load(const float* p) { return vld1q_f32(p); }
+    inline void Store(float* p, FloatV v) { vst1q_f32(p, v); }
+    inline FloatV Splat(float f) { return vdupq_n_f32(f); }
+    inline FloatV Add(FloatV a, FloatV b) { return vaddq_f32(a, b); }
+    inline FloatV Sub(FloatV a, FloatV b) { return vsubq_f32(a, b); }
+    inline FloatV Mul(FloatV a, FloatV b) { return vmulq_f32(a, b); }
+    inline FloatV Div(FloatV a, FloatV b) { return vdivq_f32(a, b); }
+    inline FloatV Sqrt(FloatV a) { return vsqrtq_f32(a); }
+#endif
+
+    // Advances columns [colBegin, colEnd) of one row of the height field. curr
+    // is the row at time t, up and down its neighbor rows; prev holds the row
+    // at t-1 on input and is overwritten with the row at t+1. Columns
+    // colBegin-1 and colEnd must exist.
+    void StepRow(float* prev, const float* curr, const float* up, const float* down,
+                 int colBegin, int colEnd, float k1, float k2, float k3)
+    {
+        int j = colBegin;
+
+#if WAVES_SIMD
+        const FloatV vk1 = Splat(k1);
+        const FloatV vk2 = Splat(k2);
+        const FloatV vk3 = Splat(k3);
+        for(; j + kLanes <= colEnd; j += kLanes)
+        {
+            FloatV neighbors = Add(Add(Add(Load(down + j), Load(up + j)), Load(curr + j + 1)), Load(curr + j - 1));
+            FloatV next = Add(Add(Mul(vk1, Load(prev + j)), Mul(vk2, Load(curr + j))), Mul(vk3, neighbors));
+            Store(prev + j, next);
+        }
+#endif
+
+        for(; j < colEnd; ++j)
+        {
+            prev[j] = k1*prev[j] + k2*curr[j] + k3*(down[j] + up[j] + curr[j+1] + curr[j-1]);
+        }
+    }
+
+    // Computes the unit normals and x-tangents of columns [colBegin, colEnd) of
+    // one row from central differences of the heights.
+    void NormalsRow(const float* h, const float* up, const float* down, int colBegin, int colEnd, float twoDx,
+                    float* normalX, float* normalY, float* normalZ, float* tangentX, float* tangentY)
+    {
+        int j = colBegin;
+
+#if WAVES_SIMD
+        const FloatV one = Splat(1.0f);
+        const FloatV vTwoDx = Splat(twoDx);
+        const FloatV twoDxSq = Splat(twoDx*twoDx);
+        for(; j + kLanes <= colEnd; j += kLanes)
+        {
+            FloatV l = Load(h + j - 1);
+            FloatV r = Load(h + j + 1);
+            FloatV x = Sub(l, r);
+            FloatV z = Sub(Load(down + j), Load(up + j));
+
+            FloatV invLen = Div(one, Sqrt(Add(Add(Mul(x, x), twoDxSq), Mul(z, z))));
+            Store(normalX + j, Mul(x, invLen));
+            Store(normalY + j, Mul(vTwoDx, invLen));
+            Store(normalZ + j, Mul(z, invLen));
+
+            FloatV y = Sub(r, l);
+            FloatV invTanLen = Div(one, Sqrt(Add(twoDxSq, Mul(y, y))));
+            Store(tangentX + j, Mul(vTwoDx, invTanLen));
+            Store(tangentY + j, Mul(y, invTanLen));
+        }
+#endif
+
+        for(; j < colEnd; ++j)
+        {
+            float l = h[j-1];
+            float r = h[j+1];
+            float x = l - r;
+            float z = down[j] - up[j];
+
+            float invLen = 1.0f / std::sqrt(x*x + twoDx*twoDx + z*z);
+            normalX[j] = x*invLen;
+            normalY[j] = twoDx*invLen;
+            normalZ[j] = z*invLen;
+
+            float y = r - l;
+            float invTanLen = 1.0f / std::sqrt(twoDx*twoDx + y*y);
+            tangentX[j] = twoDx*invTanLen;
+            tangentY[j] = y*invTanLen;
+        }
+    }
+}
+
 Waves::Waves(int m, int n, float dx, float dt, float speed, float damping)
 {
     mNumRows = m;
@@ -25,34 +161,57 @@ Waves::Waves(int m, int n, float dx, float dt, float speed, float damping)
     mK2 = (4.0f - 8.0f*e) / d;
     mK3 = (2.0f*e) / d;
 
-    mPrevSolution.resize(m*n);
-    mCurrSolution.resize(m*n);
-    mNormals.resize(m*n);
-    mTangentX.resize(m*n);
-
-    // Generate grid vertices in system memory.
+    // Generate the flat grid in system memory.
 
     float halfWidth = (n - 1)*dx*0.5f;
     float halfDepth = (m - 1)*dx*0.5f;
-    for(int i = 0; i < m; ++i)
+
+    mGridX.resize(n);
+    for(int j = 0; j < n; ++j)
     {
-        float z = halfDepth - i*dx;
-        for(int j = 0; j < n; ++j)
-        {
-            float x = -halfWidth + j*dx;
+        mGridX[j] = -halfWidth + j*dx;
+    }
 
-            mPrevSolution[i*n + j] = XMFLOAT3(x, 0.0f, z);
-            mCurrSolution[i*n + j] = XMFLOAT3(x, 0.0f, z);
-            mNormals[i*n + j] = XMFLOAT3(0.0f, 1.0f, 0.0f);
-            mTangentX[i*n + j] = XMFLOAT3(1.0f, 0.0f, 0.0f);
-        }
+    mGridZ.resize(m);
+    for(int i = 0; i < m; ++i)
+    {
+        mGridZ[i] = halfDepth - i*dx;
     }
+
+    mPrevHeights.assign(m*n, 0.0f);
+    mCurrHeights.assign(m*n, 0.0f);
+    mNormalX.assign(m*n, 0.0f);
+    mNormalY.assign(m*n, 1.0f);
+    mNormalZ.assign(m*n, 0.0f);
+    mTangentX.assign(m*n, 1.0f);
+    mTangentY.assign(m*n, 0.0f);
 }
 
 Waves::~Waves()
 {
 }
 
+void Waves::SetTileSize(int rows, int cols)
+{
+	mTileRows = std::max(rows, 1);
+	mTileCols = std::max(cols, 1);
+}
+
+void Waves::SetFusedUpdate(bool fused)
+{
+	mFused = fused;
+}
+
+void Waves::SetTemporalBlocking(int substeps)
+{
+	mTemporalBlocking = std::max(substeps, 1);
+}
+
+void Waves::SetMaxSubsteps(int maxSubsteps)
+{
+	mMaxSubsteps = std::max(maxSubsteps, 1);
+}
+
 int Waves::RowCount()const
 {
 	return mNumRows;
@@ -83,72 +242,284 @@ float Waves::Depth()const
 	return mNumRows*mSpatialStep;
 }
 
-void Waves::Update(float dt)
+int Waves::Update(float dt)
 {
-	static float t = 0;
-
 	// Accumulate time.
-	t += dt;
+	mAccumulator += dt;
+
+	// Only update the simulation in whole time steps.
+	int steps = static_cast<int>(mAccumulator / mTimeStep);
+	if(steps > mMaxSubsteps)
+	{
+		steps = mMaxSubsteps;
+		mAccumulator = static_cast<float>(steps)*mTimeStep;
+	}
+
+	if(steps > 0)
+	{
+		Step(steps);
+		mAccumulator = std::max(mAccumulator - steps*mTimeStep, 0.0f);
+	}
+
+	return steps;
+}
+
+float Waves::InterpolationFactor()const
+{
+	return std::min(mAccumulator / mTimeStep, 1.0f);
+}
 
-	// Only update the simulation at the specified time step.
-	if( t >= mTimeStep )
+void Waves::Step(int count)
+{
+	while(count > 0)
 	{
-		// Only update interior points; we use zero boundary conditions.
-		concurrency::parallel_for(1, mNumRows - 1, [this](int i)
-		//for(int i = 1; i < mNumRows-1; ++i)
+		int substeps = std::min(count, mTemporalBlocking);
+		count -= substeps;
+
+		// Normals are only needed for the state we stop at.
+		bool last = count == 0;
+
+		if(substeps > 1)
+		{
+			StepBlocked(substeps, last);
+		}
+		else if(mFused && last)
 		{
-			for(int j = 1; j < mNumCols-1; ++j)
+			StepFused();
+		}
+		else
+		{
+			StepTwoSweeps(last);
+		}
+	}
+}
+
+// Only update interior points; we use zero boundary conditions.
+//
+// The new heights overwrite the previous buffer, which then becomes the
+// current solution. We can do this in place (read/write to same element)
+// because we won't need prev_ij again and the assignment happens last.
+//
+// Note j indexes x and i indexes z: h(x_j, z_i, t_k). Moreover, our +z axis
+// goes "down"; this is just to keep consistent with our row indices going
+// down.
+void Waves::StepTwoSweeps(bool computeNormals)
+{
+	const int n = mNumCols;
+
+	ThreadPool::Default().ParallelFor2D(1, mNumRows - 1, 1, mNumCols - 1, mTileRows, mTileCols,
+		[this, n](int rowBegin, int rowEnd, int colBegin, int colEnd)
+	{
+		for(int i = rowBegin; i < rowEnd; ++i)
+		{
+			const float* curr = mCurrHeights.data() + i*n;
+			StepRow(mPrevHeights.data() + i*n, curr, curr - n, curr + n, colBegin, colEnd, mK1, mK2, mK3);
+		}
+	});
+
+	std::swap(mPrevHeights, mCurrHeights);
+
+	if(!computeNormals)
+	{
+		return;
+	}
+
+	//
+	// Compute normals using finite difference scheme.
+	//
+	ThreadPool::Default().ParallelFor2D(1, mNumRows - 1, 1, mNumCols - 1, mTileRows, mTileCols,
+		[this, n](int rowBegin, int rowEnd, int colBegin, int colEnd)
+	{
+		for(int i = rowBegin; i < rowEnd; ++i)
+		{
+			const float* h = mCurrHeights.data() + i*n;
+			NormalsRow(h, h - n, h + n, colBegin, colEnd, 2.0f*mSpatialStep,
+				mNormalX.data() + i*n, mNormalY.data() + i*n, mNormalZ.data() + i*n,
+				mTangentX.data() + i*n, mTangentY.data() + i*n);
+		}
+	});
+}
+
+void Waves::StepFused()
+{
+	const int n = mNumCols;
+	const int interiorRows = mNumRows - 2;
+	const int bandRows = mTileRows;
+	const int bandCount = (interiorRows + bandRows - 1) / bandRows;
+
+	// Each band steps its rows and, one row behind, computes the normals of
+	// every row whose neighbors are both in the band (and thus already final)
+	// while they are still in cache.
+	ThreadPool::Default().ParallelFor(0, bandCount, 1, [&](int bandBegin, int bandEnd)
+	{
+		for(int band = bandBegin; band < bandEnd; ++band)
+		{
+			int r0 = 1 + band*bandRows;
+			int r1 = std::min(r0 + bandRows, mNumRows - 1);
+
+			for(int i = r0; i < r1; ++i)
+			{
+				const float* curr = mCurrHeights.data() + i*n;
+				StepRow(mPrevHeights.data() + i*n, curr, curr - n, curr + n, 1, n - 1, mK1, mK2, mK3);
+
+				if(i - 1 > r0)
+				{
+					ComputeRowNormals(mPrevHeights.data() + (i - 1)*n, i - 1);
+				}
+			}
+		}
+	});
+
+	// The first and last rows of a band depend on the neighbor bands.
+	ThreadPool::Default().ParallelFor(0, bandCount, 16, [&](int bandBegin, int bandEnd)
+	{
+		for(int band = bandBegin; band < bandEnd; ++band)
+		{
+			int r0 = 1 + band*bandRows;
+			int r1 = std::min(r0 + bandRows, mNumRows - 1);
+
+			ComputeRowNormals(mPrevHeights.data() + r0*n, r0);
+			if(r1 - 1 > r0)
+			{
+				ComputeRowNormals(mPrevHeights.data() + (r1 - 1)*n, r1 - 1);
+			}
+		}
+	});
+
+	std::swap(mPrevHeights, mCurrHeights);
+}
+
+void Waves::StepBlocked(int substeps, bool computeNormals)
+{
+	const int m = mNumRows;
+	const int n = mNumCols;
+	const int interiorRows = m - 2;
+	const int bandRows = mTileRows;
+	const int bandCount = (interiorRows + bandRows - 1) / bandRows;
+
+	// Rows outside a band that are recomputed redundantly. After s substeps,
+	// a band's heights are valid on its rows plus halo - s rows on each side.
+	const int halo = substeps + (computeNormals ? 1 : 0);
+
+	if(mBlockedPrevHeights.size() != mPrevHeights.size())
+	{
+		// The boundary rows and columns are never written and stay 0.
+		mBlockedPrevHeights.assign(m*n, 0.0f);
+		mBlockedCurrHeights.assign(m*n, 0.0f);
+	}
+
+	ThreadPool::Default().ParallelFor(0, bandCount, 1, [&](int bandBegin, int bandEnd)
+	{
+		thread_local std::vector<float> scratchPrev;
+		thread_local std::vector<float> scratchCurr;
+
+		for(int band = bandBegin; band < bandEnd; ++band)
+		{
+			int r0 = 1 + band*bandRows;
+			int r1 = std::min(r0 + bandRows, m - 1);
+
+			// Rows [g0, g1) of the grid are copied to local rows [0, g1 - g0).
+			int g0 = std::max(r0 - halo, 0);
+			int g1 = std::min(r1 + halo, m);
+
+			scratchPrev.assign(mPrevHeights.begin() + g0*n, mPrevHeights.begin() + g1*n);
+			scratchCurr.assign(mCurrHeights.begin() + g0*n, mCurrHeights.begin() + g1*n);
+
+			float* prev = scratchPrev.data();
+			float* curr = scratchCurr.data();
+
+			for(int s = 1; s <= substeps; ++s)
+			{
+				int i0 = std::max(r0 - halo + s, 1);
+				int i1 = std::min(r1 + halo - s, m - 1);
+				for(int i = i0; i < i1; ++i)
+				{
+					const float* c = curr + (i - g0)*n;
+					StepRow(prev + (i - g0)*n, c, c - n, c + n, 1, n - 1, mK1, mK2, mK3);
+				}
+				std::swap(prev, curr);
+			}
+
+			std::copy(prev + (r0 - g0)*n, prev + (r1 - g0)*n, mBlockedPrevHeights.begin() + r0*n);
+			std::copy(curr + (r0 - g0)*n, curr + (r1 - g0)*n, mBlockedCurrHeights.begin() + r0*n);
+
+			if(computeNormals)
 			{
-				// After this update we will be discarding the old previous
-				// buffer, so overwrite that buffer with the new update.
-				// Note how we can do this inplace (read/write to same element) 
-				// because we won't need prev_ij again and the assignment happens last.
-
-				// Note j indexes x and i indexes z: h(x_j, z_i, t_k)
-				// Moreover, our +z axis goes "down"; this is just to 
-				// keep consistent with our row indices going down.
-
-				mPrevSolution[i*mNumCols+j].y = 
-					mK1*mPrevSolution[i*mNumCols+j].y +
-					mK2*mCurrSolution[i*mNumCols+j].y +
-					mK3*(mCurrSolution[(i+1)*mNumCols+j].y + 
-					     mCurrSolution[(i-1)*mNumCols+j].y + 
-					     mCurrSolution[i*mNumCols+j+1].y + 
-						 mCurrSolution[i*mNumCols+j-1].y);
+				for(int i = r0; i < r1; ++i)
+				{
+					ComputeRowNormals(curr + (i - g0)*n, i);
+				}
 			}
-		});
+		}
+	});
+
+	std::swap(mPrevHeights, mBlockedPrevHeights);
+	std::swap(mCurrHeights, mBlockedCurrHeights);
+}
+
+void Waves::ComputeRowNormals(const float* h, int i)
+{
+	const int n = mNumCols;
+	NormalsRow(h, h - n, h + n, 1, n - 1, 2.0f*mSpatialStep,
+		mNormalX.data() + i*n, mNormalY.data() + i*n, mNormalZ.data() + i*n,
+		mTangentX.data() + i*n, mTangentY.data() + i*n);
+}
 
-		// We just overwrote the previous buffer with the new data, so
-		// this data needs to become the current solution and the old
-		// current solution becomes the new previous solution.
-		std::swap(mPrevSolution, mCurrSolution);
+void Waves::WriteVertices(void* dst, const VertexLayout& layout, bool parallel)const
+{
+	const int n = mNumCols;
 
-		t = 0.0f; // reset time
+	// The u texture coordinate only depends on the column.
+	std::vector<float> u(n);
+	for(int j = 0; j < n; ++j)
+	{
+		u[j] = 0.5f + mGridX[j] / Width();
+	}
 
-		//
-		// Compute normals using finite difference scheme.
-		//
-		concurrency::parallel_for(1, mNumRows - 1, [this](int i)
-		//for(int i = 1; i < mNumRows - 1; ++i)
+	auto writeRows = [&](int rowBegin, int rowEnd)
+	{
+		for(int i = rowBegin; i < rowEnd; ++i)
 		{
-			for(int j = 1; j < mNumCols-1; ++j)
+			unsigned char* record = static_cast<unsigned char*>(dst) + static_cast<size_t>(i)*n*layout.Stride;
+			const float z = mGridZ[i];
+			const float v = 0.5f - z / Depth();
+
+			for(int j = 0; j < n; ++j, record += layout.Stride)
 			{
-				float l = mCurrSolution[i*mNumCols+j-1].y;
-				float r = mCurrSolution[i*mNumCols+j+1].y;
-				float t = mCurrSolution[(i-1)*mNumCols+j].y;
-				float b = mCurrSolution[(i+1)*mNumCols+j].y;
-				mNormals[i*mNumCols+j].x = -r+l;
-				mNormals[i*mNumCols+j].y = 2.0f*mSpatialStep;
-				mNormals[i*mNumCols+j].z = b-t;
-
-				XMVECTOR n = XMVector3Normalize(XMLoadFloat3(&mNormals[i*mNumCols+j]));
-				XMStoreFloat3(&mNormals[i*mNumCols+j], n);
-
-				mTangentX[i*mNumCols+j] = XMFLOAT3(2.0f*mSpatialStep, r-l, 0.0f);
-				XMVECTOR T = XMVector3Normalize(XMLoadFloat3(&mTangentX[i*mNumCols+j]));
-				XMStoreFloat3(&mTangentX[i*mNumCols+j], T);
+				const int k = i*n + j;
+
+				if(layout.PositionOffset >= 0)
+				{
+					const float position[3] = { mGridX[j], mCurrHeights[k], z };
+					std::memcpy(record + layout.PositionOffset, position, sizeof(position));
+				}
+				if(layout.NormalOffset >= 0)
+				{
+					const float normal[3] = { mNormalX[k], mNormalY[k], mNormalZ[k] };
+					std::memcpy(record + layout.NormalOffset, normal, sizeof(normal));
+				}
+				if(layout.TexCOffset >= 0)
+				{
+					const float texC[2] = { u[j], v };
+					std::memcpy(record + layout.TexCOffset, texC, sizeof(texC));
+				}
+				if(layout.TangentOffset >= 0)
+				{
+					const float tangent[3] = { mTangentX[k], mTangentY[k], 0.0f };
+					std::memcpy(record + layout.TangentOffset, tangent, sizeof(tangent));
+				}
 			}
-		});
+		}
+	};
+
+	if(parallel)
+	{
+		// Chunks of at least ~16K vertices keep the scheduling overhead low.
+		ThreadPool::Default().ParallelFor(0, mNumRows, std::max(16384 / n, 1), writeRows);
+	}
+	else
+	{
+		writeRows(0, mNumRows);
 	}
 }
 
@@ -161,9 +532,9 @@ void Waves::Disturb(int i, int j, float magnitude)
 	float halfMag = 0.5f*magnitude;
 
 	// Disturb the ijth vertex height and its neighbors.
-	mCurrSolution[i*mNumCols+j].y     += magnitude;
-	mCurrSolution[i*mNumCols+j+1].y   += halfMag;
-	mCurrSolution[i*mNumCols+j-1].y   += halfMag;
-	mCurrSolution[(i+1)*mNumCols+j].y += halfMag;
-	mCurrSolution[(i-1)*mNumCols+j].y += halfMag;
+	mCurrHeights[i*mNumCols+j]     += magnitude;
+	mCurrHeights[i*mNumCols+j+1]   += halfMag;
+	mCurrHeights[i*mNumCols+j-1]   += halfMag;
+	mCurrHeights[(i+1)*mNumCols+j] += halfMag;
+	mCurrHeights[(i-1)*mNumCols+j] += halfMag;
 }
\ No newline at end of file
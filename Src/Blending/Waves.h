@@ -22,15 +22,82 @@ public:
 	float Depth()const;
 
 	// Returns the solution at the ith grid point.
-    const DirectX::XMFLOAT3& Position(int i)const { return mCurrSolution[i]; }
+    DirectX::XMFLOAT3 Position(int i)const
+    {
+        return DirectX::XMFLOAT3(mGridX[i % mNumCols], mCurrHeights[i], mGridZ[i / mNumCols]);
+    }
+
+	// Returns the ith grid point blended from the previous solution (t = 0)
+	// to the current one (t = 1).
+    DirectX::XMFLOAT3 InterpolatedPosition(int i, float t)const
+    {
+        float h = (1.0f - t)*mPrevHeights[i] + t*mCurrHeights[i];
+        return DirectX::XMFLOAT3(mGridX[i % mNumCols], h, mGridZ[i / mNumCols]);
+    }
 
 	// Returns the solution normal at the ith grid point.
-    const DirectX::XMFLOAT3& Normal(int i)const { return mNormals[i]; }
+    DirectX::XMFLOAT3 Normal(int i)const
+    {
+        return DirectX::XMFLOAT3(mNormalX[i], mNormalY[i], mNormalZ[i]);
+    }
 
 	// Returns the unit tangent vector at the ith grid point in the local x-axis direction.
-    const DirectX::XMFLOAT3& TangentX(int i)const { return mTangentX[i]; }
+    DirectX::XMFLOAT3 TangentX(int i)const
+    {
+        return DirectX::XMFLOAT3(mTangentX[i], mTangentY[i], 0.0f);
+    }
+
+	// Update splits the grid into tiles of at most rows x cols points and
+	// processes them in parallel. The default tile is sized so that the
+	// height planes it touches fit in L2. The fused and blocked sweeps split
+	// the grid into full-width bands of rows rows.
+	void SetTileSize(int rows, int cols);
+
+	// With fusion on (the default), a step computes the new heights and the
+	// normals/tangents of each row band in a single sweep over the grid
+	// instead of two.
+	void SetFusedUpdate(bool fused);
+
+	// Step(count) advances up to substeps time steps per band before moving to
+	// the next band (temporal blocking), recomputing a halo of substeps + 1
+	// rows around each band. Normals are only computed after the last step.
+	void SetTemporalBlocking(int substeps);
+
+	// Byte offsets of the attributes within a vertex record written by
+	// WriteVertices. An offset of -1 skips the attribute.
+	struct VertexLayout
+	{
+		int Stride = 0;
+		int PositionOffset = -1;  // float3
+		int NormalOffset = -1;    // float3
+		int TexCOffset = -1;      // float2, [0,1] across the grid
+		int TangentOffset = -1;   // float3
+	};
+
+	// Writes VertexCount() interleaved vertex records to dst, which may be a
+	// mapped upload buffer. Rows are written in parallel chunks unless
+	// parallel is false. Every byte of a record that the layout covers is
+	// written and nothing is read back, which suits write-combined memory.
+	void WriteVertices(void* dst, const VertexLayout& layout, bool parallel = true)const;
+
+	// Caps the number of time steps a single Update may take. Time beyond the
+	// cap is dropped, so a long frame slows the simulation down instead of
+	// making the next frames even longer.
+	void SetMaxSubsteps(int maxSubsteps);
+
+	// Accumulates dt and advances the simulation by as many whole time steps as
+	// fit, up to the max substeps cap. Returns the number of steps taken.
+	int Update(float dt);
+
+	// Fraction of a time step accumulated but not yet simulated, in [0, 1].
+	// Renderers can pass it to InterpolatedPosition to blend between the last
+	// two solutions.
+	float InterpolationFactor()const;
+
+	// Advances the simulation count time steps of the time step passed to the
+	// constructor.
+	void Step(int count);
 
-	void Update(float dt);
 	void Disturb(int i, int j, float magnitude);
 
 private:
@@ -48,10 +115,50 @@ private:
     float mTimeStep = 0.0f;
     float mSpatialStep = 0.0f;
 
-    std::vector<DirectX::XMFLOAT3> mPrevSolution;
-    std::vector<DirectX::XMFLOAT3> mCurrSolution;
-    std::vector<DirectX::XMFLOAT3> mNormals;
-    std::vector<DirectX::XMFLOAT3> mTangentX;
+    // Time passed to Update but not simulated yet.
+    float mAccumulator = 0.0f;
+    int mMaxSubsteps = 4;
+
+    int mTileRows = 32;
+    int mTileCols = 256;
+
+    bool mFused = true;
+    int mTemporalBlocking = 1;
+
+    // The solver only ever changes heights, so the grid is stored as separate
+    // float planes (structure of arrays) indexed by i*mNumCols + j. The x and z
+    // coordinates of a grid point only depend on its column and row.
+    std::vector<float> mGridX;
+    std::vector<float> mGridZ;
+
+    std::vector<float> mPrevHeights;
+    std::vector<float> mCurrHeights;
+
+    std::vector<float> mNormalX;
+    std::vector<float> mNormalY;
+    std::vector<float> mNormalZ;
+
+    // The z component of the tangent is always 0.
+    std::vector<float> mTangentX;
+    std::vector<float> mTangentY;
+
+    // Output of the temporally blocked sweep, which can't write its results in
+    // place because neighboring bands read the old heights as their halo.
+    std::vector<float> mBlockedPrevHeights;
+    std::vector<float> mBlockedCurrHeights;
+
+    // One step as two sweeps over the grid: heights, then (optionally) normals.
+    void StepTwoSweeps(bool computeNormals);
+
+    // One step as a single sweep of row bands, plus a fix-up of band edges.
+    void StepFused();
+
+    // substeps steps per band, through per-thread scratch rows.
+    void StepBlocked(int substeps, bool computeNormals);
+
+    // Recomputes the normals and tangents of row i from the heights of that
+    // row, h, and of the rows adjacent to it in memory.
+    void ComputeRowNormals(const float* h, int i);
 };
 
 #endif // WAVES_H
\ No newline at end of file
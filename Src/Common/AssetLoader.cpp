@@ -0,0 +1,129 @@
+#include "AssetLoader.h"
+
+#include <fstream>
+
+AssetLoader::AssetLoader(unsigned int workerCount) {
+    if (workerCount == 0) {
+        unsigned int hardwareThreads = std::thread::hardware_concurrency();
+        workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+    }
+
+    for (unsigned int i = 0; i < workerCount; ++i) {
+        mWorkers.emplace_back(&AssetLoader::WorkerLoop, this);
+    }
+}
+
+AssetLoader::~AssetLoader() {
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+        mJobs.clear();
+    }
+    mWorkCondition.notify_all();
+
+    for (auto& worker : mWorkers) {
+        worker.join();
+    }
+}
+
+unsigned int AssetLoader::WorkerCount() const {
+    return static_cast<unsigned int>(mWorkers.size());
+}
+
+void AssetLoader::Enqueue(Job job) {
+    ++mSubmitted;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mJobs.push_back(std::move(job));
+    }
+    mWorkCondition.notify_one();
+}
+
+void AssetLoader::WorkerLoop() {
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mWorkCondition.wait(lock, [this]() { return mStopping || !mJobs.empty(); });
+            if (mStopping) {
+                return;
+            }
+            job = std::move(mJobs.front());
+            mJobs.pop_front();
+            ++mRunningJobs;
+        }
+
+        std::function<void()> callback;
+        try {
+            callback = job();
+        } catch (...) {
+            // Only callback jobs get here; a future keeps its exception.
+            ++mFailed;
+        }
+
+        if (callback) {
+            std::lock_guard<std::mutex> lock(mCallbackMutex);
+            mCallbacks.push_back(std::move(callback));
+        } else {
+            ++mReady;
+        }
+        ++mFinished;
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            --mRunningJobs;
+            if (mJobs.empty() && mRunningJobs == 0) {
+                mIdleCondition.notify_all();
+            }
+        }
+    }
+}
+
+size_t AssetLoader::Poll(size_t maxCallbacks) {
+    std::vector<std::function<void()>> callbacks;
+    {
+        std::lock_guard<std::mutex> lock(mCallbackMutex);
+        while (!mCallbacks.empty() && callbacks.size() < maxCallbacks) {
+            callbacks.push_back(std::move(mCallbacks.front()));
+            mCallbacks.pop_front();
+        }
+    }
+
+    for (auto& callback : callbacks) {
+        callback();
+        ++mReady;
+    }
+    return callbacks.size();
+}
+
+void AssetLoader::WaitIdle() {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mIdleCondition.wait(lock, [this]() { return mJobs.empty() && mRunningJobs == 0; });
+}
+
+AssetLoader::Progress AssetLoader::GetProgress() const {
+    Progress progress;
+    progress.Submitted = mSubmitted;
+    progress.Finished = mFinished;
+    progress.Failed = mFailed;
+    progress.Ready = mReady;
+    return progress;
+}
+
+AssetLoader::TextureData AssetLoader::ReadTexture(const std::string& filename) {
+    TextureData texture;
+    texture.Filename = filename;
+
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file) {
+        return texture;
+    }
+    texture.FileData.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char*>(texture.FileData.data()), texture.FileData.size())) {
+        return texture;
+    }
+
+    texture.Loaded = DDS::ParseHeader(texture.FileData.data(), texture.FileData.size(), texture.Info);
+    return texture;
+}
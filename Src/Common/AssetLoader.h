@@ -0,0 +1,135 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "DDS.h"
+
+// Background loading of assets: file reads, header parsing, mesh import. Jobs
+// go into a single FIFO queue drained by a fixed set of worker threads, and
+// each one is handed back either through a future or through a completion
+// callback that runs on whichever thread calls Poll, which is the one that
+// is allowed to record GPU uploads.
+//
+// Unlike ThreadPool, which splits one loop across its workers and returns
+// when the loop is done, a job here is independent and the caller doesn't
+// wait for it; a frame can be drawn with placeholders while jobs run. Nothing
+// here depends on D3D.
+class AssetLoader {
+public:
+    struct Progress {
+        uint32_t Submitted = 0;
+        // Jobs whose work has returned (or thrown).
+        uint32_t Finished = 0;
+        // Jobs whose work threw. Their callbacks don't run.
+        uint32_t Failed = 0;
+        // Jobs that are done with: their callback has run, or they had none
+        // (futures, and jobs that failed).
+        uint32_t Ready = 0;
+    };
+
+    // A DDS file read into memory and parsed, ready for
+    // CreateDDSTextureFromMemory12. Info.BitData points into FileData.
+    struct TextureData {
+        std::string Filename;
+        std::vector<uint8_t> FileData;
+        DDS::TextureInfo Info;
+        bool Loaded = false;
+    };
+
+    // workerCount == 0 uses one worker per hardware thread, minus the caller's.
+    explicit AssetLoader(unsigned int workerCount = 0);
+    AssetLoader(const AssetLoader& rhs) = delete;
+    AssetLoader& operator=(const AssetLoader& rhs) = delete;
+    // Jobs that haven't started are discarded; running ones are waited for.
+    ~AssetLoader();
+
+    unsigned int WorkerCount() const;
+
+    // Runs work() on a worker. The future holds its result, or its exception.
+    template <typename Fn>
+    std::future<std::invoke_result_t<Fn>> Submit(Fn work);
+
+    // Runs work() on a worker, and then onReady(result) on the thread that
+    // calls Poll.
+    template <typename Fn, typename OnReady>
+    void Submit(Fn work, OnReady onReady);
+
+    // Runs the callbacks of up to maxCallbacks finished jobs, in the order
+    // they finished, and returns how many ran. The rest wait for the next
+    // call, which bounds the work (uploads) done per frame.
+    size_t Poll(size_t maxCallbacks = SIZE_MAX);
+
+    // Blocks until every submitted job has finished. Callbacks still wait
+    // for Poll.
+    void WaitIdle();
+
+    Progress GetProgress() const;
+
+    // Reads a DDS file and parses its header. Loaded is false if the file is
+    // missing or malformed.
+    static TextureData ReadTexture(const std::string& filename);
+
+private:
+    // Runs a job's work and returns its callback, empty if it has none.
+    using Job = std::function<std::function<void()>()>;
+
+    std::vector<std::thread> mWorkers;
+
+    std::mutex mMutex;
+    std::condition_variable mWorkCondition;
+    std::condition_variable mIdleCondition;
+    std::deque<Job> mJobs;
+    // Jobs taken by a worker that haven't finished yet.
+    unsigned int mRunningJobs = 0;
+    bool mStopping = false;
+
+    std::mutex mCallbackMutex;
+    std::deque<std::function<void()>> mCallbacks;
+
+    std::atomic<uint32_t> mSubmitted{ 0 };
+    std::atomic<uint32_t> mFinished{ 0 };
+    std::atomic<uint32_t> mFailed{ 0 };
+    std::atomic<uint32_t> mReady{ 0 };
+
+    void Enqueue(Job job);
+
+    void WorkerLoop();
+};
+
+template <typename Fn>
+std::future<std::invoke_result_t<Fn>> AssetLoader::Submit(Fn work) {
+    using Result = std::invoke_result_t<Fn>;
+
+    // std::function needs a copyable target; packaged_task is move-only.
+    auto task = std::make_shared<std::packaged_task<Result()>>(std::move(work));
+    std::future<Result> future = task->get_future();
+    Enqueue([task]() {
+        (*task)();
+        return std::function<void()>();
+    });
+    return future;
+}
+
+template <typename Fn, typename OnReady>
+void AssetLoader::Submit(Fn work, OnReady onReady) {
+    using Result = std::invoke_result_t<Fn>;
+
+    Enqueue([work = std::move(work), onReady = std::move(onReady)]() mutable {
+        auto result = std::make_shared<Result>(work());
+        return std::function<void()>([result, onReady]() mutable {
+            onReady(*result);
+        });
+    });
+}
@@ -1,4 +1,6 @@
 // From Introduction to 3D Game Programming with DirectX 12.
+#include <cassert>
+
 #include "Camera.h"
 
 using namespace DirectX;
@@ -1,7 +1,8 @@
 // From Introduction to 3D Game Programming with DirectX 12.
 #pragma once
 
-#include "d3dUtil.h"
+#include <DirectXMath.h>
+#include "Math.h"
 
 class Camera {
 public:
@@ -2,9 +2,194 @@
 #define TINYGLTF_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_WRITE_IMPLEMENTATION
+// Image URIs are kept; the files they point to are never read.
+#define TINYGLTF_NO_EXTERNAL_IMAGE
 #include "GLTFLoader.h"
 #include "FileSystem.h"
 
+#include <algorithm>
+#include <cfloat>
+#include <filesystem>
+#include <limits>
+#include <unordered_map>
+
+namespace {
+    // Binary glTF: a 12-byte header, then a JSON chunk and an optional BIN
+    // chunk, each with an 8-byte header of its own.
+    const uint32_t GLBMagic = 0x46546C67;      // "glTF"
+    const uint32_t GLBChunkJSON = 0x4E4F534A;  // "JSON"
+    const uint32_t GLBChunkBIN = 0x004E4942;   // "BIN\0"
+
+    // Replaces buffers whose bytes the loader maps itself, so that tinygltf
+    // neither reads nor copies them. tinygltf rejects empty data URIs.
+    const char *PlaceholderBufferURI = "data:application/octet-stream;base64,AA==";
+
+    uint32_t ReadUInt32(const uint8_t *bytes) {
+        uint32_t value;
+        memcpy(&value, bytes, sizeof(value));
+        return value;
+    }
+
+    // Decoding pixels is most of tinygltf's load time and memory, and the
+    // samples load the DDS files named after the image URIs instead.
+    bool SkipImageData(
+        tinygltf::Image *, const int, string *, string *, int, int, const unsigned char *, int, void *
+    ) {
+        return true;
+    }
+
+    // Buffers that an image's buffer view points into. tinygltf reads those
+    // while parsing, so they have to stay as they are.
+    vector<bool> GetImageBuffers(const nlohmann::json &document, size_t bufferCount) {
+        vector<bool> imageBuffers(bufferCount, false);
+
+        auto images = document.find("images");
+        auto bufferViews = document.find("bufferViews");
+        if (images == document.end() || bufferViews == document.end() || !images->is_array() || !bufferViews->is_array()) {
+            return imageBuffers;
+        }
+
+        for (const nlohmann::json &image : *images) {
+            auto bufferView = image.find("bufferView");
+            if (bufferView == image.end() || !bufferView->is_number_unsigned() || *bufferView >= bufferViews->size()) {
+                continue;
+            }
+            auto buffer = (*bufferViews)[bufferView->get<size_t>()].find("buffer");
+            if (buffer != (*bufferViews)[bufferView->get<size_t>()].end() && buffer->is_number_unsigned() && *buffer < bufferCount) {
+                imageBuffers[buffer->get<size_t>()] = true;
+            }
+        }
+
+        return imageBuffers;
+    }
+}
+
+namespace {
+    // Decodes a component as the glTF spec prescribes: normalized unsigned
+    // values are divided by their maximum, signed ones too and clamped to -1
+    // (signed types have two encodings of -1).
+    template <typename T>
+    struct ComponentDecoder {
+        float divisor;
+        float minValue;
+
+        explicit ComponentDecoder(bool normalized) {
+            const bool normalizedInteger = normalized && numeric_limits<T>::is_integer;
+            divisor = normalizedInteger ? (float)numeric_limits<T>::max() : 1.0f;
+            minValue = normalizedInteger && numeric_limits<T>::is_signed ? -1.0f : -FLT_MAX;
+        }
+
+        float operator()(T value) const {
+            return std::max((float)value / divisor, minValue);
+        }
+    };
+
+    // Strided elements whose first DecodedCount components are decoded. The
+    // count is a template parameter so that the inner loop unrolls.
+    template <typename T, int DecodedCount>
+    void DecodeElements(
+        const ComponentDecoder<T> &decode, const uint8_t *src, size_t count, int srcStride,
+        float *dst, int dstComponentCount, size_t dstStride
+    ) {
+        for (size_t i = 0; i < count; ++i) {
+            const T *in = (const T *)(src + i * srcStride);
+            float *out = (float *)((uint8_t *)dst + i * dstStride);
+            for (int c = 0; c < DecodedCount; ++c) {
+                out[c] = decode(in[c]);
+            }
+            for (int c = DecodedCount; c < dstComponentCount; ++c) {
+                out[c] = 0.0f;
+            }
+        }
+    }
+
+    // The loops of GLTFAccessorView::DecodeTo, one instance per component
+    // type, so that each compiles to a straight conversion that the compiler
+    // can vectorize.
+    template <typename T>
+    void DecodeComponents(
+        const uint8_t *src, size_t count, int srcStride, int srcComponentCount, bool normalized,
+        float *dst, int dstComponentCount, size_t dstStride
+    ) {
+        const ComponentDecoder<T> decode(normalized);
+
+        // Packed on both sides with the same component count: one flat loop.
+        if (srcStride == srcComponentCount * (int)sizeof(T) &&
+            dstStride == dstComponentCount * sizeof(float) &&
+            srcComponentCount == dstComponentCount) {
+            const T *in = (const T *)src;
+            const size_t n = count * srcComponentCount;
+            for (size_t i = 0; i < n; ++i) {
+                dst[i] = decode(in[i]);
+            }
+            return;
+        }
+
+        switch (std::min(srcComponentCount, dstComponentCount)) {
+        case 1:
+            DecodeElements<T, 1>(decode, src, count, srcStride, dst, dstComponentCount, dstStride);
+            break;
+        case 2:
+            DecodeElements<T, 2>(decode, src, count, srcStride, dst, dstComponentCount, dstStride);
+            break;
+        case 3:
+            DecodeElements<T, 3>(decode, src, count, srcStride, dst, dstComponentCount, dstStride);
+            break;
+        case 4:
+            DecodeElements<T, 4>(decode, src, count, srcStride, dst, dstComponentCount, dstStride);
+            break;
+        default:
+            // Matrices.
+            for (size_t i = 0; i < count; ++i) {
+                const T *in = (const T *)(src + i * srcStride);
+                float *out = (float *)((uint8_t *)dst + i * dstStride);
+                for (int c = 0; c < dstComponentCount; ++c) {
+                    out[c] = c < srcComponentCount ? decode(in[c]) : 0.0f;
+                }
+            }
+        }
+    }
+}
+
+void GLTFAccessorView::DecodeTo(float *dst, int dstComponentCount, size_t dstStride) const {
+    if (count == 0) {
+        return;
+    }
+
+    switch (componentType) {
+    case TINYGLTF_COMPONENT_TYPE_FLOAT:
+        if (componentCount == dstComponentCount) {
+            CopyTo(dst, dstStride);
+        } else {
+            DecodeComponents<float>(data, count, stride, componentCount, false, dst, dstComponentCount, dstStride);
+        }
+        break;
+    case TINYGLTF_COMPONENT_TYPE_BYTE:
+        DecodeComponents<int8_t>(data, count, stride, componentCount, normalized, dst, dstComponentCount, dstStride);
+        break;
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+        DecodeComponents<uint8_t>(data, count, stride, componentCount, normalized, dst, dstComponentCount, dstStride);
+        break;
+    case TINYGLTF_COMPONENT_TYPE_SHORT:
+        DecodeComponents<int16_t>(data, count, stride, componentCount, normalized, dst, dstComponentCount, dstStride);
+        break;
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+        DecodeComponents<uint16_t>(data, count, stride, componentCount, normalized, dst, dstComponentCount, dstStride);
+        break;
+    case TINYGLTF_COMPONENT_TYPE_INT:
+        DecodeComponents<int32_t>(data, count, stride, componentCount, normalized, dst, dstComponentCount, dstStride);
+        break;
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+        DecodeComponents<uint32_t>(data, count, stride, componentCount, normalized, dst, dstComponentCount, dstStride);
+        break;
+    case TINYGLTF_COMPONENT_TYPE_DOUBLE:
+        DecodeComponents<double>(data, count, stride, componentCount, false, dst, dstComponentCount, dstStride);
+        break;
+    default:
+        assert(0 && "unsupported component type");
+    }
+}
+
 GLTFLoader::GLTFLoader(string &filename) 
     : mFilename(filename),
       mAssetsDirectory(FileSystem::GetDirectory(filename))
@@ -17,13 +202,27 @@ unsigned int GLTFLoader::getPrimitiveCount(int nodeIdx) const {
     return mesh.primitives.size();
 }
 
-GLTFPrimitiveData GLTFLoader::Load(string &filename) {
-    tinygltf::Model model;
-    tinygltf::TinyGLTF loader;
+bool GLTFLoader::LoadModel() {
+    mModel = tinygltf::Model();
+    mBufferData.clear();
+    mBufferSizes.clear();
+    mMappedFiles.clear();
+    mBufferFiles.clear();
+
     string err;
     string warn;
 
-    bool ret = loader.LoadASCIIFromFile(&model, &err, &warn, filename);
+    MappedFile file;
+    bool ret = file.Open(mFilename);
+    if (!ret) {
+        err = "File not found: " + mFilename;
+    } else {
+        ret = LoadFromMemory(file.Data(), file.Size(), err, warn);
+        // The BIN chunk of a .glb may be mapped; keep the file.
+        if (ret && file.Size() >= 4 && ReadUInt32(file.Data()) == GLBMagic) {
+            mMappedFiles.push_back(std::move(file));
+        }
+    }
     if (!warn.empty()) {
         printf("Warn: %s\n", warn.c_str());
     }
@@ -33,207 +232,340 @@ GLTFPrimitiveData GLTFLoader::Load(string &filename) {
     if (!ret) {
         printf("Failed to parse glTF\n");
     }
+    return ret;
+}
 
-    GLTFPrimitiveData loadedData;
-
-    const tinygltf::Scene &scene = model.scenes[model.defaultScene];
-
-    for (int j = 0; j < scene.nodes.size(); ++j) {
-        auto &node = model.nodes[scene.nodes[j]];
-        if ((node.mesh >= 0) && (node.mesh < model.meshes.size())) {
-            auto &mesh = model.meshes[node.mesh];
-
-            const size_t index_remap[] = {0, 2, 1};
-
-            for (size_t i = 0; i < mesh.primitives.size(); ++i) {
-                tinygltf::Primitive primitive = mesh.primitives[i];
-
-                tinygltf::Accessor indexAccessor = model.accessors[primitive.indices];
-                const tinygltf::BufferView &indexBufferView = model.bufferViews[indexAccessor.bufferView];
-                const tinygltf::Buffer &indexBuffer = model.buffers[indexBufferView.buffer];
-                const uint8_t *indexes = indexBuffer.data.data() + indexBufferView.byteOffset;
-                int stride = indexAccessor.ByteStride(indexBufferView);
-
-                loadedData.indices.resize(indexAccessor.count);
-
-                int indexOffset = 0;
-                int vertexOffset = 0;
-
-                if (stride == 1) {
-                    for (size_t i = 0; i < indexAccessor.count; i += 3) {
-                        loadedData.indices[indexOffset + i + 0] = vertexOffset + indexes[i + index_remap[0]];
-                        loadedData.indices[indexOffset + i + 1] = vertexOffset + indexes[i + index_remap[1]];
-                        loadedData.indices[indexOffset + i + 2] = vertexOffset + indexes[i + index_remap[2]];
-                    }
-                } else if (stride == 2) {
-                    for (size_t i = 0; i < indexAccessor.count; i += 3) {
-                        loadedData.indices[indexOffset + i + 0] = vertexOffset + ((uint16_t *)indexes)[i + index_remap[0]];
-                        loadedData.indices[indexOffset + i + 1] = vertexOffset + ((uint16_t *)indexes)[i + index_remap[1]];
-                        loadedData.indices[indexOffset + i + 2] = vertexOffset + ((uint16_t *)indexes)[i + index_remap[2]];
-                    }
-                } else if (stride == 4) {
-                    for (size_t i = 0; i < indexAccessor.count; i += 3) {
-                        loadedData.indices[indexOffset + i + 0] = vertexOffset + ((uint32_t *)indexes)[i + index_remap[0]];
-                        loadedData.indices[indexOffset + i + 1] = vertexOffset + ((uint32_t *)indexes)[i + index_remap[1]];
-                        loadedData.indices[indexOffset + i + 2] = vertexOffset + ((uint32_t *)indexes)[i + index_remap[2]];
-                    }
-                } else {
-                    assert(0 && "unsupported index stride!");
-                }
+bool GLTFLoader::LoadFromMemory(const uint8_t *bytes, size_t size, string &err, string &warn) {
+    const bool binary = size >= 4 && ReadUInt32(bytes) == GLBMagic;
 
-                const tinygltf::Accessor &accessor = model.accessors[primitive.attributes["POSITION"]];
-                const tinygltf::BufferView &bufferView = model.bufferViews[accessor.bufferView];
-                const tinygltf::Buffer &buffer = model.buffers[bufferView.buffer];
-                stride = accessor.ByteStride(bufferView);
-                const uint8_t *data = buffer.data.data() + accessor.byteOffset + bufferView.byteOffset;
+    const char *json = (const char *)bytes;
+    size_t jsonSize = size;
+    const uint8_t *bin = nullptr;
+    size_t binSize = 0;
 
-                for (size_t i = 0; i < accessor.count; ++i) {
-                    loadedData.positions.push_back(*(const XMFLOAT3 *)(data + i * stride));
-                }
+    if (binary) {
+        if (size < 20 || ReadUInt32(bytes + 8) > size || ReadUInt32(bytes + 16) != GLBChunkJSON) {
+            err = "Invalid GLB header";
+            return false;
+        }
+        const size_t length = ReadUInt32(bytes + 8);
+        jsonSize = ReadUInt32(bytes + 12);
+        json = (const char *)bytes + 20;
+        if (20 + jsonSize > length) {
+            err = "Invalid GLB JSON chunk";
+            return false;
+        }
+
+        // Chunks are 4-byte aligned, so the BIN chunk follows right after.
+        const size_t binHeader = 20 + jsonSize;
+        if (binHeader + 8 <= length && ReadUInt32(bytes + binHeader + 4) == GLBChunkBIN) {
+            binSize = ReadUInt32(bytes + binHeader);
+            bin = bytes + binHeader + 8;
+            if (binHeader + 8 + binSize > length) {
+                err = "Invalid GLB BIN chunk";
+                return false;
             }
         }
     }
 
-    return loadedData;
-}
+    // Map the buffers that can be mapped and hand tinygltf the JSON with
+    // placeholders in their place.
+    string rewritten;
+    bool binaryRequired = false;
+    nlohmann::json document = nlohmann::json::parse(json, json + jsonSize, nullptr, false);
+    auto buffers = document.is_object() ? document.find("buffers") : document.end();
+    if (!document.is_discarded() && buffers != document.end() && buffers->is_array()) {
+        mBufferData.assign(buffers->size(), nullptr);
+        mBufferSizes.assign(buffers->size(), 0);
+        const vector<bool> imageBuffers = GetImageBuffers(document, buffers->size());
+
+        for (size_t i = 0; i < buffers->size(); ++i) {
+            nlohmann::json &buffer = (*buffers)[i];
+            auto byteLength = buffer.is_object() ? buffer.find("byteLength") : buffer.end();
+            if (byteLength == buffer.end() || !byteLength->is_number_unsigned() || *byteLength == 0) {
+                continue;
+            }
 
-void GLTFLoader::LoadModel() {
-    tinygltf::TinyGLTF loader;
+            auto uri = buffer.find("uri");
+            const bool external = uri != buffer.end() && uri->is_string() &&
+                uri->get_ref<const string &>().compare(0, 5, "data:") != 0;
+            if (external) {
+                const string &path = uri->get_ref<const string &>();
+                mBufferFiles.push_back(mAssetsDirectory.empty() ? path : mAssetsDirectory + "/" + path);
+            }
 
-    string err;
-    string warn;
+            if (imageBuffers[i]) {
+                binaryRequired |= binary && uri == buffer.end();
+                continue;
+            }
 
-    bool ret = loader.LoadASCIIFromFile(&mModel, &err, &warn, mFilename);
-    if (!warn.empty()) {
-        printf("Warn: %s\n", warn.c_str());
+            const uint8_t *data = nullptr;
+            if (uri == buffer.end()) {
+                // The BIN chunk is the buffer without a URI.
+                if (bin && binSize >= *byteLength) {
+                    data = bin;
+                }
+            } else if (external) {
+                // URIs that need decoding fail to map and are left to tinygltf.
+                MappedFile bufferFile;
+                if (bufferFile.Open(mBufferFiles.back()) &&
+                    bufferFile.Size() >= *byteLength) {
+                    data = bufferFile.Data();
+                    mMappedFiles.push_back(std::move(bufferFile));
+                }
+            }
+
+            if (data) {
+                mBufferData[i] = data;
+                mBufferSizes[i] = *byteLength;
+                buffer = { { "byteLength", 1 }, { "uri", PlaceholderBufferURI } };
+            }
+        }
+
+        if (std::any_of(mBufferData.begin(), mBufferData.end(), [](const uint8_t *data) { return data; })) {
+            rewritten = document.dump();
+        }
     }
-    if (!err.empty()) {
-        printf("Err: %s\n", err.c_str());
+
+    tinygltf::TinyGLTF loader;
+    loader.SetImageLoader(SkipImageData, nullptr);
+
+    bool ret;
+    if (binaryRequired) {
+        // Images in the BIN chunk: let tinygltf load the whole file.
+        mBufferData.clear();
+        mBufferSizes.clear();
+        mMappedFiles.clear();
+        ret = loader.LoadBinaryFromMemory(&mModel, &err, &warn, bytes, (unsigned int)size, mAssetsDirectory);
+    } else if (!rewritten.empty()) {
+        ret = loader.LoadASCIIFromString(&mModel, &err, &warn, rewritten.data(), (unsigned int)rewritten.size(), mAssetsDirectory);
+    } else {
+        ret = loader.LoadASCIIFromString(&mModel, &err, &warn, json, (unsigned int)jsonSize, mAssetsDirectory);
     }
+
     if (!ret) {
-        printf("Failed to parse glTF\n");
+        mBufferData.clear();
+        mBufferSizes.clear();
+        mMappedFiles.clear();
+        return false;
     }
+
+    mBufferData.resize(mModel.buffers.size(), nullptr);
+    mBufferSizes.resize(mModel.buffers.size(), 0);
+    for (size_t i = 0; i < mModel.buffers.size(); ++i) {
+        if (!mBufferData[i]) {
+            mBufferData[i] = mModel.buffers[i].data.data();
+            mBufferSizes[i] = mModel.buffers[i].data.size();
+        }
+    }
+
+    return true;
 }
 
 // Loads a single primitive from the specified node.
 GLTFPrimitiveData GLTFLoader::LoadPrimitive(int nodeIdx, int primitiveIdx) const {
-    GLTFPrimitiveData primitiveData;
-
     const tinygltf::Scene &scene = mModel.scenes[mModel.defaultScene];
     auto &node = mModel.nodes[scene.nodes[nodeIdx]];
-    auto &mesh = mModel.meshes[node.mesh];
-
-    // The primitive to load.
-    tinygltf::Primitive primitive = mesh.primitives[primitiveIdx];
+    return LoadMeshPrimitive(node.mesh, primitiveIdx);
+}
 
-    // Load indices.
-    LoadPrimitiveIndices(primitive, primitiveData);
+GLTFPrimitiveData GLTFLoader::LoadPrimitive(const GLTFScenePrimitive &scenePrimitive) const {
+    return LoadMeshPrimitive(scenePrimitive.mesh, scenePrimitive.primitive);
+}
 
-    // Load vertex positions.
-    LoadPrimitivePositions(primitive, primitiveData);
+vector<GLTFScenePrimitive> GLTFLoader::FlattenScene() const {
+    vector<GLTFScenePrimitive> scenePrimitives;
+    if (mModel.scenes.empty()) {
+        return scenePrimitives;
+    }
 
-    // Load vertex normals.
-    LoadPrimitiveNormals(primitive, primitiveData);
+    // Files without a default scene show the first one.
+    const tinygltf::Scene &scene = mModel.scenes[mModel.defaultScene >= 0 ? mModel.defaultScene : 0];
+
+    // Depth-first, with each node's parent transform on the stack.
+    struct Entry {
+        int node;
+        XMFLOAT4X4 parentWorld;
+    };
+    vector<Entry> stack;
+    for (auto it = scene.nodes.rbegin(); it != scene.nodes.rend(); ++it) {
+        stack.push_back({ *it, Math::Identity4x4() });
+    }
 
-    // Load vertex UVs.
-    LoadPrimitiveUVs(primitive, primitiveData);
+    while (!stack.empty()) {
+        Entry entry = stack.back();
+        stack.pop_back();
 
-    // Load material.
-    LoadPrimitiveMaterial(primitive, primitiveData);
+        const tinygltf::Node &node = mModel.nodes[entry.node];
 
-    return primitiveData;
-}
+        XMFLOAT4X4 world;
+        XMStoreFloat4x4(&world, GetLocalTransform(node) * XMLoadFloat4x4(&entry.parentWorld));
 
-void GLTFLoader::LoadPrimitiveIndices(
-        tinygltf::Primitive &primitive,
-        GLTFPrimitiveData &primitiveData
-) const {
-    const size_t indexRemap[] = {0, 1, 2};
-    tinygltf::Accessor indexAccessor = mModel.accessors[primitive.indices];
-    const tinygltf::BufferView &indexBufferView = mModel.bufferViews[indexAccessor.bufferView];
-    const tinygltf::Buffer &indexBuffer = mModel.buffers[indexBufferView.buffer];
-    const uint8_t *indexes = indexBuffer.data.data() + indexAccessor.byteOffset + indexBufferView.byteOffset;
-    int stride = indexAccessor.ByteStride(indexBufferView);
-    primitiveData.indices.resize(indexAccessor.count);
-
-    if (stride == 1) {
-        for (size_t i = 0; i < indexAccessor.count; i += 3) {
-            primitiveData.indices[i + 0] = indexes[i + indexRemap[0]];
-            primitiveData.indices[i + 1] = indexes[i + indexRemap[1]];
-            primitiveData.indices[i + 2] = indexes[i + indexRemap[2]];
-        }
-    } else if (stride == 2) {
-        for (size_t i = 0; i < indexAccessor.count; i += 3) {
-            primitiveData.indices[i + 0] = ((uint16_t *)indexes)[i + indexRemap[0]];
-            primitiveData.indices[i + 1] = ((uint16_t *)indexes)[i + indexRemap[1]];
-            primitiveData.indices[i + 2] = ((uint16_t *)indexes)[i + indexRemap[2]];
+        if (node.mesh >= 0 && node.mesh < (int)mModel.meshes.size()) {
+            const tinygltf::Mesh &mesh = mModel.meshes[node.mesh];
+            for (int i = 0; i < (int)mesh.primitives.size(); ++i) {
+                scenePrimitives.push_back({ entry.node, node.mesh, i, world });
+            }
         }
-    } else if (stride == 4) {
-        for (size_t i = 0; i < indexAccessor.count; i += 3) {
-            primitiveData.indices[i + 0] = ((uint32_t *)indexes)[i + indexRemap[0]];
-            primitiveData.indices[i + 1] = ((uint32_t *)indexes)[i + indexRemap[1]];
-            primitiveData.indices[i + 2] = ((uint32_t *)indexes)[i + indexRemap[2]];
+
+        for (auto it = node.children.rbegin(); it != node.children.rend(); ++it) {
+            stack.push_back({ *it, world });
         }
-    } else {
-        assert(0 && "unsupported index stride");
     }
+
+    return scenePrimitives;
 }
 
-void GLTFLoader::LoadPrimitivePositions(
-    tinygltf::Primitive &primitive, GLTFPrimitiveData &primitiveData
-) const {
-    const tinygltf::Accessor &accessor = mModel.accessors[primitive.attributes["POSITION"]];
-    const tinygltf::BufferView &bufferView = mModel.bufferViews[accessor.bufferView];
-    const tinygltf::Buffer &buffer = mModel.buffers[bufferView.buffer];
-    int stride = accessor.ByteStride(bufferView);
-    const uint8_t *data = buffer.data.data() + accessor.byteOffset + bufferView.byteOffset;
+vector<GLTFSceneMeshData> GLTFLoader::LoadScene() const {
+    vector<GLTFScenePrimitive> scenePrimitives = FlattenScene();
 
-    for (size_t i = 0; i < accessor.count; ++i) {
-        primitiveData.positions.push_back(*(const XMFLOAT3 *)(data + i * stride));
+    vector<GLTFSceneMeshData> sceneMeshes(scenePrimitives.size());
+    for (size_t i = 0; i < scenePrimitives.size(); ++i) {
+        sceneMeshes[i].data = LoadPrimitive(scenePrimitives[i]);
+        sceneMeshes[i].world = scenePrimitives[i].world;
     }
+
+    return sceneMeshes;
 }
 
-void GLTFLoader::LoadPrimitiveNormals(
-    tinygltf::Primitive &primitive, GLTFPrimitiveData &primitiveData
-) const {
-    const tinygltf::Accessor &accessor = mModel.accessors[primitive.attributes["NORMAL"]];
-    const tinygltf::BufferView &bufferView = mModel.bufferViews[accessor.bufferView];
-    const tinygltf::Buffer &buffer = mModel.buffers[bufferView.buffer];
-    int stride = accessor.ByteStride(bufferView);
-    const uint8_t *data = buffer.data.data() + accessor.byteOffset + bufferView.byteOffset;
+XMMATRIX GLTFLoader::GetLocalTransform(const tinygltf::Node &node) const {
+    // glTF matrices are column-major for column vectors; read row by row, that
+    // is the same matrix for row vectors.
+    if (node.matrix.size() == 16) {
+        XMFLOAT4X4 m;
+        for (int i = 0; i < 16; ++i) {
+            m.m[i / 4][i % 4] = (float)node.matrix[i];
+        }
+        return XMLoadFloat4x4(&m);
+    }
+
+    XMMATRIX S = XMMatrixIdentity();
+    if (node.scale.size() == 3) {
+        S = XMMatrixScaling((float)node.scale[0], (float)node.scale[1], (float)node.scale[2]);
+    }
+
+    XMMATRIX R = XMMatrixIdentity();
+    if (node.rotation.size() == 4) {
+        R = XMMatrixRotationQuaternion(XMVectorSet(
+            (float)node.rotation[0], (float)node.rotation[1], (float)node.rotation[2], (float)node.rotation[3]
+        ));
+    }
 
-    for (size_t i = 0; i < accessor.count; ++i) {
-        primitiveData.normals.push_back(*(const XMFLOAT3 *)(data + i * stride));
+    XMMATRIX T = XMMatrixIdentity();
+    if (node.translation.size() == 3) {
+        T = XMMatrixTranslation((float)node.translation[0], (float)node.translation[1], (float)node.translation[2]);
     }
+
+    // T * R * S in glTF's column-vector convention.
+    return S * R * T;
 }
 
-void GLTFLoader::LoadPrimitiveUVs(
-    tinygltf::Primitive &primitive,
-    GLTFPrimitiveData &primitiveData
-) const {
-    const tinygltf::Accessor &accessor = mModel.accessors[primitive.attributes["TEXCOORD_0"]];
-    const tinygltf::BufferView &bufferView = mModel.bufferViews[accessor.bufferView];
-    const tinygltf::Buffer &buffer = mModel.buffers[bufferView.buffer];
-    int stride = accessor.ByteStride(bufferView);
-    const uint8_t *data = buffer.data.data() + accessor.byteOffset + bufferView.byteOffset;
+GLTFPrimitiveData GLTFLoader::LoadMeshPrimitive(int meshIdx, int primitiveIdx) const {
+    GLTFPrimitiveData primitiveData;
 
-    for (size_t i = 0; i < accessor.count; ++i) {
-        primitiveData.uvs.push_back(*(const XMFLOAT2 *)(data + i * stride));
+    GLTFPrimitiveView view = GetMeshPrimitiveView(meshIdx, primitiveIdx);
+
+    // Load indices, at the width that the vertex count allows.
+    if (view.indexStride() == sizeof(uint16_t)) {
+        primitiveData.indices16.resize(view.indices.count);
+        view.indices.CopyIndicesTo(primitiveData.indices16.data());
+    } else {
+        primitiveData.indices32.resize(view.indices.count);
+        view.indices.CopyIndicesTo(primitiveData.indices32.data());
     }
+
+    // Load vertex positions, normals and UVs in one pass each; a copy unless
+    // they are quantized.
+    primitiveData.positions.resize(view.positions.count);
+    view.positions.DecodeTo((float *)primitiveData.positions.data(), 3, sizeof(XMFLOAT3));
+
+    primitiveData.normals.resize(view.normals.count);
+    view.normals.DecodeTo((float *)primitiveData.normals.data(), 3, sizeof(XMFLOAT3));
+
+    primitiveData.uvs.resize(view.uvs.count);
+    view.uvs.DecodeTo((float *)primitiveData.uvs.data(), 2, sizeof(XMFLOAT2));
+
+    // Load material.
+    primitiveData.texture = view.texture;
+    primitiveData.material = view.material;
+
+    return primitiveData;
 }
 
-void GLTFLoader::LoadPrimitiveTexture(
-        tinygltf::Primitive &primitive,
-        GLTFPrimitiveData &primitiveData
-) const {
-    primitiveData.texture = mModel.materials[primitive.material].pbrMetallicRoughness.baseColorTexture.index;
+GLTFPrimitiveView GLTFLoader::GetPrimitiveView(const GLTFScenePrimitive &scenePrimitive) const {
+    return GetMeshPrimitiveView(scenePrimitive.mesh, scenePrimitive.primitive);
 }
 
-void GLTFLoader::LoadPrimitiveMaterial(
-        tinygltf::Primitive &primitive,
-        GLTFPrimitiveData &primitiveData
-) const {
-    primitiveData.material = primitive.material;
+GLTFPrimitiveView GLTFLoader::GetMeshPrimitiveView(int meshIdx, int primitiveIdx) const {
+    const tinygltf::Primitive &primitive = mModel.meshes[meshIdx].primitives[primitiveIdx];
+
+    GLTFPrimitiveView view;
+    view.positions = GetAttributeView(primitive, "POSITION");
+    view.normals = GetAttributeView(primitive, "NORMAL");
+    view.uvs = GetAttributeView(primitive, "TEXCOORD_0");
+    view.indices = GetAccessorView(primitive.indices);
+    view.indexed = primitive.indices >= 0;
+    view.material = primitive.material;
+    view.texture = primitive.material >= 0
+        ? mModel.materials[primitive.material].pbrMetallicRoughness.baseColorTexture.index
+        : -1;
+    return view;
+}
+
+GLTFAccessorView GLTFLoader::GetAttributeView(const tinygltf::Primitive &primitive, const char *attribute) const {
+    auto it = primitive.attributes.find(attribute);
+    return it != primitive.attributes.end() ? GetAccessorView(it->second) : GLTFAccessorView();
+}
+
+const vector<string> &GLTFLoader::GetBufferFiles() const {
+    return mBufferFiles;
+}
+
+GLTFAccessorView GLTFLoader::GetAccessorView(int accessorIdx) const {
+    GLTFAccessorView view;
+    if (accessorIdx < 0 || accessorIdx >= (int)mModel.accessors.size()) {
+        return view;
+    }
+
+    // Accessors without a buffer view (all zeros, or sparse only) aren't
+    // supported.
+    const tinygltf::Accessor &accessor = mModel.accessors[accessorIdx];
+    if (accessor.bufferView < 0 || accessor.bufferView >= (int)mModel.bufferViews.size()) {
+        return view;
+    }
+
+    const tinygltf::BufferView &bufferView = mModel.bufferViews[accessor.bufferView];
+    int stride = accessor.ByteStride(bufferView);
+    if (stride <= 0 || bufferView.buffer < 0 || bufferView.buffer >= (int)mBufferData.size()) {
+        return view;
+    }
+
+    // The last element has to end inside the buffer view, and the view inside
+    // the buffer. Written so that nothing overflows.
+    const size_t bufferSize = mBufferSizes[bufferView.buffer];
+    const int componentSize = tinygltf::GetComponentSizeInBytes(accessor.componentType);
+    const int componentCount = tinygltf::GetNumComponentsInType(accessor.type);
+    if (componentSize <= 0 || componentCount <= 0 ||
+        bufferView.byteOffset > bufferSize || bufferView.byteLength > bufferSize - bufferView.byteOffset) {
+        printf("Warn: accessor %d doesn't fit in its buffer\n", accessorIdx);
+        return view;
+    }
+    const size_t elementSize = size_t(componentSize) * componentCount;
+    if (accessor.count > 0 &&
+        (accessor.byteOffset > bufferView.byteLength ||
+         elementSize > bufferView.byteLength - accessor.byteOffset ||
+         accessor.count - 1 > (bufferView.byteLength - accessor.byteOffset - elementSize) / stride)) {
+        printf("Warn: accessor %d doesn't fit in its buffer\n", accessorIdx);
+        return view;
+    }
+
+    view.data = mBufferData[bufferView.buffer] + accessor.byteOffset + bufferView.byteOffset;
+    view.count = accessor.count;
+    view.stride = stride;
+    view.componentType = accessor.componentType;
+    view.componentCount = componentCount;
+    view.normalized = accessor.normalized;
+    return view;
 }
 
 vector<GLTFTextureData> GLTFLoader::LoadTextures() {
@@ -250,6 +582,23 @@ vector<GLTFTextureData> GLTFLoader::LoadTextures() {
     return textureData;
 }
 
+GLTFTextureTable GLTFLoader::DeduplicateTextures(const vector<GLTFTextureData> &textures) {
+    GLTFTextureTable table;
+    table.textureImages.resize(textures.size());
+
+    unordered_map<string, int> imageIndices;
+    for (size_t i = 0; i < textures.size(); ++i) {
+        string key = filesystem::path(textures[i].uri).lexically_normal().generic_string();
+        auto inserted = imageIndices.emplace(key, static_cast<int>(table.images.size()));
+        if (inserted.second) {
+            table.images.push_back(textures[i]);
+        }
+        table.textureImages[i] = inserted.first->second;
+    }
+
+    return table;
+}
+
 vector<GLTFMaterialData> GLTFLoader::LoadMaterials(const std::vector<GLTFTextureData> &textures) {
     unsigned int materialCount = mModel.materials.size();
 
@@ -257,8 +606,38 @@ vector<GLTFMaterialData> GLTFLoader::LoadMaterials(const std::vector<GLTFTexture
 
     for (int i = 0; i < materialCount; ++i) {
         tinygltf::Material &material = mModel.materials[i];
-        materialData[i].baseColorMap = material.pbrMetallicRoughness.baseColorTexture.index;
-        materialData[i].normalMap = material.normalTexture.index;
+        const tinygltf::PbrMetallicRoughness &pbr = material.pbrMetallicRoughness;
+        GLTFMaterialData &data = materialData[i];
+
+        data.baseColorMap = pbr.baseColorTexture.index;
+        data.normalMap = material.normalTexture.index;
+        data.metallicRoughnessMap = pbr.metallicRoughnessTexture.index;
+        data.occlusionMap = material.occlusionTexture.index;
+        data.emissiveMap = material.emissiveTexture.index;
+
+        if (pbr.baseColorFactor.size() == 4) {
+            data.baseColorFactor = XMFLOAT4(
+                (float)pbr.baseColorFactor[0], (float)pbr.baseColorFactor[1],
+                (float)pbr.baseColorFactor[2], (float)pbr.baseColorFactor[3]
+            );
+        }
+        if (material.emissiveFactor.size() == 3) {
+            data.emissiveFactor = XMFLOAT3(
+                (float)material.emissiveFactor[0], (float)material.emissiveFactor[1], (float)material.emissiveFactor[2]
+            );
+        }
+        data.metallicFactor = (float)pbr.metallicFactor;
+        data.roughnessFactor = (float)pbr.roughnessFactor;
+        data.normalScale = (float)material.normalTexture.scale;
+        data.occlusionStrength = (float)material.occlusionTexture.strength;
+
+        if (material.alphaMode == "MASK") {
+            data.alphaMode = GLTFAlphaMode::Mask;
+        } else if (material.alphaMode == "BLEND") {
+            data.alphaMode = GLTFAlphaMode::Blend;
+        }
+        data.alphaCutoff = (float)material.alphaCutoff;
+        data.doubleSided = material.doubleSided;
     }
 
     return materialData;
@@ -1,10 +1,15 @@
 #pragma once
+#include <cassert>
+#include <cstring>
 #include <string>
 #include <vector>
 #include <memory>
 #include "Math.h"
+#include "MappedFile.h"
 
+#ifdef _MSC_VER
 #define __STDC_LIB_EXT1__
+#endif
 #include "../Ext/tiny_gltf.h"
 
 using namespace std;
@@ -13,38 +18,228 @@ using namespace DirectX;
 // Loaded data of a single primitive.
 struct GLTFPrimitiveData {
     vector<XMFLOAT3> positions;
-    vector<uint16_t> indices;
+    // Only one of the two is filled: indices16 when every vertex of the
+    // primitive can be addressed with 16 bits, indices32 otherwise.
+    vector<uint16_t> indices16;
+    vector<uint32_t> indices32;
     vector<XMFLOAT3> normals;
     vector<XMFLOAT2> uvs;
     int texture;
     int material;
+
+    size_t indexCount() const {
+        return indices32.empty() ? indices16.size() : indices32.size();
+    }
+
+    // Bytes per index: 2 or 4.
+    unsigned int indexStride() const {
+        return indices32.empty() ? sizeof(uint16_t) : sizeof(uint32_t);
+    }
+
+    const void* indexData() const {
+        return indices32.empty() ? (const void*)indices16.data() : (const void*)indices32.data();
+    }
+};
+
+// Strided view of an accessor's elements inside the loaded buffers. No data is
+// copied; the view is valid while its GLTFLoader is alive.
+struct GLTFAccessorView {
+    const uint8_t *data = nullptr;
+    size_t count = 0;
+    // Bytes from one element to the next.
+    int stride = 0;
+    // TINYGLTF_COMPONENT_TYPE_*.
+    int componentType = 0;
+    // 1 for SCALAR, 2 for VEC2, 3 for VEC3...
+    int componentCount = 0;
+    bool normalized = false;
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    // Bytes of a single element, without padding.
+    int elementSize() const {
+        return tinygltf::GetComponentSizeInBytes(componentType) * componentCount;
+    }
+
+    template <typename T>
+    const T &at(size_t i) const {
+        return *(const T *)(data + i * stride);
+    }
+
+    // Copies every element as is into dst, dstStride bytes apart. With
+    // dstStride larger than elementSize() this writes a single attribute of an
+    // interleaved vertex buffer.
+    void CopyTo(void *dst, size_t dstStride) const {
+        if (count == 0) {
+            return;
+        }
+
+        const int size = elementSize();
+        uint8_t *out = (uint8_t *)dst;
+        if (stride == size && dstStride == (size_t)size) {
+            memcpy(out, data, count * size);
+            return;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            memcpy(out + i * dstStride, data + i * stride, size);
+        }
+    }
+
+    // Converts every element to dstComponentCount floats, dstStride bytes
+    // apart, whatever the component type: FLOAT is copied, normalized integers
+    // are mapped to [0, 1] or [-1, 1] as the glTF spec prescribes (quantized
+    // UVs and normals), and other integers (KHR_mesh_quantization positions)
+    // are converted as they are. Components the accessor doesn't have are
+    // written as 0.
+    void DecodeTo(float *dst, int dstComponentCount, size_t dstStride) const;
+
+    // Copies scalar unsigned indices of any width into a TIndex array.
+    template <typename TIndex>
+    void CopyIndicesTo(TIndex *dst) const {
+        if (componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE) {
+            for (size_t i = 0; i < count; ++i) {
+                dst[i] = (TIndex)at<uint8_t>(i);
+            }
+        } else if (componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT) {
+            for (size_t i = 0; i < count; ++i) {
+                dst[i] = (TIndex)at<uint16_t>(i);
+            }
+        } else if (componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT) {
+            for (size_t i = 0; i < count; ++i) {
+                dst[i] = (TIndex)at<uint32_t>(i);
+            }
+        } else {
+            assert(0 && "unsupported index component type");
+        }
+    }
+};
+
+// Views of the accessors of a primitive. Attributes the primitive doesn't have
+// are empty.
+struct GLTFPrimitiveView {
+    GLTFAccessorView positions;
+    GLTFAccessorView normals;
+    GLTFAccessorView uvs;
+    GLTFAccessorView indices;
+    // Whether the primitive has an index accessor; indices is empty both when
+    // it hasn't and when GetAccessorView rejected it.
+    bool indexed = false;
+    int texture;
+    int material;
+
+    // Bytes per index that the vertex count allows: 2 or 4.
+    unsigned int indexStride() const {
+        return positions.count <= 0x10000 ? sizeof(uint16_t) : sizeof(uint32_t);
+    }
+};
+
+// A mesh primitive referenced by a node of the default scene.
+struct GLTFScenePrimitive {
+    int node;
+    int mesh;
+    int primitive;
+    // Node-to-world transform, flattened from the node hierarchy. Row-vector
+    // convention, like the rest of DirectXMath.
+    XMFLOAT4X4 world;
+};
+
+// Loaded data of a scene primitive.
+struct GLTFSceneMeshData {
+    GLTFPrimitiveData data;
+    XMFLOAT4X4 world;
 };
 
 struct GLTFTextureData {
     string uri;
 };
 
+// The unique images behind a set of textures. A glTF texture pairs an image
+// with a sampler, so several textures may share an image, and several images
+// may resolve to the same DDS file; each of those only needs loading once.
+struct GLTFTextureTable {
+    // One per unique DDS file, in order of first use.
+    vector<GLTFTextureData> images;
+    // Index into images of each texture.
+    vector<int> textureImages;
+
+    // -1 for -1, so that material maps can be remapped directly.
+    int GetImage(int textureIdx) const {
+        return textureIdx < 0 ? -1 : textureImages[textureIdx];
+    }
+};
+
+enum class GLTFAlphaMode {
+    Opaque,
+    // Alpha tested against alphaCutoff.
+    Mask,
+    Blend
+};
+
+// A metallic-roughness material. Maps are indices into LoadTextures' result,
+// -1 if the material doesn't have them; factors default as in the glTF spec.
 struct GLTFMaterialData {
-    int baseColorMap;
-    int normalMap;
+    int baseColorMap = -1;
+    int normalMap = -1;
+    // Roughness in G, metalness in B.
+    int metallicRoughnessMap = -1;
+    int occlusionMap = -1;
+    int emissiveMap = -1;
+    XMFLOAT4 baseColorFactor = { 1.0f, 1.0f, 1.0f, 1.0f };
+    XMFLOAT3 emissiveFactor = { 0.0f, 0.0f, 0.0f };
+    float metallicFactor = 1.0f;
+    float roughnessFactor = 1.0f;
+    float normalScale = 1.0f;
+    float occlusionStrength = 1.0f;
+    GLTFAlphaMode alphaMode = GLTFAlphaMode::Opaque;
+    float alphaCutoff = 0.5f;
+    bool doubleSided = false;
 };
 
 class GLTFLoader {
 public:
     GLTFLoader(string& filename);
 
-    static GLTFPrimitiveData Load(string &filename);
-
-    void LoadModel();
+    // Loads a .gltf or a .glb, told apart by the "glTF" magic of binary files.
+    // External buffers and the BIN chunk of a .glb are memory-mapped instead
+    // of copied by tinygltf, and image pixels aren't decoded (the samples only
+    // use image URIs). Returns false if the file could not be parsed.
+    bool LoadModel();
 
     unsigned int getPrimitiveCount(int nodeIdx = 0) const;
 
     // Loads a single primitive from the specified node.
     GLTFPrimitiveData LoadPrimitive(int nodeIdx, int primitiveIdx) const;
 
+    // Walks the default scene's node hierarchy and returns every primitive of
+    // every node that has a mesh, with the node's world transform. Doesn't
+    // touch vertex data.
+    vector<GLTFScenePrimitive> FlattenScene() const;
+
+    GLTFPrimitiveData LoadPrimitive(const GLTFScenePrimitive &scenePrimitive) const;
+
+    // Loads every primitive of the default scene.
+    vector<GLTFSceneMeshData> LoadScene() const;
+
+    // Views of a primitive's data, for callers that convert straight into
+    // their own vertex layout instead of going through GLTFPrimitiveData.
+    GLTFPrimitiveView GetPrimitiveView(const GLTFScenePrimitive &scenePrimitive) const;
+
+    // Empty if the accessor doesn't fit in its buffer view or the view in its
+    // buffer, e.g. because the .bin is truncated.
+    GLTFAccessorView GetAccessorView(int accessorIdx) const;
+
+    // Paths of the external files that the buffers were loaded from, so that
+    // callers that cache what they convert can tell when one changes.
+    const vector<string> &GetBufferFiles() const;
+
     // Loads all textures.
     vector<GLTFTextureData> LoadTextures();
 
+    // Groups textures by DDS file (compared as normalized paths).
+    static GLTFTextureTable DeduplicateTextures(const vector<GLTFTextureData> &textures);
+
     // Loads all materials.
     vector<GLTFMaterialData> LoadMaterials(
         const std::vector<GLTFTextureData> &textures
@@ -56,33 +251,21 @@ private:
 
     tinygltf::Model mModel;
 
-    void LoadPrimitiveIndices(
-        tinygltf::Primitive &primitive,
-        GLTFPrimitiveData &primitiveData
-    ) const;
-
-    void LoadPrimitivePositions(
-        tinygltf::Primitive &primitive,
-        GLTFPrimitiveData &primitiveData
-    ) const;
-
-    void LoadPrimitiveNormals(
-        tinygltf::Primitive &primitive,
-        GLTFPrimitiveData &primitiveData
-    ) const;
-
-    void LoadPrimitiveUVs(
-        tinygltf::Primitive &primitive,
-        GLTFPrimitiveData &primitiveData
-    ) const;
-
-    void LoadPrimitiveTexture(
-        tinygltf::Primitive &primitive,
-        GLTFPrimitiveData &primitiveData
-    ) const;
-
-    void LoadPrimitiveMaterial(
-      tinygltf::Primitive& primitive,
-      GLTFPrimitiveData& primitiveData
-    ) const;
+    // Bytes of every buffer of mModel: a mapped file, or tinygltf's copy for
+    // embedded buffers and those that hold images. mModel only has
+    // placeholders for the mapped ones, so their lengths are kept here.
+    vector<const uint8_t *> mBufferData;
+    vector<size_t> mBufferSizes;
+    vector<MappedFile> mMappedFiles;
+    vector<string> mBufferFiles;
+
+    bool LoadFromMemory(const uint8_t *bytes, size_t size, string &err, string &warn);
+
+    GLTFPrimitiveData LoadMeshPrimitive(int meshIdx, int primitiveIdx) const;
+
+    GLTFPrimitiveView GetMeshPrimitiveView(int meshIdx, int primitiveIdx) const;
+
+    GLTFAccessorView GetAttributeView(const tinygltf::Primitive &primitive, const char *attribute) const;
+
+    XMMATRIX GetLocalTransform(const tinygltf::Node &node) const;
 };
\ No newline at end of file
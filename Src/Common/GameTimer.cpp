@@ -1,8 +1,38 @@
+#ifdef _WIN32
 // Prevent definition of min and max macros.
 #define NOMINMAX   
 #include <windows.h>
+#else
+#include <chrono>
+#endif
 #include "GameTimer.h"
 
+namespace {
+  // From <profileapi.h>. The performance counter is a high resolution (<1 micro second)
+  // timestamp that can be used for time-interval measurements. The performance counter 
+  // frequency is the number of times it gets incremented in a second (counts per second).
+  // Elsewhere, the steady clock plays the same role.
+  std::int64_t QueryCountsPerSecond() {
+#ifdef _WIN32
+    std::int64_t countsPerSec;
+    QueryPerformanceFrequency((LARGE_INTEGER*)&countsPerSec);
+    return countsPerSec;
+#else
+    return std::chrono::steady_clock::period::den / std::chrono::steady_clock::period::num;
+#endif
+  }
+
+  std::int64_t QueryCounter() {
+#ifdef _WIN32
+    std::int64_t count;
+    QueryPerformanceCounter((LARGE_INTEGER*)&count);
+    return count;
+#else
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+  }
+}
+
 GameTimer::GameTimer()
   : mSecondsPerCount(0.0),
     mDeltaTime(-1.0),
@@ -12,11 +42,7 @@ GameTimer::GameTimer()
     mCurrTime(0),
     mStopped(false) {
 
-  __int64 countsPerSec;
-  // From <profileapi.h>. The performance counter is a high resolution (<1 micro second)
-  // timestamp that can be used for time-interval measurements. The performance counter 
-  // frequency is the number of times it gets incremented in a second (counts per second).
-  QueryPerformanceFrequency((LARGE_INTEGER*)&countsPerSec);
+  std::int64_t countsPerSec = QueryCountsPerSecond();
   mSecondsPerCount = 1.0 / (double)countsPerSec;
 }
 
@@ -33,8 +59,7 @@ float GameTimer::DeltaTime() const {
 }
 
 void GameTimer::Reset() {
-  __int64 currTime;
-  QueryPerformanceCounter((LARGE_INTEGER*)&currTime);
+  std::int64_t currTime = QueryCounter();
   // TODO: base time vs start time?
   mBaseTime = currTime;
   mPrevTime = currTime;
@@ -44,8 +69,7 @@ void GameTimer::Reset() {
 }
 
 void GameTimer::Start() {
-  __int64 startTime;
-  QueryPerformanceCounter((LARGE_INTEGER*)&startTime);
+  std::int64_t startTime = QueryCounter();
   if (mStopped) {
     mPausedTime += (startTime - mStopTime);
     mPrevTime = startTime;
@@ -56,8 +80,7 @@ void GameTimer::Start() {
 
 void GameTimer::Stop() {
   if (!mStopped) {
-    __int64 currTime;
-    QueryPerformanceCounter((LARGE_INTEGER*)&currTime);
+    std::int64_t currTime = QueryCounter();
 
     mStopTime = currTime;
     mStopped = true;
@@ -70,8 +93,7 @@ void GameTimer::Tick() {
     return;
   }
 
-  __int64 currTime;
-  QueryPerformanceCounter((LARGE_INTEGER*)&currTime);
+  std::int64_t currTime = QueryCounter();
   mCurrTime = currTime;
 
   mDeltaTime = (mCurrTime - mPrevTime) * mSecondsPerCount;
@@ -1,6 +1,8 @@
 #ifndef GAMETIMER_H
 #define GAMETIMER_H
 
+#include <cstdint>
+
 class GameTimer {
 private:
   double mSecondsPerCount;
@@ -8,17 +10,17 @@ private:
   // Time elapsed since the last tick, in seconds.
   double mDeltaTime;
 
-  __int64 mBaseTime;
+  std::int64_t mBaseTime;
   // Accumulates the time spent stopped (the timer may be stopped in various
   // noncontiguous intervals); mPausedTime is the sum of the extent of those 
   // intervals.
-  __int64 mPausedTime;
+  std::int64_t mPausedTime;
   // Timestamp (given by the performance counter) of the last time the timer
   // was stopped.
-  __int64 mStopTime;
+  std::int64_t mStopTime;
   // Timestamp of the previous tick.
-  __int64 mPrevTime;
-  __int64 mCurrTime;
+  std::int64_t mPrevTime;
+  std::int64_t mCurrTime;
 
   bool mStopped;
 
@@ -0,0 +1,158 @@
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <utility>
+
+#include "MappedFile.h"
+
+MappedFile::MappedFile(MappedFile&& rhs) noexcept {
+    *this = std::move(rhs);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& rhs) noexcept {
+    if (this != &rhs) {
+        Close();
+
+        std::swap(mData, rhs.mData);
+        std::swap(mSize, rhs.mSize);
+        std::swap(mOpen, rhs.mOpen);
+#ifdef _WIN32
+        std::swap(mFile, rhs.mFile);
+        std::swap(mMapping, rhs.mMapping);
+#endif
+    }
+    return *this;
+}
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const std::string& filename) {
+    Close();
+
+    HANDLE file = CreateFileA(
+        filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr
+    );
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        return false;
+    }
+
+    mFile = file;
+    mSize = static_cast<size_t>(size.QuadPart);
+    mOpen = true;
+
+    // Zero-length files can't be mapped.
+    if (mSize == 0) {
+        return true;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        Close();
+        return false;
+    }
+    mMapping = mapping;
+
+    mData = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!mData) {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void MappedFile::Close() {
+    if (mData) {
+        UnmapViewOfFile(mData);
+    }
+    if (mMapping) {
+        CloseHandle(mMapping);
+    }
+    if (mFile) {
+        CloseHandle(mFile);
+    }
+
+    mData = nullptr;
+    mMapping = nullptr;
+    mFile = nullptr;
+    mSize = 0;
+    mOpen = false;
+}
+
+#else
+
+bool MappedFile::Open(const std::string& filename) {
+    Close();
+
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+
+    mSize = static_cast<size_t>(st.st_size);
+    mOpen = true;
+
+    if (mSize > 0) {
+        void* data = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            mSize = 0;
+            mOpen = false;
+            return false;
+        }
+        madvise(data, mSize, MADV_SEQUENTIAL);
+        mData = static_cast<const uint8_t*>(data);
+    }
+
+    // The mapping keeps its own reference to the file.
+    close(fd);
+    return true;
+}
+
+void MappedFile::Close() {
+    if (mData) {
+        munmap(const_cast<uint8_t*>(mData), mSize);
+    }
+
+    mData = nullptr;
+    mSize = 0;
+    mOpen = false;
+}
+
+#endif
+
+bool MappedFile::IsOpen() const {
+    return mOpen;
+}
+
+const uint8_t* MappedFile::Data() const {
+    return mData;
+}
+
+size_t MappedFile::Size() const {
+    return mSize;
+}
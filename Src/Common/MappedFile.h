@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Read-only view of a whole file mapped into memory. The pages are loaded on
+// first access, so opening a large file is cheap and reading it is bounded by
+// I/O rather than by copies.
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile& rhs) = delete;
+    MappedFile& operator=(const MappedFile& rhs) = delete;
+    MappedFile(MappedFile&& rhs) noexcept;
+    MappedFile& operator=(MappedFile&& rhs) noexcept;
+    ~MappedFile();
+
+    // Returns false if the file doesn't exist or can't be mapped. Empty files
+    // open successfully with a null Data().
+    bool Open(const std::string& filename);
+
+    void Close();
+
+    bool IsOpen() const;
+
+    const uint8_t* Data() const;
+
+    size_t Size() const;
+
+private:
+    const uint8_t* mData = nullptr;
+    size_t mSize = 0;
+    bool mOpen = false;
+
+#ifdef _WIN32
+    void* mFile = nullptr;
+    void* mMapping = nullptr;
+#endif
+};
@@ -1,10 +1,9 @@
 #pragma once
 
-// Prevent definition of min and max macros.
-#define NOMINMAX
-#include <Windows.h>
 #include <DirectXMath.h>
+#include <cfloat>
 #include <cstdint>
+#include <cstdlib>
 
 namespace Math {
 	static const float Pi = 3.1415926535f;
@@ -0,0 +1,178 @@
+#include "MeshCache.h"
+
+#include <filesystem>
+#include <fstream>
+
+namespace MeshCache {
+    namespace {
+        uint64_t AlignTo16(uint64_t offset) {
+            return (offset + 15) & ~uint64_t(15);
+        }
+    }
+
+    bool LoadTextMesh(const std::string& filename, MeshData& mesh) {
+        MeshImport::SourceMesh source;
+        if (!MeshImport::LoadText(filename, source)) {
+            return false;
+        }
+
+        mesh.Optimization = MeshImport::Optimize(source);
+        mesh.Lods = MeshImport::BuildLods(source, MaxLods);
+        MeshImport::GenerateTangents(source);
+        MeshImport::ComputeBounds(source, mesh.BoundsCenter, mesh.BoundsExtents);
+
+        MeshImport::VertexLayout layout;
+        layout.Stride = sizeof(Vertex);
+        layout.PositionOffset = offsetof(Vertex, Pos);
+        layout.NormalOffset = offsetof(Vertex, Normal);
+        layout.TexCOffset = offsetof(Vertex, TexC);
+        layout.TangentOffset = offsetof(Vertex, TangentU);
+
+        mesh.Vertices.resize(source.VertexCount());
+        MeshImport::Pack(source, layout, mesh.Vertices.data());
+
+        mesh.Indices = std::move(source.Indices);
+
+        return true;
+    }
+
+    bool Write(const std::string& filename, const MeshData& mesh) {
+        // Levels of detail go right after the full mesh, in one index buffer.
+        std::vector<Lod> lods;
+        uint32_t lodIndexCount = 0;
+        for (const MeshSimplify::Lod& lod : mesh.Lods) {
+            const uint32_t start = static_cast<uint32_t>(mesh.Indices.size()) + lodIndexCount;
+            lods.push_back({ start, static_cast<uint32_t>(lod.Indices.size()), lod.Error });
+            lodIndexCount += static_cast<uint32_t>(lod.Indices.size());
+        }
+
+        Header header = {};
+        header.Magic = Magic;
+        header.Version = Version;
+        header.VertexCount = static_cast<uint32_t>(mesh.Vertices.size());
+        header.VertexStride = sizeof(Vertex);
+        header.IndexCount = static_cast<uint32_t>(mesh.Indices.size());
+        header.IndexStride = sizeof(uint32_t);
+        header.LodIndexCount = lodIndexCount;
+        header.LodCount = static_cast<uint32_t>(lods.size());
+        header.BoundsCenter = mesh.BoundsCenter;
+        header.BoundsExtents = mesh.BoundsExtents;
+        header.VertexOffset = AlignTo16(sizeof(Header));
+        header.IndexOffset = AlignTo16(header.VertexOffset + uint64_t(header.VertexCount) * header.VertexStride);
+        header.LodOffset = AlignTo16(header.IndexOffset + (uint64_t(header.IndexCount) + header.LodIndexCount) * header.IndexStride);
+
+        // Write to a temporary file and rename it, so that a reader never maps
+        // a half-written cache. A failed write leaves neither behind.
+        std::string tempFilename = filename + ".tmp";
+        bool written = false;
+        {
+            std::ofstream fout(tempFilename, std::ios::binary | std::ios::trunc);
+            const char padding[16] = {};
+
+            fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            fout.write(padding, header.VertexOffset - sizeof(header));
+            fout.write(reinterpret_cast<const char*>(mesh.Vertices.data()), mesh.Vertices.size() * sizeof(Vertex));
+            fout.write(padding, header.IndexOffset - (header.VertexOffset + mesh.Vertices.size() * sizeof(Vertex)));
+            fout.write(reinterpret_cast<const char*>(mesh.Indices.data()), mesh.Indices.size() * sizeof(uint32_t));
+            for (const MeshSimplify::Lod& lod : mesh.Lods) {
+                fout.write(reinterpret_cast<const char*>(lod.Indices.data()), lod.Indices.size() * sizeof(uint32_t));
+            }
+            fout.write(padding, header.LodOffset - (header.IndexOffset + (uint64_t(header.IndexCount) + header.LodIndexCount) * header.IndexStride));
+            fout.write(reinterpret_cast<const char*>(lods.data()), lods.size() * sizeof(Lod));
+
+            fout.close();
+            written = !fout.fail();
+        }
+
+        std::error_code ec;
+        if (written) {
+            std::filesystem::rename(tempFilename, filename, ec);
+        }
+        if (!written || ec) {
+            std::filesystem::remove(tempFilename, ec);
+            return false;
+        }
+        return true;
+    }
+
+    bool ConvertTextMesh(const std::string& textFilename, const std::string& cacheFilename) {
+        MeshData mesh;
+        if (!LoadTextMesh(textFilename, mesh)) {
+            return false;
+        }
+        return Write(cacheFilename, mesh);
+    }
+
+    bool File::Open(const std::string& filename) {
+        mHeader = nullptr;
+
+        if (!mFile.Open(filename) || mFile.Size() < sizeof(Header)) {
+            mFile.Close();
+            return false;
+        }
+
+        auto header = reinterpret_cast<const Header*>(mFile.Data());
+        bool valid =
+            header->Magic == Magic &&
+            header->Version == Version &&
+            header->VertexStride == sizeof(Vertex) &&
+            header->IndexStride == sizeof(uint32_t) &&
+            header->VertexOffset >= sizeof(Header) &&
+            header->VertexOffset + uint64_t(header->VertexCount) * header->VertexStride <= header->IndexOffset &&
+            header->IndexOffset + (uint64_t(header->IndexCount) + header->LodIndexCount) * header->IndexStride <= header->LodOffset &&
+            header->LodOffset + uint64_t(header->LodCount) * sizeof(Lod) <= mFile.Size();
+
+        auto lods = reinterpret_cast<const Lod*>(mFile.Data() + header->LodOffset);
+        for (uint32_t i = 0; valid && i < header->LodCount; ++i) {
+            valid = uint64_t(lods[i].StartIndexLocation) + lods[i].IndexCount <= uint64_t(header->IndexCount) + header->LodIndexCount;
+        }
+
+        if (!valid) {
+            mFile.Close();
+            return false;
+        }
+
+        mHeader = header;
+        return true;
+    }
+
+    const Header& File::GetHeader() const {
+        return *mHeader;
+    }
+
+    const void* File::VertexData() const {
+        return mFile.Data() + mHeader->VertexOffset;
+    }
+
+    size_t File::VertexDataSize() const {
+        return size_t(mHeader->VertexCount) * mHeader->VertexStride;
+    }
+
+    const void* File::IndexData() const {
+        return mFile.Data() + mHeader->IndexOffset;
+    }
+
+    size_t File::IndexDataSize() const {
+        return (size_t(mHeader->IndexCount) + mHeader->LodIndexCount) * mHeader->IndexStride;
+    }
+
+    const Lod* File::Lods() const {
+        return reinterpret_cast<const Lod*>(mFile.Data() + mHeader->LodOffset);
+    }
+
+    bool OpenOrConvert(const std::string& textFilename, const std::string& cacheFilename, File& file) {
+        std::error_code ec;
+        auto cacheTime = std::filesystem::last_write_time(cacheFilename, ec);
+        bool stale = static_cast<bool>(ec);
+        if (!stale) {
+            auto textTime = std::filesystem::last_write_time(textFilename, ec);
+            stale = !ec && textTime > cacheTime;
+        }
+
+        if (!stale && file.Open(cacheFilename)) {
+            return true;
+        }
+
+        return ConvertTextMesh(textFilename, cacheFilename) && file.Open(cacheFilename);
+    }
+};
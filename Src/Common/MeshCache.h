@@ -0,0 +1,110 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+#include "MeshImport.h"
+
+// Binary cache of the text meshes in Assets (car.txt, skull.txt). A cache file
+// holds the vertex and index buffers exactly as the samples upload them, plus
+// precomputed bounds and levels of detail, so loading one is a memory map and
+// a copy.
+//
+// File layout (little endian): a Header, then VertexCount vertices of
+// VertexStride bytes at VertexOffset, then IndexCount uint32 indices of the
+// full mesh and LodIndexCount of its levels of detail at IndexOffset, then
+// LodCount Lod structs at LodOffset. Every offset is 16-byte aligned.
+namespace MeshCache {
+    // "MESH".
+    const uint32_t Magic = 0x4853454D;
+
+    // Bump when Header or Vertex change, or the import orders the data
+    // differently; caches of other versions are rebuilt.
+    const uint32_t Version = 3;
+
+    // Levels of detail that LoadTextMesh builds, at most.
+    const int MaxLods = 4;
+
+    // Same layout as the Vertex of the samples that use tangents.
+    struct Vertex {
+        DirectX::XMFLOAT3 Pos;
+        DirectX::XMFLOAT3 Normal;
+        DirectX::XMFLOAT2 TexC;
+        DirectX::XMFLOAT3 TangentU;
+    };
+
+    struct Header {
+        uint32_t Magic;
+        uint32_t Version;
+        uint32_t VertexCount;
+        uint32_t VertexStride;
+        uint32_t IndexCount;
+        uint32_t IndexStride;
+        uint32_t LodIndexCount;
+        uint32_t LodCount;
+        DirectX::XMFLOAT3 BoundsCenter;
+        DirectX::XMFLOAT3 BoundsExtents;
+        uint64_t VertexOffset;
+        uint64_t IndexOffset;
+        uint64_t LodOffset;
+    };
+
+    // A simplified index list of the mesh, finest first; the range is in the
+    // index buffer, after the full mesh.
+    struct Lod {
+        uint32_t StartIndexLocation;
+        uint32_t IndexCount;
+        // Of the simplified surface, in mesh units (see MeshSimplify::Lod).
+        float Error;
+    };
+
+    struct MeshData {
+        std::vector<Vertex> Vertices;
+        std::vector<uint32_t> Indices;
+        DirectX::XMFLOAT3 BoundsCenter = { 0.0f, 0.0f, 0.0f };
+        DirectX::XMFLOAT3 BoundsExtents = { 0.0f, 0.0f, 0.0f };
+        // Up to MaxLods levels, over the same vertices.
+        std::vector<MeshSimplify::Lod> Lods;
+        // Not stored in the cache.
+        MeshImport::OptimizeReport Optimization;
+    };
+
+    // Runs a text mesh through the MeshImport pipeline, reordering and levels
+    // of detail included, into the cache's vertex layout.
+    bool LoadTextMesh(const std::string& filename, MeshData& mesh);
+
+    bool Write(const std::string& filename, const MeshData& mesh);
+
+    bool ConvertTextMesh(const std::string& textFilename, const std::string& cacheFilename);
+
+    // A cache file mapped into memory. The data pointers point into the
+    // mapping and are valid while the File is open.
+    class File {
+    public:
+        // Fails if the file is missing, truncated or of another version.
+        bool Open(const std::string& filename);
+
+        const Header& GetHeader() const;
+
+        const void* VertexData() const;
+        size_t VertexDataSize() const;
+
+        // The indices of the full mesh and of every level of detail.
+        const void* IndexData() const;
+        size_t IndexDataSize() const;
+
+        const Lod* Lods() const;
+
+    private:
+        MappedFile mFile;
+        const Header* mHeader = nullptr;
+    };
+
+    // Opens cacheFilename, first (re)building it from textFilename if it is
+    // missing, stale or of another version.
+    bool OpenOrConvert(const std::string& textFilename, const std::string& cacheFilename, File& file);
+};
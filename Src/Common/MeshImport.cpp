@@ -0,0 +1,547 @@
+#include "MeshImport.h"
+
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+
+#include "GLTFLoader.h"
+#include "Math.h"
+#include "ThreadPool.h"
+
+using namespace DirectX;
+
+namespace MeshImport {
+    namespace {
+        // Cursor over the text of a mesh file.
+        class TextReader {
+        public:
+            TextReader(const char* begin, const char* end) : mCurr(begin), mEnd(end) {}
+
+            // Skips the next whitespace-delimited token.
+            bool SkipToken() {
+                SkipWhitespace();
+                const char* start = mCurr;
+                while (mCurr < mEnd && !IsWhitespace(*mCurr)) {
+                    ++mCurr;
+                }
+                return mCurr != start;
+            }
+
+            template<typename T>
+            bool Read(T& value) {
+                SkipWhitespace();
+                auto result = std::from_chars(mCurr, mEnd, value);
+                if (result.ec != std::errc()) {
+                    return false;
+                }
+                mCurr = result.ptr;
+                return true;
+            }
+
+        private:
+            const char* mCurr;
+            const char* mEnd;
+
+            static bool IsWhitespace(char c) {
+                return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+            }
+
+            void SkipWhitespace() {
+                while (mCurr < mEnd && IsWhitespace(*mCurr)) {
+                    ++mCurr;
+                }
+            }
+        };
+
+        // Triangles or vertices per task of the tangent passes.
+        const int TangentGrain = 4096;
+
+        void FallbackTangent(const XMFLOAT3& normal, XMFLOAT3& tangent) {
+            XMVECTOR N = XMLoadFloat3(&normal);
+
+            XMVECTOR up = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+            if (fabsf(XMVectorGetX(XMVector3Dot(N, up))) < 1.0f - 0.001f) {
+                XMStoreFloat3(&tangent, XMVector3Normalize(XMVector3Cross(up, N)));
+            } else {
+                up = XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f);
+                XMStoreFloat3(&tangent, XMVector3Normalize(XMVector3Cross(N, up)));
+            }
+        }
+
+        // Angle between the unit vectors a and b.
+        float Angle(FXMVECTOR a, FXMVECTOR b) {
+            float c = XMVectorGetX(XMVector3Dot(a, b));
+            return acosf(c < -1.0f ? -1.0f : (c > 1.0f ? 1.0f : c));
+        }
+
+        bool IsIdentity(const XMFLOAT4X4& m) {
+            static const XMFLOAT4X4 identity = Options().Transform;
+            return memcmp(&m, &identity, sizeof(m)) == 0;
+        }
+
+        // The rest of FromGLTF once the attributes and indices are copied:
+        // a primitive without indices draws its vertices in order, and every
+        // later stage indexes the attributes with the indices, so they must
+        // make whole triangles of vertices that exist.
+        bool FinishGLTF(SourceMesh& mesh) {
+            if (mesh.Positions.empty()) {
+                return false;
+            }
+
+            if (mesh.Indices.empty()) {
+                mesh.Indices.resize(mesh.VertexCount());
+                std::iota(mesh.Indices.begin(), mesh.Indices.end(), 0u);
+            }
+            if (mesh.Indices.size() % 3 != 0) {
+                return false;
+            }
+            for (uint32_t index : mesh.Indices) {
+                if (index >= mesh.VertexCount()) {
+                    return false;
+                }
+            }
+
+            if (mesh.Normals.size() != mesh.VertexCount()) {
+                GenerateFlatNormals(mesh);
+            }
+            return true;
+        }
+    }
+
+    bool LoadText(const std::string& filename, SourceMesh& mesh) {
+        std::vector<char> text;
+        {
+            std::ifstream fin(filename, std::ios::binary | std::ios::ate);
+            if (!fin) {
+                return false;
+            }
+
+            text.resize(static_cast<size_t>(fin.tellg()));
+            fin.seekg(0);
+            if (!fin.read(text.data(), text.size())) {
+                return false;
+            }
+        }
+
+        TextReader reader(text.data(), text.data() + text.size());
+
+        uint32_t vcount = 0;
+        uint32_t tcount = 0;
+
+        // VertexCount: N
+        // TriangleCount: M
+        // VertexList (pos, normal)
+        // {
+        bool ok =
+            reader.SkipToken() && reader.Read(vcount) &&
+            reader.SkipToken() && reader.Read(tcount) &&
+            reader.SkipToken() && reader.SkipToken() && reader.SkipToken() && reader.SkipToken();
+        if (!ok) {
+            return false;
+        }
+
+        // Every number takes at least a digit and a separator, so a header
+        // that claims more than the file can hold is corrupt; don't allocate
+        // for it.
+        if (vcount > text.size() / (6 * 2) || tcount > text.size() / (3 * 2)) {
+            return false;
+        }
+
+        mesh = SourceMesh();
+        mesh.Positions.resize(vcount);
+        mesh.Normals.resize(vcount);
+        for (uint32_t i = 0; i < vcount; ++i) {
+            XMFLOAT3& p = mesh.Positions[i];
+            XMFLOAT3& n = mesh.Normals[i];
+            ok =
+                reader.Read(p.x) && reader.Read(p.y) && reader.Read(p.z) &&
+                reader.Read(n.x) && reader.Read(n.y) && reader.Read(n.z);
+            if (!ok) {
+                return false;
+            }
+        }
+
+        // }
+        // TriangleList
+        // {
+        if (!(reader.SkipToken() && reader.SkipToken() && reader.SkipToken())) {
+            return false;
+        }
+
+        mesh.Indices.resize(3 * size_t(tcount));
+        for (uint32_t& index : mesh.Indices) {
+            if (!reader.Read(index) || index >= vcount) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool FromGLTF(const GLTFPrimitiveData& primitive, SourceMesh& mesh) {
+        mesh.Positions = primitive.positions;
+        mesh.Normals = primitive.normals;
+        mesh.TexCoords = primitive.uvs;
+        mesh.Tangents.clear();
+        if (primitive.indices32.empty()) {
+            mesh.Indices.assign(primitive.indices16.begin(), primitive.indices16.end());
+        } else {
+            mesh.Indices = primitive.indices32;
+        }
+
+        return FinishGLTF(mesh);
+    }
+
+    bool FromGLTF(const GLTFPrimitiveView& primitive, SourceMesh& mesh) {
+        mesh.Positions.resize(primitive.positions.count);
+        primitive.positions.DecodeTo(reinterpret_cast<float*>(mesh.Positions.data()), 3, sizeof(XMFLOAT3));
+
+        mesh.Normals.resize(primitive.normals.count);
+        primitive.normals.DecodeTo(reinterpret_cast<float*>(mesh.Normals.data()), 3, sizeof(XMFLOAT3));
+
+        mesh.TexCoords.resize(primitive.uvs.count);
+        primitive.uvs.DecodeTo(reinterpret_cast<float*>(mesh.TexCoords.data()), 2, sizeof(XMFLOAT2));
+
+        mesh.Tangents.clear();
+
+        mesh.Indices.resize(primitive.indices.count);
+        primitive.indices.CopyIndicesTo(mesh.Indices.data());
+
+        // An index accessor that GetAccessorView rejected.
+        if (primitive.indexed && primitive.indices.empty()) {
+            return false;
+        }
+
+        return FinishGLTF(mesh);
+    }
+
+    void GenerateFlatNormals(SourceMesh& mesh) {
+        const bool hasTexCoords = mesh.TexCoords.size() == mesh.VertexCount();
+
+        SourceMesh flat;
+        flat.Positions.resize(mesh.Indices.size());
+        flat.Normals.resize(mesh.Indices.size());
+        if (hasTexCoords) {
+            flat.TexCoords.resize(mesh.Indices.size());
+        }
+        flat.Indices.resize(mesh.Indices.size());
+
+        for (size_t t = 0; t + 2 < mesh.Indices.size(); t += 3) {
+            const uint32_t* tri = &mesh.Indices[t];
+            XMVECTOR p0 = XMLoadFloat3(&mesh.Positions[tri[0]]);
+            XMVECTOR p1 = XMLoadFloat3(&mesh.Positions[tri[1]]);
+            XMVECTOR p2 = XMLoadFloat3(&mesh.Positions[tri[2]]);
+            XMFLOAT3 normal;
+            XMStoreFloat3(&normal, XMVector3Normalize(XMVector3Cross(p1 - p0, p2 - p0)));
+
+            for (size_t k = 0; k < 3; ++k) {
+                flat.Positions[t + k] = mesh.Positions[tri[k]];
+                flat.Normals[t + k] = normal;
+                if (hasTexCoords) {
+                    flat.TexCoords[t + k] = mesh.TexCoords[tri[k]];
+                }
+                flat.Indices[t + k] = static_cast<uint32_t>(t + k);
+            }
+        }
+
+        mesh = std::move(flat);
+    }
+
+    void Transform(SourceMesh& mesh, FXMMATRIX transform) {
+        XMMATRIX normalTransform = XMMatrixTranspose(XMMatrixInverse(nullptr, transform));
+
+        for (XMFLOAT3& p : mesh.Positions) {
+            XMStoreFloat3(&p, XMVector3TransformCoord(XMLoadFloat3(&p), transform));
+        }
+        for (XMFLOAT3& n : mesh.Normals) {
+            XMStoreFloat3(&n, XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&n), normalTransform)));
+        }
+        for (XMFLOAT3& t : mesh.Tangents) {
+            XMStoreFloat3(&t, XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&t), transform)));
+        }
+    }
+
+    OptimizeReport Optimize(SourceMesh& mesh) {
+        OptimizeReport report;
+        report.Before = MeshOptimize::SimulateVertexCache(mesh.Indices, mesh.VertexCount(), MeshOptimize::CacheModel::FIFO);
+
+        // Exporters that already order for the cache can beat Tipsify's small
+        // FIFO target; their order is kept then, as is. The overdraw pass
+        // splits clusters at Tipsify's fans and would only degrade it.
+        std::vector<uint32_t> indices = mesh.Indices;
+        MeshOptimize::OptimizeVertexCache(indices, mesh.VertexCount());
+        if (MeshOptimize::SimulateVertexCache(indices, mesh.VertexCount(), MeshOptimize::CacheModel::FIFO).Misses < report.Before.Misses) {
+            MeshOptimize::OptimizeOverdraw(indices, mesh.Positions);
+            mesh.Indices.swap(indices);
+        }
+
+        std::vector<uint32_t> remap = MeshOptimize::OptimizeVertexFetch(mesh.Indices, mesh.VertexCount());
+        MeshOptimize::RemapVertices(mesh.Positions, remap);
+        MeshOptimize::RemapVertices(mesh.Normals, remap);
+        MeshOptimize::RemapVertices(mesh.TexCoords, remap);
+        MeshOptimize::RemapVertices(mesh.Tangents, remap);
+
+        report.After = MeshOptimize::SimulateVertexCache(mesh.Indices, mesh.VertexCount(), MeshOptimize::CacheModel::FIFO);
+        return report;
+    }
+
+    std::vector<MeshSimplify::Lod> BuildLods(const SourceMesh& mesh, int maxLods) {
+        std::vector<MeshSimplify::Lod> lods =
+            MeshSimplify::BuildLodChain(mesh.Indices, mesh.Positions, mesh.Normals, mesh.TexCoords, maxLods);
+        for (MeshSimplify::Lod& lod : lods) {
+            MeshOptimize::OptimizeVertexCache(lod.Indices, mesh.VertexCount());
+        }
+        return lods;
+    }
+
+    void GenerateTangents(SourceMesh& mesh) {
+        GenerateTangents(mesh, ThreadPool::Default());
+    }
+
+    void GenerateTangents(SourceMesh& mesh, ThreadPool& pool) {
+        const size_t vertexCount = mesh.VertexCount();
+        mesh.Tangents.resize(vertexCount);
+
+        if (mesh.TexCoords.size() != vertexCount) {
+            for (size_t i = 0; i < vertexCount; ++i) {
+                FallbackTangent(mesh.Normals[i], mesh.Tangents[i]);
+            }
+            return;
+        }
+
+        const std::vector<uint32_t>& indices = mesh.Indices;
+        const int triangleCount = static_cast<int>(indices.size() / 3);
+
+        // Weighted tangent of every triangle corner. Corners are written by
+        // their own triangle only, so the triangle pass needs no atomics.
+        std::vector<XMFLOAT3> cornerTangents(3 * size_t(triangleCount));
+
+        pool.ParallelFor(0, triangleCount, TangentGrain, [&](int begin, int end) {
+            for (int t = begin; t < end; ++t) {
+                const uint32_t* tri = &indices[3 * size_t(t)];
+
+                XMVECTOR P[3], UV[3];
+                for (int k = 0; k < 3; ++k) {
+                    P[k] = XMLoadFloat3(&mesh.Positions[tri[k]]);
+                    UV[k] = XMLoadFloat2(&mesh.TexCoords[tri[k]]);
+                }
+
+                XMVECTOR e1 = P[1] - P[0];
+                XMVECTOR e2 = P[2] - P[0];
+                XMFLOAT2 duv1, duv2;
+                XMStoreFloat2(&duv1, UV[1] - UV[0]);
+                XMStoreFloat2(&duv2, UV[2] - UV[0]);
+
+                // dP/du of the triangle; zero if its UVs don't span an area.
+                float det = duv1.x*duv2.y - duv2.x*duv1.y;
+                XMVECTOR faceT = XMVectorZero();
+                if (fabsf(det) > 1e-20f) {
+                    faceT = (e1*duv2.y - e2*duv1.y) / det;
+                }
+
+                for (int k = 0; k < 3; ++k) {
+                    XMVECTOR N = XMLoadFloat3(&mesh.Normals[tri[k]]);
+                    XMVECTOR T = XMVector3Normalize(faceT - XMVector3Dot(faceT, N)*N);
+
+                    XMVECTOR a = XMVector3Normalize(P[(k + 1) % 3] - P[k]);
+                    XMVECTOR b = XMVector3Normalize(P[(k + 2) % 3] - P[k]);
+
+                    // XMVector3Normalize of a zero vector is zero, so degenerate
+                    // corners contribute nothing.
+                    XMStoreFloat3(&cornerTangents[3 * size_t(t) + k], T*Angle(a, b));
+                }
+            }
+        });
+
+        // Corners of every vertex, as offsets into a flat list (CSR).
+        std::vector<uint32_t> cornerStart(vertexCount + 1, 0);
+        for (uint32_t index : indices) {
+            ++cornerStart[index + 1];
+        }
+        for (size_t i = 0; i < vertexCount; ++i) {
+            cornerStart[i + 1] += cornerStart[i];
+        }
+
+        std::vector<uint32_t> corners(3 * size_t(triangleCount));
+        {
+            std::vector<uint32_t> next(cornerStart.begin(), cornerStart.end() - 1);
+            for (size_t c = 0; c < corners.size(); ++c) {
+                corners[next[indices[c]]++] = static_cast<uint32_t>(c);
+            }
+        }
+
+        // Gathering in corner order keeps the sums deterministic.
+        pool.ParallelFor(0, static_cast<int>(vertexCount), TangentGrain, [&](int begin, int end) {
+            for (int v = begin; v < end; ++v) {
+                XMVECTOR sum = XMVectorZero();
+                for (uint32_t c = cornerStart[v]; c < cornerStart[v + 1]; ++c) {
+                    sum += XMLoadFloat3(&cornerTangents[corners[c]]);
+                }
+
+                XMVECTOR N = XMLoadFloat3(&mesh.Normals[v]);
+                XMVECTOR T = sum - XMVector3Dot(sum, N)*N;
+                if (XMVectorGetX(XMVector3LengthSq(T)) > 1e-12f) {
+                    XMStoreFloat3(&mesh.Tangents[v], XMVector3Normalize(T));
+                } else {
+                    FallbackTangent(mesh.Normals[v], mesh.Tangents[v]);
+                }
+            }
+        });
+    }
+
+    void ComputeBounds(const SourceMesh& mesh, XMFLOAT3& center, XMFLOAT3& extents) {
+        XMFLOAT3 vMinf3(+Math::Infinity, +Math::Infinity, +Math::Infinity);
+        XMFLOAT3 vMaxf3(-Math::Infinity, -Math::Infinity, -Math::Infinity);
+
+        XMVECTOR vMin = XMLoadFloat3(&vMinf3);
+        XMVECTOR vMax = XMLoadFloat3(&vMaxf3);
+
+        for (const XMFLOAT3& p : mesh.Positions) {
+            XMVECTOR P = XMLoadFloat3(&p);
+            vMin = XMVectorMin(vMin, P);
+            vMax = XMVectorMax(vMax, P);
+        }
+
+        XMStoreFloat3(&center, 0.5f*(vMin + vMax));
+        XMStoreFloat3(&extents, 0.5f*(vMax - vMin));
+    }
+
+    void Pack(const SourceMesh& mesh, const VertexLayout& layout, void* dst) {
+        const size_t vertexCount = mesh.VertexCount();
+        const bool hasTexC = mesh.TexCoords.size() == vertexCount;
+        const bool hasTangents = mesh.Tangents.size() == vertexCount;
+        const XMFLOAT3 zero3(0.0f, 0.0f, 0.0f);
+        const XMFLOAT2 zero2(0.0f, 0.0f);
+
+        uint8_t* out = static_cast<uint8_t*>(dst);
+        for (size_t i = 0; i < vertexCount; ++i, out += layout.Stride) {
+            if (layout.PositionOffset >= 0) {
+                memcpy(out + layout.PositionOffset, &mesh.Positions[i], sizeof(XMFLOAT3));
+            }
+            if (layout.NormalOffset >= 0) {
+                memcpy(out + layout.NormalOffset, &mesh.Normals[i], sizeof(XMFLOAT3));
+            }
+            if (layout.TexCOffset >= 0) {
+                memcpy(out + layout.TexCOffset, hasTexC ? &mesh.TexCoords[i] : &zero2, sizeof(XMFLOAT2));
+            }
+            if (layout.TangentOffset >= 0) {
+                memcpy(out + layout.TangentOffset, hasTangents ? &mesh.Tangents[i] : &zero3, sizeof(XMFLOAT3));
+            }
+        }
+    }
+
+    void Pack(const SourceMesh& mesh, const VertexLayout& layout, Mesh& output) {
+        ComputeBounds(mesh, output.BoundsCenter, output.BoundsExtents);
+
+        output.VertexCount = static_cast<uint32_t>(mesh.VertexCount());
+        output.VertexStride = static_cast<uint32_t>(layout.Stride);
+        output.VertexData.resize(size_t(output.VertexCount) * output.VertexStride);
+        Pack(mesh, layout, output.VertexData.data());
+
+        output.IndexCount = static_cast<uint32_t>(mesh.Indices.size());
+        if (mesh.VertexCount() <= 0x10000) {
+            output.IndexStride = sizeof(uint16_t);
+            output.IndexData.resize(size_t(output.IndexCount) * sizeof(uint16_t));
+            uint16_t* indices16 = reinterpret_cast<uint16_t*>(output.IndexData.data());
+            for (size_t i = 0; i < mesh.Indices.size(); ++i) {
+                indices16[i] = static_cast<uint16_t>(mesh.Indices[i]);
+            }
+        } else {
+            output.IndexStride = sizeof(uint32_t);
+            output.IndexData.resize(size_t(output.IndexCount) * sizeof(uint32_t));
+            memcpy(output.IndexData.data(), mesh.Indices.data(), output.IndexData.size());
+        }
+    }
+
+    bool Import(const std::string& filename, const VertexLayout& layout, const Options& options, Mesh& mesh) {
+        SourceMesh source;
+        if (!LoadText(filename, source)) {
+            return false;
+        }
+
+        if (!IsIdentity(options.Transform)) {
+            Transform(source, XMLoadFloat4x4(&options.Transform));
+        }
+
+        OptimizeReport report;
+        if (options.Optimize) {
+            report = Optimize(source);
+        }
+
+        Meshlets::MeshletData meshlets;
+        if (options.BuildMeshlets) {
+            Meshlets::Build(source.Indices, source.Positions, meshlets);
+        }
+
+        std::vector<MeshSimplify::Lod> lods;
+        if (options.MaxLods > 0) {
+            lods = BuildLods(source, options.MaxLods);
+        }
+
+        if (options.GenerateTangents) {
+            GenerateTangents(source);
+        }
+
+        Pack(source, layout, mesh);
+        mesh.Optimization = report;
+        mesh.Meshlets = std::move(meshlets);
+        mesh.Lods = std::move(lods);
+
+        return true;
+    }
+
+    std::vector<ScenePrimitive> ImportScene(const GLTFLoader& loader, const VertexLayout& layout, const Options& options) {
+        return ImportScene(loader, layout, options, ThreadPool::Default());
+    }
+
+    std::vector<ScenePrimitive> ImportScene(
+        const GLTFLoader& loader, const VertexLayout& layout, const Options& options, ThreadPool& pool
+    ) {
+        std::vector<GLTFScenePrimitive> scenePrimitives = loader.FlattenScene();
+        std::vector<ScenePrimitive> primitives(scenePrimitives.size());
+
+        const XMMATRIX transform = XMLoadFloat4x4(&options.Transform);
+
+        // One primitive per task; each writes its own slot, so the order
+        // doesn't depend on scheduling. Tangent generation nests its own
+        // ParallelFor on the same pool, which large primitives benefit from.
+        pool.ParallelFor(0, static_cast<int>(scenePrimitives.size()), 1, [&](int begin, int end) {
+            for (int i = begin; i < end; ++i) {
+                GLTFPrimitiveView view = loader.GetPrimitiveView(scenePrimitives[i]);
+
+                // A malformed primitive is left empty, with no indices to draw.
+                SourceMesh mesh;
+                if (!FromGLTF(view, mesh)) {
+                    continue;
+                }
+                Transform(mesh, XMLoadFloat4x4(&scenePrimitives[i].world) * transform);
+
+                OptimizeReport report;
+                if (options.Optimize) {
+                    report = Optimize(mesh);
+                }
+
+                if (options.BuildMeshlets) {
+                    Meshlets::Build(mesh.Indices, mesh.Positions, primitives[i].Geometry.Meshlets);
+                }
+
+                if (options.MaxLods > 0) {
+                    primitives[i].Geometry.Lods = BuildLods(mesh, options.MaxLods);
+                }
+
+                if (options.GenerateTangents) {
+                    GenerateTangents(mesh, pool);
+                }
+
+                Pack(mesh, layout, primitives[i].Geometry);
+                primitives[i].Geometry.Optimization = report;
+                primitives[i].Material = view.material;
+                primitives[i].Texture = view.texture;
+            }
+        });
+
+        return primitives;
+    }
+};
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MeshOptimize.h"
+#include "MeshSimplify.h"
+#include "Meshlets.h"
+
+class GLTFLoader;
+class ThreadPool;
+struct GLTFPrimitiveData;
+struct GLTFPrimitiveView;
+
+// CPU side of getting a mesh file onto the GPU, shared by the samples:
+//
+//   load -> optional transform -> reorder -> [meshlets] -> [LODs] -> tangents -> bounds -> packed vertices
+//
+// Each stage is a function over a SourceMesh so that it can be benchmarked or
+// replaced on its own. Nothing here depends on D3D; the packed output is plain
+// bytes laid out as the caller's vertex struct.
+namespace MeshImport {
+    // Unpacked vertex attributes. Attributes that the file doesn't have are
+    // empty until a stage fills them.
+    struct SourceMesh {
+        std::vector<DirectX::XMFLOAT3> Positions;
+        std::vector<DirectX::XMFLOAT3> Normals;
+        std::vector<DirectX::XMFLOAT2> TexCoords;
+        std::vector<DirectX::XMFLOAT3> Tangents;
+        std::vector<uint32_t> Indices;
+
+        size_t VertexCount() const { return Positions.size(); }
+    };
+
+    // Byte offsets of the attributes within the caller's vertex struct; -1
+    // leaves an attribute out.
+    struct VertexLayout {
+        int Stride = 0;
+        int PositionOffset = -1;  // float3
+        int NormalOffset = -1;    // float3
+        int TexCOffset = -1;      // float2, zero if the mesh has none
+        int TangentOffset = -1;   // float3, zero if the mesh has none
+    };
+
+    struct Options {
+        // Applied to positions, and as its inverse transpose to normals.
+        DirectX::XMFLOAT4X4 Transform = {
+            1.0f, 0.0f, 0.0f, 0.0f,
+            0.0f, 1.0f, 0.0f, 0.0f,
+            0.0f, 0.0f, 1.0f, 0.0f,
+            0.0f, 0.0f, 0.0f, 1.0f
+        };
+
+        bool GenerateTangents = true;
+
+        // Reorders triangles and vertices for the post-transform cache, for
+        // overdraw and for vertex fetch (see Optimize).
+        bool Optimize = true;
+
+        // Splits the mesh into meshlets (see Meshlets.h), after reordering.
+        bool BuildMeshlets = false;
+
+        // Simplified index lists to draw in place of the full ones from far
+        // away (see BuildLods); 0 builds none.
+        int MaxLods = 0;
+    };
+
+    // Vertex cache efficiency of a mesh before and after Optimize, simulated
+    // with a FIFO cache of MeshOptimize::DefaultCacheSize entries.
+    struct OptimizeReport {
+        MeshOptimize::CacheStats Before;
+        MeshOptimize::CacheStats After;
+    };
+
+    struct Mesh {
+        std::vector<uint8_t> VertexData;
+        uint32_t VertexCount = 0;
+        uint32_t VertexStride = 0;
+        // 16-bit indices when the vertex count allows it, 32-bit otherwise.
+        std::vector<uint8_t> IndexData;
+        uint32_t IndexCount = 0;
+        uint32_t IndexStride = 0;
+        DirectX::XMFLOAT3 BoundsCenter = { 0.0f, 0.0f, 0.0f };
+        DirectX::XMFLOAT3 BoundsExtents = { 0.0f, 0.0f, 0.0f };
+        // Left empty when Options::Optimize is off.
+        OptimizeReport Optimization;
+        // Left empty when Options::BuildMeshlets is off. Vertex indices are
+        // relative to the mesh, like the indices in IndexData.
+        Meshlets::MeshletData Meshlets;
+        // Coarser index lists over the same vertices, finest first, and each
+        // with its error in the units of the positions. Empty when
+        // Options::MaxLods is 0.
+        std::vector<MeshSimplify::Lod> Lods;
+    };
+
+    // A primitive of a glTF scene, ready to upload.
+    struct ScenePrimitive {
+        Mesh Geometry;
+        int Material = -1;
+        int Texture = -1;
+    };
+
+    // Loads the text format of Assets/car.txt and Assets/skull.txt (positions,
+    // normals and triangles). The file is read in one go and parsed with
+    // std::from_chars. Fails on counts larger than the file can hold and on
+    // indices past the last vertex.
+    bool LoadText(const std::string& filename, SourceMesh& mesh);
+
+    // Copies the attributes and indices of a primitive loaded by GLTFLoader.
+    bool FromGLTF(const GLTFPrimitiveData& primitive, SourceMesh& mesh);
+
+    // Same, reading straight out of the glTF buffers.
+    //
+    // Both generate flat normals (see GenerateFlatNormals) for a primitive
+    // without NORMAL, as the glTF spec requires, so that every later stage can
+    // count on them, and indices 0..n-1 for one without indices. Both fail on
+    // a primitive without positions (e.g. because GetAccessorView rejected
+    // them), on an index count that isn't a multiple of 3 and on indices past
+    // the last vertex.
+    bool FromGLTF(const GLTFPrimitiveView& primitive, SourceMesh& mesh);
+
+    // Gives every triangle corner a vertex of its own with the normal of its
+    // triangle. Drops tangents, which are generated afterwards.
+    void GenerateFlatNormals(SourceMesh& mesh);
+
+    void Transform(SourceMesh& mesh, DirectX::FXMMATRIX transform);
+
+    // Runs the MeshOptimize passes: vertex cache order and then overdraw
+    // order, unless the mesh's own order simulates better than the former,
+    // then vertex fetch order, which renumbers the vertices and permutes every
+    // attribute along.
+    OptimizeReport Optimize(SourceMesh& mesh);
+
+    // Up to maxLods levels of MeshSimplify::BuildLodChain, each halving the
+    // triangles of the one before and in vertex cache order. Levels share the
+    // mesh's vertices, so this runs after Optimize has renumbered them.
+    std::vector<MeshSimplify::Lod> BuildLods(const SourceMesh& mesh, int maxLods);
+
+    // Tangents derived from the texture coordinates, MikkTSpace style: every
+    // triangle corner contributes the face tangent projected onto the plane of
+    // the vertex normal and weighted by the corner angle, and each vertex's sum
+    // is orthonormalized against its normal. Runs in parallel over triangles
+    // and then over vertices, and gives the same result for any worker count.
+    //
+    // Meshes without texture coordinates (the text meshes) and vertices whose
+    // texture coordinates are degenerate get a tangent derived from the normal
+    // and a fixed up vector instead.
+    void GenerateTangents(SourceMesh& mesh);
+    void GenerateTangents(SourceMesh& mesh, ThreadPool& pool);
+
+    void ComputeBounds(const SourceMesh& mesh, DirectX::XMFLOAT3& center, DirectX::XMFLOAT3& extents);
+
+    // Writes VertexCount() vertices of layout.Stride bytes to dst.
+    void Pack(const SourceMesh& mesh, const VertexLayout& layout, void* dst);
+
+    // Fills the vertex, index and bounds fields of output from mesh.
+    void Pack(const SourceMesh& mesh, const VertexLayout& layout, Mesh& output);
+
+    // Runs the whole pipeline on a text mesh.
+    bool Import(const std::string& filename, const VertexLayout& layout, const Options& options, Mesh& mesh);
+
+    // Runs the whole pipeline on every primitive of the loader's default
+    // scene, concurrently on the pool. Each primitive is transformed by its
+    // node's world transform and then by options.Transform. The result is in
+    // GLTFLoader::FlattenScene order.
+    std::vector<ScenePrimitive> ImportScene(const GLTFLoader& loader, const VertexLayout& layout, const Options& options);
+    std::vector<ScenePrimitive> ImportScene(
+        const GLTFLoader& loader, const VertexLayout& layout, const Options& options, ThreadPool& pool
+    );
+};
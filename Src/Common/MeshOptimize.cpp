@@ -0,0 +1,340 @@
+#include "MeshOptimize.h"
+
+#include <algorithm>
+
+using namespace DirectX;
+
+namespace MeshOptimize {
+    namespace {
+        // FIFO cache emulated with per-vertex timestamps: a vertex is in the
+        // cache if fewer than size vertices have been inserted since it was.
+        class FifoCache {
+        public:
+            FifoCache(size_t vertexCount, uint32_t size) : mTimestamps(vertexCount, 0), mSize(size), mTime(size + 1) {}
+
+            // Returns whether v missed, and inserts it if so.
+            bool Access(uint32_t v) {
+                if (mTime - mTimestamps[v] > mSize) {
+                    mTimestamps[v] = mTime++;
+                    return true;
+                }
+                return false;
+            }
+
+            // Age of v in insertions, greater than the size if it isn't cached.
+            uint32_t Age(uint32_t v) const {
+                return mTime - mTimestamps[v];
+            }
+
+            void Flush() {
+                mTime += mSize + 1;
+            }
+
+        private:
+            std::vector<uint32_t> mTimestamps;
+            uint32_t mSize;
+            uint32_t mTime;
+        };
+
+        // Misses of triangle t.
+        uint32_t AccessTriangle(FifoCache& cache, const std::vector<uint32_t>& indices, size_t t) {
+            return
+                (cache.Access(indices[3 * t + 0]) ? 1 : 0) +
+                (cache.Access(indices[3 * t + 1]) ? 1 : 0) +
+                (cache.Access(indices[3 * t + 2]) ? 1 : 0);
+        }
+
+        // Triangles around each vertex, in CSR form: the triangles of v are
+        // Triangles[Offsets[v]] to Triangles[Offsets[v + 1]].
+        struct Adjacency {
+            std::vector<uint32_t> Offsets;
+            std::vector<uint32_t> Triangles;
+        };
+
+        Adjacency BuildAdjacency(const std::vector<uint32_t>& indices, size_t vertexCount) {
+            Adjacency adjacency;
+            adjacency.Offsets.assign(vertexCount + 1, 0);
+            for (uint32_t v : indices) {
+                ++adjacency.Offsets[v + 1];
+            }
+            for (size_t v = 0; v < vertexCount; ++v) {
+                adjacency.Offsets[v + 1] += adjacency.Offsets[v];
+            }
+
+            std::vector<uint32_t> next(adjacency.Offsets.begin(), adjacency.Offsets.end() - 1);
+            adjacency.Triangles.resize(indices.size());
+            for (size_t i = 0; i < indices.size(); ++i) {
+                adjacency.Triangles[next[indices[i]]++] = static_cast<uint32_t>(i / 3);
+            }
+            return adjacency;
+        }
+    }
+
+    CacheStats SimulateVertexCache(
+        const std::vector<uint32_t>& indices, size_t vertexCount, CacheModel model, uint32_t cacheSize
+    ) {
+        CacheStats stats;
+        stats.TriangleCount = static_cast<uint32_t>(indices.size() / 3);
+
+        std::vector<bool> referenced(vertexCount, false);
+        for (uint32_t v : indices) {
+            if (!referenced[v]) {
+                referenced[v] = true;
+                ++stats.VertexCount;
+            }
+        }
+
+        if (model == CacheModel::FIFO) {
+            FifoCache cache(vertexCount, cacheSize);
+            for (uint32_t v : indices) {
+                stats.Misses += cache.Access(v) ? 1 : 0;
+            }
+        } else {
+            // Most recently used first. Caches are a few dozen entries, so a
+            // linear search beats anything cleverer.
+            std::vector<uint32_t> cache;
+            cache.reserve(cacheSize + 1);
+            for (uint32_t v : indices) {
+                auto it = std::find(cache.begin(), cache.end(), v);
+                if (it == cache.end()) {
+                    ++stats.Misses;
+                    cache.insert(cache.begin(), v);
+                    if (cache.size() > cacheSize) {
+                        cache.pop_back();
+                    }
+                } else {
+                    std::rotate(cache.begin(), it, it + 1);
+                }
+            }
+        }
+
+        stats.ACMR = stats.TriangleCount > 0 ? float(stats.Misses) / stats.TriangleCount : 0.0f;
+        stats.ATVR = stats.VertexCount > 0 ? float(stats.Misses) / stats.VertexCount : 0.0f;
+        return stats;
+    }
+
+    void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize) {
+        const size_t triangleCount = indices.size() / 3;
+        if (triangleCount == 0) {
+            return;
+        }
+
+        const Adjacency adjacency = BuildAdjacency(indices, vertexCount);
+
+        // Triangles not yet emitted around each vertex.
+        std::vector<uint32_t> liveTriangles(vertexCount);
+        for (size_t v = 0; v < vertexCount; ++v) {
+            liveTriangles[v] = adjacency.Offsets[v + 1] - adjacency.Offsets[v];
+        }
+
+        std::vector<bool> emitted(triangleCount, false);
+        FifoCache cache(vertexCount, cacheSize);
+        // Vertices of emitted triangles, most recent last, to restart from
+        // when a fan runs out of cached candidates.
+        std::vector<uint32_t> deadEnds;
+        std::vector<uint32_t> candidates;
+        // Scan position for when the dead-end stack runs out too.
+        size_t nextVertex = 0;
+
+        std::vector<uint32_t> output;
+        output.reserve(indices.size());
+
+        int64_t fanningVertex = indices[0];
+        while (fanningVertex >= 0) {
+            candidates.clear();
+
+            const uint32_t f = static_cast<uint32_t>(fanningVertex);
+            for (uint32_t i = adjacency.Offsets[f]; i < adjacency.Offsets[f + 1]; ++i) {
+                const uint32_t t = adjacency.Triangles[i];
+                if (emitted[t]) {
+                    continue;
+                }
+                emitted[t] = true;
+
+                for (int c = 0; c < 3; ++c) {
+                    const uint32_t v = indices[3 * t + c];
+                    output.push_back(v);
+                    deadEnds.push_back(v);
+                    candidates.push_back(v);
+                    --liveTriangles[v];
+                    cache.Access(v);
+                }
+            }
+
+            // The candidate that will still be in the cache after its
+            // remaining triangles are emitted, and that has been in it the
+            // longest; it would be the first to be evicted otherwise.
+            fanningVertex = -1;
+            int64_t bestPriority = -1;
+            for (uint32_t v : candidates) {
+                if (liveTriangles[v] == 0) {
+                    continue;
+                }
+                int64_t priority = 0;
+                if (cache.Age(v) + 2 * liveTriangles[v] <= cacheSize) {
+                    priority = cache.Age(v);
+                }
+                if (priority > bestPriority) {
+                    bestPriority = priority;
+                    fanningVertex = v;
+                }
+            }
+
+            if (fanningVertex >= 0) {
+                continue;
+            }
+
+            // Dead end: restart from the most recently used vertex that still
+            // has triangles, or else from the next one in index order.
+            while (!deadEnds.empty() && fanningVertex < 0) {
+                const uint32_t v = deadEnds.back();
+                deadEnds.pop_back();
+                if (liveTriangles[v] > 0) {
+                    fanningVertex = v;
+                }
+            }
+            while (fanningVertex < 0 && nextVertex < vertexCount) {
+                if (liveTriangles[nextVertex] > 0) {
+                    fanningVertex = static_cast<int64_t>(nextVertex);
+                }
+                ++nextVertex;
+            }
+        }
+
+        indices.swap(output);
+    }
+
+    void OptimizeOverdraw(
+        std::vector<uint32_t>& indices, const std::vector<XMFLOAT3>& positions, float threshold, uint32_t cacheSize
+    ) {
+        const size_t triangleCount = indices.size() / 3;
+        if (triangleCount == 0) {
+            return;
+        }
+
+        // Hard boundaries: triangles that miss on all three vertices, which is
+        // where the cache order jumped to another part of the mesh.
+        std::vector<uint32_t> hardBoundaries = { 0 };
+        {
+            FifoCache cache(positions.size(), cacheSize);
+            for (size_t t = 0; t < triangleCount; ++t) {
+                if (AccessTriangle(cache, indices, t) == 3 && t > 0) {
+                    hardBoundaries.push_back(static_cast<uint32_t>(t));
+                }
+            }
+            hardBoundaries.push_back(static_cast<uint32_t>(triangleCount));
+        }
+
+        // Soft boundaries: within a hard cluster, split wherever the ACMR of
+        // the cluster so far (with a cold cache) drops to threshold times the
+        // ACMR of the whole hard cluster.
+        std::vector<uint32_t> clusters;
+        {
+            FifoCache cache(positions.size(), cacheSize);
+            for (size_t h = 0; h + 1 < hardBoundaries.size(); ++h) {
+                const uint32_t begin = hardBoundaries[h];
+                const uint32_t end = hardBoundaries[h + 1];
+
+                cache.Flush();
+                uint32_t misses = 0;
+                for (uint32_t t = begin; t < end; ++t) {
+                    misses += AccessTriangle(cache, indices, t);
+                }
+                const float limit = threshold * float(misses) / float(end - begin);
+
+                cache.Flush();
+                clusters.push_back(begin);
+                uint32_t start = begin;
+                misses = 0;
+                for (uint32_t t = begin; t < end; ++t) {
+                    misses += AccessTriangle(cache, indices, t);
+                    if (t + 1 < end && float(misses) / float(t + 1 - start) <= limit) {
+                        start = t + 1;
+                        misses = 0;
+                        cache.Flush();
+                        clusters.push_back(start);
+                    }
+                }
+            }
+            clusters.push_back(static_cast<uint32_t>(triangleCount));
+        }
+
+        const size_t clusterCount = clusters.size() - 1;
+
+        // Area-weighted centroid and normal of each cluster and of the mesh.
+        std::vector<XMFLOAT3> clusterCentroids(clusterCount);
+        std::vector<XMFLOAT3> clusterNormals(clusterCount);
+        XMVECTOR meshCentroid = XMVectorZero();
+        float meshArea = 0.0f;
+        for (size_t c = 0; c < clusterCount; ++c) {
+            XMVECTOR centroid = XMVectorZero();
+            XMVECTOR normal = XMVectorZero();
+            float area = 0.0f;
+            for (uint32_t t = clusters[c]; t < clusters[c + 1]; ++t) {
+                XMVECTOR p0 = XMLoadFloat3(&positions[indices[3 * t + 0]]);
+                XMVECTOR p1 = XMLoadFloat3(&positions[indices[3 * t + 1]]);
+                XMVECTOR p2 = XMLoadFloat3(&positions[indices[3 * t + 2]]);
+
+                // Twice the area, in the direction of the normal.
+                XMVECTOR n = XMVector3Cross(p1 - p0, p2 - p0);
+                float triangleArea = XMVectorGetX(XMVector3Length(n));
+
+                centroid += (p0 + p1 + p2) * (triangleArea / 3.0f);
+                normal += n;
+                area += triangleArea;
+            }
+
+            meshCentroid += centroid;
+            meshArea += area;
+
+            XMStoreFloat3(&clusterCentroids[c], area > 0.0f ? centroid / area : centroid);
+            XMStoreFloat3(&clusterNormals[c], XMVector3Normalize(normal));
+        }
+        if (meshArea > 0.0f) {
+            meshCentroid /= meshArea;
+        }
+
+        // The further out a cluster is along its own normal, the more likely it
+        // is to face the camera in front of the rest of the mesh.
+        std::vector<float> sortKeys(clusterCount);
+        for (size_t c = 0; c < clusterCount; ++c) {
+            XMVECTOR offset = XMLoadFloat3(&clusterCentroids[c]) - meshCentroid;
+            sortKeys[c] = XMVectorGetX(XMVector3Dot(offset, XMLoadFloat3(&clusterNormals[c])));
+        }
+
+        std::vector<uint32_t> order(clusterCount);
+        for (size_t c = 0; c < clusterCount; ++c) {
+            order[c] = static_cast<uint32_t>(c);
+        }
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return sortKeys[a] > sortKeys[b];
+        });
+
+        std::vector<uint32_t> output;
+        output.reserve(indices.size());
+        for (uint32_t c : order) {
+            output.insert(output.end(), indices.begin() + 3 * size_t(clusters[c]), indices.begin() + 3 * size_t(clusters[c + 1]));
+        }
+        indices.swap(output);
+    }
+
+    std::vector<uint32_t> OptimizeVertexFetch(std::vector<uint32_t>& indices, size_t vertexCount) {
+        const uint32_t unassigned = UINT32_MAX;
+        std::vector<uint32_t> remap(vertexCount, unassigned);
+
+        uint32_t next = 0;
+        for (uint32_t& v : indices) {
+            if (remap[v] == unassigned) {
+                remap[v] = next++;
+            }
+            v = remap[v];
+        }
+        for (uint32_t& newIndex : remap) {
+            if (newIndex == unassigned) {
+                newIndex = next++;
+            }
+        }
+
+        return remap;
+    }
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Reordering of triangle lists for the GPU, run by MeshImport before packing:
+//
+//   vertex cache order -> overdraw order -> vertex fetch order
+//
+// The first two permute triangles and the last one permutes vertices, so the
+// mesh draws exactly the same. Everything is measured against a simulated
+// post-transform cache, so the result can be checked without a GPU.
+namespace MeshOptimize {
+    // Post-transform cache size that the orderings target. Current hardware
+    // caches are larger or not strictly FIFO; an ordering for a small FIFO
+    // still does well on them.
+    const uint32_t DefaultCacheSize = 16;
+
+    enum class CacheModel {
+        FIFO,
+        LRU
+    };
+
+    struct CacheStats {
+        uint32_t TriangleCount = 0;
+        // Vertices referenced by the indices.
+        uint32_t VertexCount = 0;
+        // Vertices that the simulated cache had to transform.
+        uint32_t Misses = 0;
+        // Average cache miss ratio: misses per triangle, 0.5 at best for a
+        // large regular mesh and 3 at worst.
+        float ACMR = 0.0f;
+        // Average transform to vertex ratio: misses per referenced vertex,
+        // 1 at best.
+        float ATVR = 0.0f;
+    };
+
+    // ACMR and ATVR of the triangle list indices when it is drawn through a
+    // post-transform cache of cacheSize entries.
+    CacheStats SimulateVertexCache(
+        const std::vector<uint32_t>& indices, size_t vertexCount, CacheModel model, uint32_t cacheSize = DefaultCacheSize
+    );
+
+    // Reorders triangles for a FIFO cache of cacheSize entries with Tipsify
+    // (Sander, Nehab and Barczak, "Fast Triangle Reordering for Vertex
+    // Locality and Reduced Overdraw", 2007): triangles are fanned around a
+    // vertex at a time, and the next fanning vertex is the one that is still
+    // in the cache and has triangles left. Linear in the number of indices.
+    void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = DefaultCacheSize);
+
+    // Reorders clusters of an index list that OptimizeVertexCache has ordered
+    // so that triangles facing outwards from the center of the mesh come
+    // first and occlude the rest. Clusters are split where the cache is
+    // flushed, and further where the ACMR of the cluster so far drops below
+    // threshold times that of the whole cluster, so the cache order degrades
+    // by at most about that factor.
+    void OptimizeOverdraw(
+        std::vector<uint32_t>& indices, const std::vector<DirectX::XMFLOAT3>& positions,
+        float threshold = 1.05f, uint32_t cacheSize = DefaultCacheSize
+    );
+
+    // Renumbers vertices in the order the indices first reference them, so
+    // that the vertex shader reads the vertex buffer mostly in sequence, and
+    // rewrites the indices. Unreferenced vertices go last. Returns the new
+    // index of each vertex, for permuting the attributes with RemapVertices.
+    std::vector<uint32_t> OptimizeVertexFetch(std::vector<uint32_t>& indices, size_t vertexCount);
+
+    // Moves attribute i to remap[i]. Empty attributes stay empty.
+    template <typename T>
+    void RemapVertices(std::vector<T>& attribute, const std::vector<uint32_t>& remap) {
+        if (attribute.size() != remap.size()) {
+            return;
+        }
+        std::vector<T> remapped(attribute.size());
+        for (size_t i = 0; i < attribute.size(); ++i) {
+            remapped[remap[i]] = attribute[i];
+        }
+        attribute.swap(remapped);
+    }
+};
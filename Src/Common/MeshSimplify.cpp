@@ -0,0 +1,460 @@
+#include "MeshSimplify.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace DirectX;
+
+namespace MeshSimplify {
+    namespace {
+        struct Vector3 {
+            double x, y, z;
+
+            Vector3 operator-(const Vector3& rhs) const { return { x - rhs.x, y - rhs.y, z - rhs.z }; }
+            double Dot(const Vector3& rhs) const { return x * rhs.x + y * rhs.y + z * rhs.z; }
+            Vector3 Cross(const Vector3& rhs) const {
+                return { y * rhs.z - z * rhs.y, z * rhs.x - x * rhs.z, x * rhs.y - y * rhs.x };
+            }
+        };
+
+        Vector3 ToVector3(const XMFLOAT3& v) {
+            return { v.x, v.y, v.z };
+        }
+
+        // Sum of squared distances to weighted planes, as the symmetric matrix
+        // [A b; b c]. Doubles, because c is the sum of large terms that cancel.
+        struct Quadric {
+            double a00 = 0.0, a01 = 0.0, a02 = 0.0, a11 = 0.0, a12 = 0.0, a22 = 0.0;
+            double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+            double c = 0.0;
+            double weight = 0.0;
+
+            // The plane through p with unit normal n.
+            void AddPlane(const Vector3& n, const Vector3& p, double w) {
+                double d = -n.Dot(p);
+                a00 += w * n.x * n.x; a01 += w * n.x * n.y; a02 += w * n.x * n.z;
+                a11 += w * n.y * n.y; a12 += w * n.y * n.z; a22 += w * n.z * n.z;
+                b0 += w * n.x * d; b1 += w * n.y * d; b2 += w * n.z * d;
+                c += w * d * d;
+                weight += w;
+            }
+
+            Quadric& operator+=(const Quadric& rhs) {
+                a00 += rhs.a00; a01 += rhs.a01; a02 += rhs.a02;
+                a11 += rhs.a11; a12 += rhs.a12; a22 += rhs.a22;
+                b0 += rhs.b0; b1 += rhs.b1; b2 += rhs.b2;
+                c += rhs.c;
+                weight += rhs.weight;
+                return *this;
+            }
+
+            // Mean squared distance from p to the planes.
+            double Error(const Vector3& p) const {
+                double e =
+                    a00 * p.x * p.x + a11 * p.y * p.y + a22 * p.z * p.z +
+                    2.0 * (a01 * p.x * p.y + a02 * p.x * p.z + a12 * p.y * p.z) +
+                    2.0 * (b0 * p.x + b1 * p.y + b2 * p.z) + c;
+                return weight > 0.0 ? std::max(e, 0.0) / weight : 0.0;
+            }
+        };
+
+        // Maps every referenced vertex to the lowest referenced vertex with
+        // the same position, so that the wedges of a position (copies with
+        // other attributes) count as one vertex of the surface.
+        std::vector<uint32_t> BuildPositionRemap(const std::vector<uint32_t>& indices, const std::vector<XMFLOAT3>& positions) {
+            std::vector<uint32_t> remap(positions.size());
+            std::vector<uint32_t> referenced;
+            std::vector<bool> seen(positions.size(), false);
+            for (uint32_t v : indices) {
+                if (!seen[v]) {
+                    seen[v] = true;
+                    referenced.push_back(v);
+                }
+            }
+            for (uint32_t v = 0; v < remap.size(); ++v) {
+                remap[v] = v;
+            }
+
+            // Ordered by the bits of the coordinates, so equal positions are
+            // adjacent and -0 and 0 stay apart like any other distinct bits.
+            auto key = [&](uint32_t v, int c) {
+                uint32_t bits;
+                memcpy(&bits, &(&positions[v].x)[c], sizeof(bits));
+                return bits;
+            };
+            auto samePosition = [&](uint32_t a, uint32_t b) {
+                return key(a, 0) == key(b, 0) && key(a, 1) == key(b, 1) && key(a, 2) == key(b, 2);
+            };
+            std::sort(referenced.begin(), referenced.end(), [&](uint32_t a, uint32_t b) {
+                for (int c = 0; c < 3; ++c) {
+                    if (key(a, c) != key(b, c)) {
+                        return key(a, c) < key(b, c);
+                    }
+                }
+                return a < b;
+            });
+            for (size_t i = 1; i < referenced.size(); ++i) {
+                uint32_t first = remap[referenced[i - 1]];
+                if (samePosition(referenced[i], first)) {
+                    remap[referenced[i]] = first;
+                }
+            }
+            return remap;
+        }
+
+        // Removes the triangles that have lost an edge.
+        void RemoveDegenerateTriangles(std::vector<uint32_t>& indices, const std::vector<uint32_t>& remap) {
+            size_t kept = 0;
+            for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+                uint32_t c0 = remap[indices[i]], c1 = remap[indices[i + 1]], c2 = remap[indices[i + 2]];
+                if (c0 != c1 && c1 != c2 && c2 != c0) {
+                    indices[kept++] = indices[i];
+                    indices[kept++] = indices[i + 1];
+                    indices[kept++] = indices[i + 2];
+                }
+            }
+            indices.resize(kept);
+        }
+
+        struct Collapse {
+            // Surface vertices: v moves onto t.
+            uint32_t V;
+            uint32_t T;
+            double Cost;
+            // Of the position alone.
+            double Error;
+        };
+    }
+
+    std::vector<uint32_t> Simplify(
+        const std::vector<uint32_t>& indices, const std::vector<XMFLOAT3>& positions,
+        const std::vector<XMFLOAT3>& normals, const std::vector<XMFLOAT2>& texCoords,
+        const Options& options, float* error
+    ) {
+        const size_t vertexCount = positions.size();
+        const bool hasNormals = normals.size() == vertexCount;
+        const bool hasTexCoords = texCoords.size() == vertexCount;
+
+        std::vector<uint32_t> result(indices.begin(), indices.begin() + indices.size() / 3 * 3);
+        const std::vector<uint32_t> remap = BuildPositionRemap(result, positions);
+        RemoveDegenerateTriangles(result, remap);
+
+        // Locked: seams (more than one referenced wedge), and vertices of edges
+        // that aren't shared by exactly two consistently wound triangles
+        // (borders, and non-manifold edges).
+        std::vector<bool> locked(vertexCount, false);
+        {
+            std::vector<bool> seen(vertexCount, false);
+            for (uint32_t v : result) {
+                if (!seen[v]) {
+                    seen[v] = true;
+                    if (remap[v] != v) {
+                        locked[remap[v]] = true;
+                    }
+                }
+            }
+
+            // Directed edges grouped by their first vertex; an edge (a, b) is
+            // interior if it occurs once in a's group and (b, a) once in b's.
+            std::vector<uint32_t> edgeOffsets(vertexCount + 1, 0);
+            for (uint32_t v : result) {
+                ++edgeOffsets[remap[v] + 1];
+            }
+            for (size_t v = 0; v < vertexCount; ++v) {
+                edgeOffsets[v + 1] += edgeOffsets[v];
+            }
+            std::vector<uint32_t> edgeEnds(result.size());
+            std::vector<uint32_t> next(edgeOffsets.begin(), edgeOffsets.end() - 1);
+            for (size_t i = 0; i < result.size(); i += 3) {
+                for (int e = 0; e < 3; ++e) {
+                    uint32_t a = remap[result[i + e]];
+                    edgeEnds[next[a]++] = remap[result[i + (e + 1) % 3]];
+                }
+            }
+            auto count = [&](uint32_t a, uint32_t b) {
+                return std::count(edgeEnds.begin() + edgeOffsets[a], edgeEnds.begin() + edgeOffsets[a + 1], b);
+            };
+            for (uint32_t a = 0; a < vertexCount; ++a) {
+                for (uint32_t e = edgeOffsets[a]; e < edgeOffsets[a + 1]; ++e) {
+                    uint32_t b = edgeEnds[e];
+                    if (count(a, b) != 1 || count(b, a) != 1) {
+                        locked[a] = true;
+                        locked[b] = true;
+                    }
+                }
+            }
+        }
+
+        // Area-weighted planes of the triangles around each surface vertex,
+        // and the ratio of surface to texture area that turns a texture
+        // coordinate change into a distance.
+        std::vector<Quadric> quadrics(vertexCount);
+        double surfaceArea = 0.0;
+        double texCoordArea = 0.0;
+        for (size_t i = 0; i < result.size(); i += 3) {
+            Vector3 p0 = ToVector3(positions[result[i]]);
+            Vector3 p1 = ToVector3(positions[result[i + 1]]);
+            Vector3 p2 = ToVector3(positions[result[i + 2]]);
+            Vector3 n = (p1 - p0).Cross(p2 - p0);
+            double length = sqrt(n.Dot(n));
+            if (length > 0.0) {
+                n = { n.x / length, n.y / length, n.z / length };
+                for (int c = 0; c < 3; ++c) {
+                    quadrics[remap[result[i + c]]].AddPlane(n, p0, 0.5 * length);
+                }
+            }
+            surfaceArea += 0.5 * length;
+
+            if (hasTexCoords) {
+                const XMFLOAT2& t0 = texCoords[result[i]];
+                const XMFLOAT2& t1 = texCoords[result[i + 1]];
+                const XMFLOAT2& t2 = texCoords[result[i + 2]];
+                texCoordArea += 0.5 * fabs(double(t1.x - t0.x) * (t2.y - t0.y) - double(t2.x - t0.x) * (t1.y - t0.y));
+            }
+        }
+        const double texCoordScale = texCoordArea > 0.0 ? surfaceArea / texCoordArea : 0.0;
+
+        const double maxErrorSquared = double(options.MaxError) * options.MaxError;
+        double resultErrorSquared = 0.0;
+
+        std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+        std::vector<uint32_t> adjacency;
+        std::vector<Collapse> collapses;
+        std::vector<bool> touched(vertexCount);
+        std::vector<bool> collapsed(vertexCount);
+        std::vector<uint32_t> collapseTarget(vertexCount);
+        // For the link condition: ring vertices are marked with the stamp of
+        // the collapse being tested.
+        std::vector<uint32_t> ringStamps(vertexCount, 0);
+        uint32_t stamp = 0;
+
+        while (result.size() > options.TargetIndexCount) {
+            const size_t triangleCount = result.size() / 3;
+
+            // Triangles around each surface vertex.
+            std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+            for (uint32_t v : result) {
+                ++adjacencyOffsets[remap[v] + 1];
+            }
+            for (size_t v = 0; v < vertexCount; ++v) {
+                adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+            }
+            adjacency.resize(result.size());
+            {
+                std::vector<uint32_t> next(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+                for (size_t i = 0; i < result.size(); ++i) {
+                    adjacency[next[remap[result[i]]]++] = static_cast<uint32_t>(i / 3);
+                }
+            }
+
+            // Every interior edge once (from the triangle in which it runs
+            // from the lower vertex to the higher), in its cheaper direction.
+            collapses.clear();
+            for (size_t i = 0; i < result.size(); i += 3) {
+                for (int e = 0; e < 3; ++e) {
+                    const uint32_t wa = result[i + e];
+                    const uint32_t wb = result[i + (e + 1) % 3];
+                    const uint32_t a = remap[wa];
+                    const uint32_t b = remap[wb];
+                    if (a > b || (locked[a] && locked[b])) {
+                        continue;
+                    }
+
+                    const Vector3 pa = ToVector3(positions[a]);
+                    const Vector3 pb = ToVector3(positions[b]);
+                    const double edgeLengthSquared = (pa - pb).Dot(pa - pb);
+                    Quadric q = quadrics[a];
+                    q += quadrics[b];
+
+                    // Only an unlocked vertex moves, and it has a single wedge,
+                    // which is the surface vertex itself.
+                    auto cost = [&](uint32_t v, uint32_t tWedge, double positionError) {
+                        double attributeCost = 0.0;
+                        if (hasNormals) {
+                            XMVECTOR nv = XMLoadFloat3(&normals[v]);
+                            XMVECTOR nt = XMLoadFloat3(&normals[tWedge]);
+                            attributeCost += options.NormalWeight * (1.0 - XMVectorGetX(XMVector3Dot(nv, nt))) * edgeLengthSquared;
+                        }
+                        if (hasTexCoords) {
+                            double du = texCoords[v].x - texCoords[tWedge].x;
+                            double dv = texCoords[v].y - texCoords[tWedge].y;
+                            attributeCost += options.TexCoordWeight * (du * du + dv * dv) * texCoordScale;
+                        }
+                        return positionError + attributeCost;
+                    };
+
+                    Collapse best = { 0, 0, 0.0, 0.0 };
+                    bool found = false;
+                    if (!locked[a]) {
+                        double positionError = q.Error(pb);
+                        best = { a, b, cost(a, wb, positionError), positionError };
+                        found = true;
+                    }
+                    if (!locked[b]) {
+                        double positionError = q.Error(pa);
+                        double c = cost(b, wa, positionError);
+                        if (!found || c < best.Cost) {
+                            best = { b, a, c, positionError };
+                            found = true;
+                        }
+                    }
+                    if (best.Error <= maxErrorSquared) {
+                        collapses.push_back(best);
+                    }
+                }
+            }
+            if (collapses.empty()) {
+                break;
+            }
+
+            // Apply the cheaper half of the collapses whose neighborhoods don't
+            // overlap; the rest wait for the next pass, where their costs
+            // reflect what this one changed. That keeps the order close to
+            // that of a priority queue.
+            const size_t passCount = collapses.size() / 2 + 1;
+            auto cheaper = [](const Collapse& lhs, const Collapse& rhs) {
+                return lhs.Cost < rhs.Cost;
+            };
+            std::nth_element(collapses.begin(), collapses.begin() + (passCount - 1), collapses.end(), cheaper);
+            std::sort(collapses.begin(), collapses.begin() + passCount, cheaper);
+
+            std::fill(touched.begin(), touched.end(), false);
+            std::fill(collapsed.begin(), collapsed.end(), false);
+            size_t removed = 0;
+            size_t applied = 0;
+            for (size_t ci = 0; ci < passCount; ++ci) {
+                const uint32_t v = collapses[ci].V;
+                const uint32_t t = collapses[ci].T;
+                if (touched[v] || touched[t]) {
+                    continue;
+                }
+
+                const Vector3 pt = ToVector3(positions[t]);
+                bool valid = true;
+                uint32_t tWedge = UINT32_MAX;
+                size_t sharedTriangles = 0;
+
+                ++stamp;
+                for (uint32_t a = adjacencyOffsets[v]; valid && a < adjacencyOffsets[v + 1]; ++a) {
+                    const size_t tri = 3 * size_t(adjacency[a]);
+                    int vCorner = -1;
+                    int tCorner = -1;
+                    for (int c = 0; c < 3; ++c) {
+                        const uint32_t u = remap[result[tri + c]];
+                        // A neighbor that moved this pass has stale positions
+                        // and triangles here.
+                        valid = valid && !collapsed[u];
+                        ringStamps[u] = stamp;
+                        vCorner = u == v ? c : vCorner;
+                        tCorner = u == t ? c : tCorner;
+                    }
+                    if (!valid) {
+                        break;
+                    }
+
+                    if (tCorner >= 0) {
+                        // Goes away. Every such triangle must use the same
+                        // wedge of t, which is the one v's corners take.
+                        ++sharedTriangles;
+                        uint32_t wedge = result[tri + tCorner];
+                        valid = tWedge == UINT32_MAX || tWedge == wedge;
+                        tWedge = wedge;
+                        continue;
+                    }
+
+                    // Stays, with v moved onto t: it must not flip.
+                    Vector3 p[3];
+                    for (int c = 0; c < 3; ++c) {
+                        p[c] = ToVector3(positions[result[tri + c]]);
+                    }
+                    Vector3 before = (p[1] - p[0]).Cross(p[2] - p[0]);
+                    p[vCorner] = pt;
+                    Vector3 after = (p[1] - p[0]).Cross(p[2] - p[0]);
+                    valid = before.Dot(after) > 0.0;
+                }
+                if (!valid || tWedge == UINT32_MAX) {
+                    continue;
+                }
+
+                // Link condition: v and t may only share the neighbors across
+                // the triangles that go away, or the surface pinches.
+                size_t sharedNeighbors = 0;
+                ++stamp;
+                const uint32_t ringStamp = stamp - 1;
+                for (uint32_t a = adjacencyOffsets[t]; a < adjacencyOffsets[t + 1]; ++a) {
+                    const size_t tri = 3 * size_t(adjacency[a]);
+                    for (int c = 0; c < 3; ++c) {
+                        const uint32_t u = remap[result[tri + c]];
+                        if (u != v && u != t && ringStamps[u] == ringStamp) {
+                            ringStamps[u] = stamp;
+                            ++sharedNeighbors;
+                        }
+                    }
+                }
+                if (sharedNeighbors != sharedTriangles) {
+                    continue;
+                }
+
+                collapsed[v] = true;
+                collapseTarget[v] = tWedge;
+                touched[v] = true;
+                touched[t] = true;
+                quadrics[t] += quadrics[v];
+                resultErrorSquared = std::max(resultErrorSquared, collapses[ci].Error);
+                removed += sharedTriangles;
+                ++applied;
+
+                if ((triangleCount - removed) * 3 <= options.TargetIndexCount) {
+                    break;
+                }
+            }
+            if (applied == 0) {
+                break;
+            }
+
+            for (uint32_t& w : result) {
+                if (collapsed[remap[w]]) {
+                    w = collapseTarget[remap[w]];
+                }
+            }
+            RemoveDegenerateTriangles(result, remap);
+        }
+
+        if (error) {
+            *error = static_cast<float>(sqrt(resultErrorSquared));
+        }
+        return result;
+    }
+
+    std::vector<Lod> BuildLodChain(
+        const std::vector<uint32_t>& indices, const std::vector<XMFLOAT3>& positions,
+        const std::vector<XMFLOAT3>& normals, const std::vector<XMFLOAT2>& texCoords,
+        int maxLods, float reduction
+    ) {
+        std::vector<Lod> lods;
+        size_t previousIndexCount = indices.size();
+        float previousError = 0.0f;
+
+        for (int i = 0; i < maxLods; ++i) {
+            Options options;
+            options.TargetIndexCount = static_cast<size_t>(previousIndexCount / 3 * reduction) * 3;
+
+            Lod lod;
+            lod.Indices = Simplify(indices, positions, normals, texCoords, options, &lod.Error);
+            if (lod.Indices.empty() || lod.Indices.size() > previousIndexCount * 9 / 10) {
+                break;
+            }
+
+            // Simplified from the full mesh each time, so the errors are each
+            // measured from it, but they needn't grow; the selection assumes
+            // they do.
+            lod.Error = std::max(lod.Error, previousError);
+            previousIndexCount = lod.Indices.size();
+            previousError = lod.Error;
+            lods.push_back(std::move(lod));
+        }
+
+        return lods;
+    }
+};
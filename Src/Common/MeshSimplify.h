@@ -0,0 +1,56 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cfloat>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Levels of detail by edge collapse. An edge is collapsed by moving one of its
+// vertices onto the other, so a simplified mesh only has new indices into the
+// same vertices, and every level of a chain shares the vertex buffer.
+//
+// Collapses are ordered by the quadric error metric (Garland and Heckbert,
+// "Surface Simplification Using Quadric Error Metrics", 1997) plus the change
+// in normal and texture coordinates that they cause. Vertices on open borders
+// and on attribute seams (vertices that share a position but not their
+// attributes) never move, so holes don't open and seams don't tear.
+namespace MeshSimplify {
+    struct Options {
+        // Stops once the mesh has no more indices than this...
+        size_t TargetIndexCount = 0;
+        // ...or no collapse is left that moves the surface less than this
+        // distance, in the units of the positions.
+        float MaxError = FLT_MAX;
+        // Cost of turning a normal by 90 degrees, and of a texture coordinate
+        // change as long as the collapsed edge, relative to moving the
+        // surface by the length of the edge.
+        float NormalWeight = 1.0f;
+        float TexCoordWeight = 1.0f;
+    };
+
+    // Returns the simplified triangle list, with indices into the same
+    // vertices. error, if given, receives the largest distance that the
+    // surface moved. Normals and texture coordinates may be empty.
+    std::vector<uint32_t> Simplify(
+        const std::vector<uint32_t>& indices, const std::vector<DirectX::XMFLOAT3>& positions,
+        const std::vector<DirectX::XMFLOAT3>& normals, const std::vector<DirectX::XMFLOAT2>& texCoords,
+        const Options& options, float* error = nullptr
+    );
+
+    struct Lod {
+        std::vector<uint32_t> Indices;
+        // Largest distance from the full-detail surface.
+        float Error = 0.0f;
+    };
+
+    // Up to maxLods levels, each simplified from the full mesh down to about
+    // reduction times the triangles of the level before. The chain ends early
+    // when a level can't get at least a tenth below the one before, which is
+    // when the locked vertices are most of what is left.
+    std::vector<Lod> BuildLodChain(
+        const std::vector<uint32_t>& indices, const std::vector<DirectX::XMFLOAT3>& positions,
+        const std::vector<DirectX::XMFLOAT3>& normals, const std::vector<DirectX::XMFLOAT2>& texCoords,
+        int maxLods, float reduction = 0.5f
+    );
+};
@@ -0,0 +1,174 @@
+#include "Meshlets.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace Meshlets {
+    void Build(
+        const std::vector<uint32_t>& indices, const std::vector<XMFLOAT3>& positions, MeshletData& meshlets,
+        uint32_t maxVertices, uint32_t maxTriangles
+    ) {
+        meshlets = MeshletData();
+        maxVertices = std::min(maxVertices, MaxVertices);
+        maxTriangles = std::min(maxTriangles, MaxTriangles);
+
+        // Local index of each mesh vertex in the open meshlet; entries of
+        // closed meshlets are told apart by the meshlet they were set for.
+        const uint32_t none = UINT32_MAX;
+        std::vector<uint32_t> localIndex(positions.size(), none);
+        std::vector<uint32_t> localMeshlet(positions.size(), none);
+
+        Meshlet current = {};
+        auto close = [&]() {
+            if (current.TriangleCount == 0) {
+                return;
+            }
+            meshlets.Meshlets.push_back(current);
+            current.VertexOffset = static_cast<uint32_t>(meshlets.Vertices.size());
+            current.VertexCount = 0;
+            current.TriangleOffset = static_cast<uint32_t>(meshlets.Triangles.size());
+            current.TriangleCount = 0;
+        };
+
+        for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+            const uint32_t meshletIdx = static_cast<uint32_t>(meshlets.Meshlets.size());
+
+            uint32_t newVertices = 0;
+            for (int c = 0; c < 3; ++c) {
+                const uint32_t v = indices[t + c];
+                // A degenerate triangle names a new vertex once.
+                const bool repeated = (c > 0 && indices[t] == v) || (c > 1 && indices[t + 1] == v);
+                if (localMeshlet[v] != meshletIdx && !repeated) {
+                    ++newVertices;
+                }
+            }
+
+            if (current.VertexCount + newVertices > maxVertices || current.TriangleCount + 1 > maxTriangles) {
+                close();
+            }
+
+            const uint32_t openIdx = static_cast<uint32_t>(meshlets.Meshlets.size());
+            uint32_t local[3];
+            for (int c = 0; c < 3; ++c) {
+                const uint32_t v = indices[t + c];
+                if (localMeshlet[v] != openIdx) {
+                    localMeshlet[v] = openIdx;
+                    localIndex[v] = current.VertexCount++;
+                    meshlets.Vertices.push_back(v);
+                }
+                local[c] = localIndex[v];
+            }
+            meshlets.Triangles.push_back(PackTriangle(local[0], local[1], local[2]));
+            ++current.TriangleCount;
+        }
+        close();
+
+        meshlets.MeshletBounds.reserve(meshlets.Meshlets.size());
+        for (const Meshlet& meshlet : meshlets.Meshlets) {
+            meshlets.MeshletBounds.push_back(ComputeBounds(meshlets, meshlet, positions));
+        }
+    }
+
+    Bounds ComputeBounds(const MeshletData& meshlets, const Meshlet& meshlet, const std::vector<XMFLOAT3>& positions) {
+        Bounds bounds = {};
+
+        XMFLOAT3 points[MaxVertices];
+        const uint32_t vertexCount = std::min(meshlet.VertexCount, MaxVertices);
+        for (uint32_t i = 0; i < vertexCount; ++i) {
+            points[i] = positions[meshlets.Vertices[meshlet.VertexOffset + i]];
+        }
+
+        BoundingSphere sphere;
+        BoundingSphere::CreateFromPoints(sphere, vertexCount, points, sizeof(XMFLOAT3));
+        bounds.Center = sphere.Center;
+        bounds.Radius = sphere.Radius;
+
+        bounds.ConeApex = bounds.Center;
+        bounds.ConeAxis = XMFLOAT3(0.0f, 0.0f, 0.0f);
+        bounds.ConeCutoff = 2.0f;
+
+        // Unit normals of the triangles that have an area, each with a corner
+        // of its triangle, and their mean.
+        XMVECTOR normals[MaxTriangles];
+        XMVECTOR corners[MaxTriangles];
+        uint32_t normalCount = 0;
+        XMVECTOR axis = XMVectorZero();
+        for (uint32_t t = 0; t < std::min(meshlet.TriangleCount, MaxTriangles); ++t) {
+            uint32_t i0, i1, i2;
+            UnpackTriangle(meshlets.Triangles[meshlet.TriangleOffset + t], i0, i1, i2);
+            if (i0 >= vertexCount || i1 >= vertexCount || i2 >= vertexCount) {
+                continue;
+            }
+            XMVECTOR p0 = XMLoadFloat3(&points[i0]);
+            XMVECTOR p1 = XMLoadFloat3(&points[i1]);
+            XMVECTOR p2 = XMLoadFloat3(&points[i2]);
+
+            XMVECTOR n = XMVector3Cross(p1 - p0, p2 - p0);
+            float length = XMVectorGetX(XMVector3Length(n));
+            if (length <= 0.0f) {
+                continue;
+            }
+            normals[normalCount] = n / length;
+            corners[normalCount] = p0;
+            axis += normals[normalCount];
+            ++normalCount;
+        }
+
+        float axisLength = XMVectorGetX(XMVector3Length(axis));
+        if (normalCount == 0 || axisLength <= 0.0f) {
+            return bounds;
+        }
+        axis /= axisLength;
+        XMStoreFloat3(&bounds.ConeAxis, axis);
+
+        float minDot = 1.0f;
+        for (uint32_t i = 0; i < normalCount; ++i) {
+            minDot = std::min(minDot, XMVectorGetX(XMVector3Dot(axis, normals[i])));
+        }
+        if (minDot <= 0.0f) {
+            // The normals span a hemisphere or more.
+            return bounds;
+        }
+
+        // Move the apex back along the axis until every triangle's plane is in
+        // front of it, so that a viewer inside the cone's complement sees
+        // them all from behind.
+        XMVECTOR center = XMLoadFloat3(&bounds.Center);
+        float maxT = 0.0f;
+        for (uint32_t i = 0; i < normalCount; ++i) {
+            float distance = XMVectorGetX(XMVector3Dot(center - corners[i], normals[i]));
+            float alignment = XMVectorGetX(XMVector3Dot(axis, normals[i]));
+            maxT = std::max(maxT, distance / alignment);
+        }
+
+        XMStoreFloat3(&bounds.ConeApex, center - axis * maxT);
+        bounds.ConeCutoff = sqrtf(1.0f - minDot * minDot);
+        return bounds;
+    }
+
+    size_t Cull(
+        const Bounds* bounds, size_t count, const BoundingFrustum& frustum, FXMVECTOR eye,
+        bool cullBackFaces, std::vector<uint32_t>& visible
+    ) {
+        const size_t visibleCount = visible.size();
+        for (size_t i = 0; i < count; ++i) {
+            const Bounds& b = bounds[i];
+
+            if (cullBackFaces && b.ConeCutoff <= 1.0f) {
+                XMVECTOR view = XMVector3Normalize(XMLoadFloat3(&b.ConeApex) - eye);
+                if (XMVectorGetX(XMVector3Dot(view, XMLoadFloat3(&b.ConeAxis))) >= b.ConeCutoff) {
+                    continue;
+                }
+            }
+
+            if (frustum.Contains(BoundingSphere(b.Center, b.Radius)) == DISJOINT) {
+                continue;
+            }
+
+            visible.push_back(static_cast<uint32_t>(i));
+        }
+        return visible.size() - visibleCount;
+    }
+};
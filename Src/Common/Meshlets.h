@@ -0,0 +1,85 @@
+#pragma once
+
+#include <DirectXCollision.h>
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Clusters of up to MaxVertices vertices and MaxTriangles triangles of an
+// indexed triangle list, with the bounds that cull them: a bounding sphere
+// for the frustum and a cone of normals for back faces. The layout is the one
+// a D3D12 mesh shader reads (a meshlet's vertices are indices into the vertex
+// buffer, its triangles are packed triples of indices into those), so the
+// tables can be uploaded as they are; CullMeshlets does the same culling on
+// the CPU.
+namespace Meshlets {
+    // Limits of the D3D12 mesh shader samples. 124 triangles rather than 128
+    // leaves room in the output for a meshlet's per-primitive attributes on
+    // hardware that allocates them in blocks of 32 bytes per 8 primitives.
+    const uint32_t MaxVertices = 64;
+    const uint32_t MaxTriangles = 124;
+
+    struct Meshlet {
+        // Into MeshletData::Vertices and MeshletData::Triangles.
+        uint32_t VertexOffset;
+        uint32_t VertexCount;
+        uint32_t TriangleOffset;
+        uint32_t TriangleCount;
+    };
+
+    struct Bounds {
+        DirectX::XMFLOAT3 Center;
+        float Radius;
+        // Every triangle faces away from a viewer at eye if
+        // dot(normalize(ConeApex - eye), ConeAxis) >= ConeCutoff. The cutoff
+        // is the sine of the cone's half angle, and above 1 when the normals
+        // spread too far for the test to cull anything.
+        DirectX::XMFLOAT3 ConeApex;
+        DirectX::XMFLOAT3 ConeAxis;
+        float ConeCutoff;
+    };
+
+    struct MeshletData {
+        std::vector<Meshlet> Meshlets;
+        std::vector<Bounds> MeshletBounds;
+        // Indices into the mesh's vertices.
+        std::vector<uint32_t> Vertices;
+        // Three 10-bit indices into the meshlet's vertices, bits 0-9, 10-19
+        // and 20-29.
+        std::vector<uint32_t> Triangles;
+    };
+
+    inline uint32_t PackTriangle(uint32_t i0, uint32_t i1, uint32_t i2) {
+        return i0 | (i1 << 10) | (i2 << 20);
+    }
+
+    inline void UnpackTriangle(uint32_t triangle, uint32_t& i0, uint32_t& i1, uint32_t& i2) {
+        i0 = triangle & 0x3FF;
+        i1 = (triangle >> 10) & 0x3FF;
+        i2 = (triangle >> 20) & 0x3FF;
+    }
+
+    // Splits the triangle list indices into meshlets, in order: a meshlet is
+    // closed when the next triangle would take it over either limit (which
+    // can't exceed MaxVertices and MaxTriangles). The meshlets are as
+    // coherent as the triangle order, which is why MeshImport builds them
+    // after MeshOptimize. Triangles face the side from which they are
+    // clockwise, as with D3D's default rasterizer state.
+    void Build(
+        const std::vector<uint32_t>& indices, const std::vector<DirectX::XMFLOAT3>& positions, MeshletData& meshlets,
+        uint32_t maxVertices = MaxVertices, uint32_t maxTriangles = MaxTriangles
+    );
+
+    // Bounds of one meshlet of meshlets, from the positions of its mesh.
+    Bounds ComputeBounds(const MeshletData& meshlets, const Meshlet& meshlet, const std::vector<DirectX::XMFLOAT3>& positions);
+
+    // Appends to visible the indices of the meshlets that can be seen by a
+    // viewer at eye with the given frustum, both in the space of the mesh.
+    // Meshlets whose triangles all face away are culled too, unless the
+    // material is double-sided. Returns how many were appended.
+    size_t Cull(
+        const Bounds* bounds, size_t count, const DirectX::BoundingFrustum& frustum, DirectX::FXMVECTOR eye,
+        bool cullBackFaces, std::vector<uint32_t>& visible
+    );
+};
@@ -0,0 +1,539 @@
+#include "ScenePack.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include "DDS.h"
+#include "GLTFLoader.h"
+
+namespace ScenePack {
+    namespace {
+        uint64_t AlignTo16(uint64_t offset) {
+            return (offset + 15) & ~uint64_t(15);
+        }
+
+        uint64_t AlignTo64(uint64_t offset) {
+            return (offset + 63) & ~uint64_t(63);
+        }
+
+        // Whether count elements of size bytes at offset fit in fileSize bytes.
+        bool InFile(uint64_t offset, uint64_t count, uint64_t size, uint64_t fileSize) {
+            return offset <= fileSize && count <= (fileSize - offset) / std::max<uint64_t>(size, 1);
+        }
+
+        // Size of the surface data of a DDS file, 0 if it can't be read.
+        uint64_t DDSByteSize(const std::string& filename) {
+            MappedFile file;
+            DDS::TextureInfo info;
+            if (!file.Open(filename) || !DDS::ParseHeader(file.Data(), file.Size(), info)) {
+                return 0;
+            }
+            return info.BitSize;
+        }
+
+        void WritePadding(std::ofstream& fout, uint64_t offset, uint64_t alignedOffset) {
+            const char padding[64] = {};
+            fout.write(padding, alignedOffset - offset);
+        }
+
+        Material ToMaterial(const GLTFMaterialData& data, const GLTFTextureTable& textures) {
+            Material material = {};
+            material.BaseColorFactor = data.baseColorFactor;
+            material.EmissiveFactor = data.emissiveFactor;
+            material.AlphaCutoff = data.alphaCutoff;
+            material.MetallicFactor = data.metallicFactor;
+            material.RoughnessFactor = data.roughnessFactor;
+            material.NormalScale = data.normalScale;
+            material.OcclusionStrength = data.occlusionStrength;
+            material.BaseColorTexture = static_cast<int16_t>(textures.GetImage(data.baseColorMap));
+            material.NormalTexture = static_cast<int16_t>(textures.GetImage(data.normalMap));
+            material.MetallicRoughnessTexture = static_cast<int16_t>(textures.GetImage(data.metallicRoughnessMap));
+            material.OcclusionTexture = static_cast<int16_t>(textures.GetImage(data.occlusionMap));
+            material.EmissiveTexture = static_cast<int16_t>(textures.GetImage(data.emissiveMap));
+            material.AlphaMode =
+                data.alphaMode == GLTFAlphaMode::Mask ? AlphaMask :
+                data.alphaMode == GLTFAlphaMode::Blend ? AlphaBlend : AlphaOpaque;
+            material.DoubleSided = data.doubleSided ? 1 : 0;
+            return material;
+        }
+    }
+
+    uint32_t OptionFlags(const MeshImport::Options& options) {
+        return (options.Optimize ? OptimizeFlag : 0) | (options.GenerateTangents ? GenerateTangentsFlag : 0);
+    }
+
+    bool Compile(const std::string& gltfFilename, const MeshImport::Options& options, SceneData& scene) {
+        std::string filename = gltfFilename;
+        GLTFLoader loader(filename);
+        if (!loader.LoadModel()) {
+            return false;
+        }
+
+        MeshImport::VertexLayout layout;
+        layout.Stride = sizeof(Vertex);
+        layout.PositionOffset = offsetof(Vertex, Pos);
+        layout.NormalOffset = offsetof(Vertex, Normal);
+        layout.TexCOffset = offsetof(Vertex, TexC);
+        layout.TangentOffset = offsetof(Vertex, TangentU);
+
+        MeshImport::Options importOptions = options;
+        importOptions.BuildMeshlets = true;
+        importOptions.MaxLods = MaxLods;
+        std::vector<MeshImport::ScenePrimitive> primitives = MeshImport::ImportScene(loader, layout, importOptions);
+
+        scene = SceneData();
+        scene.Transform = options.Transform;
+        scene.OptionFlags = OptionFlags(options);
+        scene.BufferFiles = loader.GetBufferFiles();
+
+        uint64_t vertexCount = 0;
+        uint64_t indexCount = 0;
+        uint64_t meshletCount = 0;
+        uint64_t meshletVertexCount = 0;
+        uint64_t meshletTriangleCount = 0;
+        uint64_t lodCount = 0;
+        for (const auto& primitive : primitives) {
+            vertexCount += primitive.Geometry.VertexCount;
+            indexCount += primitive.Geometry.IndexCount;
+            for (const auto& lod : primitive.Geometry.Lods) {
+                indexCount += lod.Indices.size();
+            }
+            lodCount += primitive.Geometry.Lods.size();
+            meshletCount += primitive.Geometry.Meshlets.Meshlets.size();
+            meshletVertexCount += primitive.Geometry.Meshlets.Vertices.size();
+            meshletTriangleCount += primitive.Geometry.Meshlets.Triangles.size();
+            if (primitive.Geometry.IndexStride == sizeof(uint32_t)) {
+                scene.IndexStride = sizeof(uint32_t);
+            }
+        }
+        if (vertexCount > UINT32_MAX || indexCount > UINT32_MAX ||
+            meshletCount > UINT32_MAX || meshletVertexCount > UINT32_MAX || meshletTriangleCount > UINT32_MAX || lodCount > UINT32_MAX) {
+            return false;
+        }
+
+        scene.VertexData.reserve(vertexCount * sizeof(Vertex));
+        scene.IndexData.reserve(indexCount * scene.IndexStride);
+        scene.Submeshes.reserve(primitives.size());
+        scene.SubmeshOptimization.reserve(primitives.size());
+        scene.Meshlets.Meshlets.reserve(meshletCount);
+        scene.Meshlets.MeshletBounds.reserve(meshletCount);
+        scene.Meshlets.Vertices.reserve(meshletVertexCount);
+        scene.Meshlets.Triangles.reserve(meshletTriangleCount);
+        scene.Lods.reserve(lodCount);
+
+        DirectX::XMVECTOR sceneMin = DirectX::XMVectorReplicate(FLT_MAX);
+        DirectX::XMVECTOR sceneMax = DirectX::XMVectorReplicate(-FLT_MAX);
+
+        for (const auto& primitive : primitives) {
+            const MeshImport::Mesh& mesh = primitive.Geometry;
+
+            Submesh submesh = {};
+            submesh.StartIndexLocation = scene.IndexCount;
+            submesh.IndexCount = mesh.IndexCount;
+            submesh.BaseVertexLocation = scene.VertexCount;
+            submesh.VertexCount = mesh.VertexCount;
+            submesh.Material = primitive.Material;
+            submesh.Texture = primitive.Texture;
+            submesh.MeshletOffset = static_cast<uint32_t>(scene.Meshlets.Meshlets.size());
+            submesh.MeshletCount = static_cast<uint32_t>(mesh.Meshlets.Meshlets.size());
+            submesh.LodOffset = static_cast<uint32_t>(scene.Lods.size());
+            submesh.LodCount = static_cast<uint32_t>(mesh.Lods.size());
+            submesh.BoundsCenter = mesh.BoundsCenter;
+            submesh.BoundsExtents = mesh.BoundsExtents;
+            scene.Submeshes.push_back(submesh);
+            scene.SubmeshOptimization.push_back(mesh.Optimization);
+
+            // The submesh's meshlets index the scene-wide meshlet tables.
+            const uint32_t meshletVertexOffset = static_cast<uint32_t>(scene.Meshlets.Vertices.size());
+            const uint32_t meshletTriangleOffset = static_cast<uint32_t>(scene.Meshlets.Triangles.size());
+            for (Meshlets::Meshlet meshlet : mesh.Meshlets.Meshlets) {
+                meshlet.VertexOffset += meshletVertexOffset;
+                meshlet.TriangleOffset += meshletTriangleOffset;
+                scene.Meshlets.Meshlets.push_back(meshlet);
+            }
+            scene.Meshlets.MeshletBounds.insert(
+                scene.Meshlets.MeshletBounds.end(), mesh.Meshlets.MeshletBounds.begin(), mesh.Meshlets.MeshletBounds.end()
+            );
+            scene.Meshlets.Vertices.insert(scene.Meshlets.Vertices.end(), mesh.Meshlets.Vertices.begin(), mesh.Meshlets.Vertices.end());
+            scene.Meshlets.Triangles.insert(scene.Meshlets.Triangles.end(), mesh.Meshlets.Triangles.begin(), mesh.Meshlets.Triangles.end());
+
+            scene.VertexData.insert(scene.VertexData.end(), mesh.VertexData.begin(), mesh.VertexData.end());
+            scene.VertexCount += mesh.VertexCount;
+
+            if (mesh.IndexStride == scene.IndexStride) {
+                scene.IndexData.insert(scene.IndexData.end(), mesh.IndexData.begin(), mesh.IndexData.end());
+            } else {
+                // A 16-bit primitive in a scene with 32-bit indices.
+                const uint16_t* indices16 = reinterpret_cast<const uint16_t*>(mesh.IndexData.data());
+                size_t offset = scene.IndexData.size();
+                scene.IndexData.resize(offset + size_t(mesh.IndexCount) * sizeof(uint32_t));
+                uint32_t* indices32 = reinterpret_cast<uint32_t*>(scene.IndexData.data() + offset);
+                for (uint32_t i = 0; i < mesh.IndexCount; ++i) {
+                    indices32[i] = indices16[i];
+                }
+            }
+            scene.IndexCount += mesh.IndexCount;
+
+            // The submesh's levels of detail, right after its own indices.
+            for (const MeshSimplify::Lod& lod : mesh.Lods) {
+                scene.Lods.push_back({ scene.IndexCount, static_cast<uint32_t>(lod.Indices.size()), lod.Error });
+
+                size_t offset = scene.IndexData.size();
+                scene.IndexData.resize(offset + lod.Indices.size() * scene.IndexStride);
+                if (scene.IndexStride == sizeof(uint32_t)) {
+                    memcpy(scene.IndexData.data() + offset, lod.Indices.data(), lod.Indices.size() * sizeof(uint32_t));
+                } else {
+                    uint16_t* indices16 = reinterpret_cast<uint16_t*>(scene.IndexData.data() + offset);
+                    for (size_t i = 0; i < lod.Indices.size(); ++i) {
+                        indices16[i] = static_cast<uint16_t>(lod.Indices[i]);
+                    }
+                }
+                scene.IndexCount += static_cast<uint32_t>(lod.Indices.size());
+            }
+
+            if (mesh.VertexCount > 0) {
+                DirectX::XMVECTOR center = DirectX::XMLoadFloat3(&mesh.BoundsCenter);
+                DirectX::XMVECTOR extents = DirectX::XMLoadFloat3(&mesh.BoundsExtents);
+                sceneMin = DirectX::XMVectorMin(sceneMin, DirectX::XMVectorSubtract(center, extents));
+                sceneMax = DirectX::XMVectorMax(sceneMax, DirectX::XMVectorAdd(center, extents));
+            }
+        }
+
+        if (scene.VertexCount > 0) {
+            DirectX::XMStoreFloat3(&scene.BoundsCenter, DirectX::XMVectorScale(DirectX::XMVectorAdd(sceneMin, sceneMax), 0.5f));
+            DirectX::XMStoreFloat3(&scene.BoundsExtents, DirectX::XMVectorScale(DirectX::XMVectorSubtract(sceneMax, sceneMin), 0.5f));
+        }
+
+        std::vector<GLTFTextureData> textures = loader.LoadTextures();
+        GLTFTextureTable textureTable = GLTFLoader::DeduplicateTextures(textures);
+        // Texture indices are stored in 16 bits.
+        if (textureTable.images.size() > INT16_MAX) {
+            return false;
+        }
+        for (const auto& image : textureTable.images) {
+            scene.Textures.push_back(image.uri);
+            scene.TextureByteSizes.push_back(DDSByteSize(image.uri));
+        }
+        for (auto& submesh : scene.Submeshes) {
+            submesh.Texture = textureTable.GetImage(submesh.Texture);
+        }
+
+        TextureStats& stats = scene.TextureStatistics;
+        stats.SourceTextureCount = static_cast<uint32_t>(textures.size());
+        stats.ImageCount = static_cast<uint32_t>(textureTable.images.size());
+        for (size_t i = 0; i < textures.size(); ++i) {
+            stats.SourceTextureBytes += scene.TextureByteSizes[textureTable.textureImages[i]];
+        }
+        for (uint64_t byteSize : scene.TextureByteSizes) {
+            stats.ImageBytes += byteSize;
+        }
+
+        for (const auto& material : loader.LoadMaterials(textures)) {
+            scene.Materials.push_back(ToMaterial(material, textureTable));
+            for (int map : { material.baseColorMap, material.normalMap, material.metallicRoughnessMap, material.occlusionMap, material.emissiveMap }) {
+                stats.MaterialSlotCount += map != -1 ? 1 : 0;
+            }
+        }
+
+        return true;
+    }
+
+    bool Write(const std::string& filename, const SceneData& scene) {
+        // Texture paths are stored relative to the pack, so that the pack can
+        // be opened from any working directory.
+        std::filesystem::path directory = std::filesystem::absolute(filename).parent_path();
+
+        // So are buffer file paths.
+        std::string strings;
+        std::vector<Texture> textures;
+        for (size_t i = 0; i < scene.Textures.size(); ++i) {
+            std::string relativePath = std::filesystem::absolute(scene.Textures[i]).lexically_relative(directory).generic_string();
+            uint64_t byteSize = i < scene.TextureByteSizes.size() ? scene.TextureByteSizes[i] : 0;
+            textures.push_back({ static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(relativePath.size()), byteSize });
+            strings += relativePath;
+        }
+        std::vector<BufferFile> bufferFiles;
+        for (const std::string& bufferFile : scene.BufferFiles) {
+            std::string relativePath = std::filesystem::absolute(bufferFile).lexically_relative(directory).generic_string();
+            bufferFiles.push_back({ static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(relativePath.size()) });
+            strings += relativePath;
+        }
+
+        Header header = {};
+        header.Magic = Magic;
+        header.Version = Version;
+        header.VertexCount = scene.VertexCount;
+        header.VertexStride = sizeof(Vertex);
+        header.IndexCount = scene.IndexCount;
+        header.IndexStride = scene.IndexStride;
+        header.SubmeshCount = static_cast<uint32_t>(scene.Submeshes.size());
+        header.MaterialCount = static_cast<uint32_t>(scene.Materials.size());
+        header.TextureCount = static_cast<uint32_t>(textures.size());
+        header.StringDataSize = static_cast<uint32_t>(strings.size());
+        header.MeshletCount = static_cast<uint32_t>(scene.Meshlets.Meshlets.size());
+        header.MeshletVertexCount = static_cast<uint32_t>(scene.Meshlets.Vertices.size());
+        header.MeshletTriangleCount = static_cast<uint32_t>(scene.Meshlets.Triangles.size());
+        header.LodCount = static_cast<uint32_t>(scene.Lods.size());
+        header.BufferFileCount = static_cast<uint32_t>(bufferFiles.size());
+        header.Transform = scene.Transform;
+        header.OptionFlags = scene.OptionFlags;
+        header.BoundsCenter = scene.BoundsCenter;
+        header.BoundsExtents = scene.BoundsExtents;
+        header.SubmeshOffset = AlignTo16(sizeof(Header));
+        header.MaterialOffset = AlignTo64(header.SubmeshOffset + scene.Submeshes.size() * sizeof(Submesh));
+        header.TextureOffset = AlignTo16(header.MaterialOffset + scene.Materials.size() * sizeof(Material));
+        header.StringOffset = AlignTo16(header.TextureOffset + textures.size() * sizeof(Texture));
+        header.VertexOffset = AlignTo16(header.StringOffset + strings.size());
+        header.IndexOffset = AlignTo16(header.VertexOffset + scene.VertexData.size());
+        header.MeshletOffset = AlignTo16(header.IndexOffset + scene.IndexData.size());
+        header.MeshletBoundsOffset = AlignTo16(header.MeshletOffset + header.MeshletCount * sizeof(Meshlets::Meshlet));
+        header.MeshletVertexOffset = AlignTo16(header.MeshletBoundsOffset + header.MeshletCount * sizeof(Meshlets::Bounds));
+        header.MeshletTriangleOffset = AlignTo16(header.MeshletVertexOffset + header.MeshletVertexCount * sizeof(uint32_t));
+        header.LodOffset = AlignTo16(header.MeshletTriangleOffset + header.MeshletTriangleCount * sizeof(uint32_t));
+        header.BufferFileOffset = AlignTo16(header.LodOffset + header.LodCount * sizeof(Lod));
+
+        // Write to a temporary file and rename it, so that a reader never maps
+        // a half-written pack. A failed write leaves neither behind.
+        std::string tempFilename = filename + ".tmp";
+        bool written = false;
+        {
+            std::ofstream fout(tempFilename, std::ios::binary | std::ios::trunc);
+            fout.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            WritePadding(fout, sizeof(header), header.SubmeshOffset);
+            fout.write(reinterpret_cast<const char*>(scene.Submeshes.data()), scene.Submeshes.size() * sizeof(Submesh));
+            WritePadding(fout, header.SubmeshOffset + scene.Submeshes.size() * sizeof(Submesh), header.MaterialOffset);
+            fout.write(reinterpret_cast<const char*>(scene.Materials.data()), scene.Materials.size() * sizeof(Material));
+            WritePadding(fout, header.MaterialOffset + scene.Materials.size() * sizeof(Material), header.TextureOffset);
+            fout.write(reinterpret_cast<const char*>(textures.data()), textures.size() * sizeof(Texture));
+            WritePadding(fout, header.TextureOffset + textures.size() * sizeof(Texture), header.StringOffset);
+            fout.write(strings.data(), strings.size());
+            WritePadding(fout, header.StringOffset + strings.size(), header.VertexOffset);
+            fout.write(reinterpret_cast<const char*>(scene.VertexData.data()), scene.VertexData.size());
+            WritePadding(fout, header.VertexOffset + scene.VertexData.size(), header.IndexOffset);
+            fout.write(reinterpret_cast<const char*>(scene.IndexData.data()), scene.IndexData.size());
+            WritePadding(fout, header.IndexOffset + scene.IndexData.size(), header.MeshletOffset);
+            fout.write(reinterpret_cast<const char*>(scene.Meshlets.Meshlets.data()), header.MeshletCount * sizeof(Meshlets::Meshlet));
+            WritePadding(fout, header.MeshletOffset + header.MeshletCount * sizeof(Meshlets::Meshlet), header.MeshletBoundsOffset);
+            fout.write(reinterpret_cast<const char*>(scene.Meshlets.MeshletBounds.data()), header.MeshletCount * sizeof(Meshlets::Bounds));
+            WritePadding(fout, header.MeshletBoundsOffset + header.MeshletCount * sizeof(Meshlets::Bounds), header.MeshletVertexOffset);
+            fout.write(reinterpret_cast<const char*>(scene.Meshlets.Vertices.data()), header.MeshletVertexCount * sizeof(uint32_t));
+            WritePadding(fout, header.MeshletVertexOffset + header.MeshletVertexCount * sizeof(uint32_t), header.MeshletTriangleOffset);
+            fout.write(reinterpret_cast<const char*>(scene.Meshlets.Triangles.data()), header.MeshletTriangleCount * sizeof(uint32_t));
+            WritePadding(fout, header.MeshletTriangleOffset + header.MeshletTriangleCount * sizeof(uint32_t), header.LodOffset);
+            fout.write(reinterpret_cast<const char*>(scene.Lods.data()), header.LodCount * sizeof(Lod));
+            WritePadding(fout, header.LodOffset + header.LodCount * sizeof(Lod), header.BufferFileOffset);
+            fout.write(reinterpret_cast<const char*>(bufferFiles.data()), bufferFiles.size() * sizeof(BufferFile));
+
+            fout.close();
+            written = !fout.fail();
+        }
+
+        std::error_code ec;
+        if (written) {
+            std::filesystem::rename(tempFilename, filename, ec);
+        }
+        if (!written || ec) {
+            std::filesystem::remove(tempFilename, ec);
+            return false;
+        }
+        return true;
+    }
+
+    bool CompileFile(const std::string& gltfFilename, const std::string& packFilename, const MeshImport::Options& options) {
+        SceneData scene;
+        if (!Compile(gltfFilename, options, scene)) {
+            return false;
+        }
+        return Write(packFilename, scene);
+    }
+
+    bool File::Open(const std::string& filename) {
+        mHeader = nullptr;
+
+        if (!mFile.Open(filename) || mFile.Size() < sizeof(Header)) {
+            mFile.Close();
+            return false;
+        }
+
+        const uint64_t size = mFile.Size();
+        auto header = reinterpret_cast<const Header*>(mFile.Data());
+        bool valid =
+            header->Magic == Magic &&
+            header->Version == Version &&
+            header->VertexStride == sizeof(Vertex) &&
+            (header->IndexStride == sizeof(uint16_t) || header->IndexStride == sizeof(uint32_t)) &&
+            InFile(header->SubmeshOffset, header->SubmeshCount, sizeof(Submesh), size) &&
+            InFile(header->MaterialOffset, header->MaterialCount, sizeof(Material), size) &&
+            InFile(header->TextureOffset, header->TextureCount, sizeof(Texture), size) &&
+            InFile(header->StringOffset, header->StringDataSize, 1, size) &&
+            InFile(header->VertexOffset, header->VertexCount, header->VertexStride, size) &&
+            InFile(header->IndexOffset, header->IndexCount, header->IndexStride, size) &&
+            InFile(header->MeshletOffset, header->MeshletCount, sizeof(Meshlets::Meshlet), size) &&
+            InFile(header->MeshletBoundsOffset, header->MeshletCount, sizeof(Meshlets::Bounds), size) &&
+            InFile(header->MeshletVertexOffset, header->MeshletVertexCount, sizeof(uint32_t), size) &&
+            InFile(header->MeshletTriangleOffset, header->MeshletTriangleCount, sizeof(uint32_t), size) &&
+            InFile(header->LodOffset, header->LodCount, sizeof(Lod), size) &&
+            InFile(header->BufferFileOffset, header->BufferFileCount, sizeof(BufferFile), size);
+
+        // Draw ranges, table indices and paths must stay inside their streams,
+        // so that the samples can upload and draw them without checking.
+        auto submeshes = reinterpret_cast<const Submesh*>(mFile.Data() + header->SubmeshOffset);
+        for (uint32_t i = 0; valid && i < header->SubmeshCount; ++i) {
+            valid =
+                uint64_t(submeshes[i].StartIndexLocation) + submeshes[i].IndexCount <= header->IndexCount &&
+                uint64_t(submeshes[i].BaseVertexLocation) + submeshes[i].VertexCount <= header->VertexCount &&
+                submeshes[i].Material >= -1 && submeshes[i].Material < int64_t(header->MaterialCount) &&
+                submeshes[i].Texture >= -1 && submeshes[i].Texture < int64_t(header->TextureCount) &&
+                uint64_t(submeshes[i].MeshletOffset) + submeshes[i].MeshletCount <= header->MeshletCount &&
+                uint64_t(submeshes[i].LodOffset) + submeshes[i].LodCount <= header->LodCount;
+        }
+        auto lods = reinterpret_cast<const Lod*>(mFile.Data() + header->LodOffset);
+        for (uint32_t i = 0; valid && i < header->LodCount; ++i) {
+            valid = uint64_t(lods[i].StartIndexLocation) + lods[i].IndexCount <= header->IndexCount;
+        }
+        // So must meshlets, for a mesh shader.
+        auto meshlets = reinterpret_cast<const Meshlets::Meshlet*>(mFile.Data() + header->MeshletOffset);
+        auto meshletVertices = reinterpret_cast<const uint32_t*>(mFile.Data() + header->MeshletVertexOffset);
+        auto meshletTriangles = reinterpret_cast<const uint32_t*>(mFile.Data() + header->MeshletTriangleOffset);
+        for (uint32_t i = 0; valid && i < header->SubmeshCount; ++i) {
+            for (uint32_t m = submeshes[i].MeshletOffset; valid && m < submeshes[i].MeshletOffset + submeshes[i].MeshletCount; ++m) {
+                const Meshlets::Meshlet& meshlet = meshlets[m];
+                valid =
+                    meshlet.VertexCount <= Meshlets::MaxVertices && meshlet.TriangleCount <= Meshlets::MaxTriangles &&
+                    uint64_t(meshlet.VertexOffset) + meshlet.VertexCount <= header->MeshletVertexCount &&
+                    uint64_t(meshlet.TriangleOffset) + meshlet.TriangleCount <= header->MeshletTriangleCount;
+                for (uint32_t v = 0; valid && v < meshlet.VertexCount; ++v) {
+                    valid = meshletVertices[meshlet.VertexOffset + v] < submeshes[i].VertexCount;
+                }
+                for (uint32_t t = 0; valid && t < meshlet.TriangleCount; ++t) {
+                    uint32_t i0, i1, i2;
+                    Meshlets::UnpackTriangle(meshletTriangles[meshlet.TriangleOffset + t], i0, i1, i2);
+                    valid = i0 < meshlet.VertexCount && i1 < meshlet.VertexCount && i2 < meshlet.VertexCount;
+                }
+            }
+        }
+        auto materials = reinterpret_cast<const Material*>(mFile.Data() + header->MaterialOffset);
+        for (uint32_t i = 0; valid && i < header->MaterialCount; ++i) {
+            for (int16_t texture : {
+                materials[i].BaseColorTexture, materials[i].NormalTexture, materials[i].MetallicRoughnessTexture,
+                materials[i].OcclusionTexture, materials[i].EmissiveTexture
+            }) {
+                valid = valid && texture >= -1 && texture < int32_t(header->TextureCount);
+            }
+        }
+        auto textures = reinterpret_cast<const Texture*>(mFile.Data() + header->TextureOffset);
+        for (uint32_t i = 0; valid && i < header->TextureCount; ++i) {
+            valid = uint64_t(textures[i].PathOffset) + textures[i].PathLength <= header->StringDataSize;
+        }
+        auto bufferFiles = reinterpret_cast<const BufferFile*>(mFile.Data() + header->BufferFileOffset);
+        for (uint32_t i = 0; valid && i < header->BufferFileCount; ++i) {
+            valid = uint64_t(bufferFiles[i].PathOffset) + bufferFiles[i].PathLength <= header->StringDataSize;
+        }
+
+        if (!valid) {
+            mFile.Close();
+            return false;
+        }
+
+        mHeader = header;
+        mDirectory = std::filesystem::path(filename).parent_path().generic_string();
+        return true;
+    }
+
+    const Header& File::GetHeader() const {
+        return *mHeader;
+    }
+
+    const Submesh* File::Submeshes() const {
+        return reinterpret_cast<const Submesh*>(mFile.Data() + mHeader->SubmeshOffset);
+    }
+
+    const Material* File::Materials() const {
+        return reinterpret_cast<const Material*>(mFile.Data() + mHeader->MaterialOffset);
+    }
+
+    std::string File::TexturePath(uint32_t textureIdx) const {
+        const Texture& texture = reinterpret_cast<const Texture*>(mFile.Data() + mHeader->TextureOffset)[textureIdx];
+        return Path(texture.PathOffset, texture.PathLength);
+    }
+
+    std::string File::BufferFilePath(uint32_t bufferFileIdx) const {
+        const BufferFile& bufferFile = reinterpret_cast<const BufferFile*>(mFile.Data() + mHeader->BufferFileOffset)[bufferFileIdx];
+        return Path(bufferFile.PathOffset, bufferFile.PathLength);
+    }
+
+    std::string File::Path(uint32_t offset, uint32_t length) const {
+        std::string path(reinterpret_cast<const char*>(mFile.Data() + mHeader->StringOffset + offset), length);
+        return (std::filesystem::path(mDirectory) / path).lexically_normal().generic_string();
+    }
+
+    uint64_t File::TextureByteSize(uint32_t textureIdx) const {
+        return reinterpret_cast<const Texture*>(mFile.Data() + mHeader->TextureOffset)[textureIdx].ByteSize;
+    }
+
+    const Meshlets::Meshlet* File::Meshlets() const {
+        return reinterpret_cast<const Meshlets::Meshlet*>(mFile.Data() + mHeader->MeshletOffset);
+    }
+
+    const Meshlets::Bounds* File::MeshletBounds() const {
+        return reinterpret_cast<const Meshlets::Bounds*>(mFile.Data() + mHeader->MeshletBoundsOffset);
+    }
+
+    const uint32_t* File::MeshletVertices() const {
+        return reinterpret_cast<const uint32_t*>(mFile.Data() + mHeader->MeshletVertexOffset);
+    }
+
+    const uint32_t* File::MeshletTriangles() const {
+        return reinterpret_cast<const uint32_t*>(mFile.Data() + mHeader->MeshletTriangleOffset);
+    }
+
+    const Lod* File::Lods() const {
+        return reinterpret_cast<const Lod*>(mFile.Data() + mHeader->LodOffset);
+    }
+
+    const void* File::VertexData() const {
+        return mFile.Data() + mHeader->VertexOffset;
+    }
+
+    size_t File::VertexDataSize() const {
+        return size_t(mHeader->VertexCount) * mHeader->VertexStride;
+    }
+
+    const void* File::IndexData() const {
+        return mFile.Data() + mHeader->IndexOffset;
+    }
+
+    size_t File::IndexDataSize() const {
+        return size_t(mHeader->IndexCount) * mHeader->IndexStride;
+    }
+
+    bool OpenOrCompile(
+        const std::string& gltfFilename, const std::string& packFilename, const MeshImport::Options& options, File& file
+    ) {
+        std::error_code ec;
+        auto packTime = std::filesystem::last_write_time(packFilename, ec);
+        // Source files that are missing leave the pack as it is.
+        auto newer = [&packTime](const std::string& sourceFilename) {
+            std::error_code sourceEc;
+            auto sourceTime = std::filesystem::last_write_time(sourceFilename, sourceEc);
+            return !sourceEc && sourceTime > packTime;
+        };
+
+        bool current = !ec && !newer(gltfFilename) && file.Open(packFilename) &&
+            file.GetHeader().OptionFlags == OptionFlags(options) &&
+            memcmp(&file.GetHeader().Transform, &options.Transform, sizeof(options.Transform)) == 0;
+        for (uint32_t i = 0; current && i < file.GetHeader().BufferFileCount; ++i) {
+            current = !newer(file.BufferFilePath(i));
+        }
+        if (current) {
+            return true;
+        }
+
+        // Unmap the old pack so that it can be replaced.
+        file = File();
+        return CompileFile(gltfFilename, packFilename, options) && file.Open(packFilename);
+    }
+};
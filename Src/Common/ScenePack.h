@@ -0,0 +1,260 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+#include "MeshCache.h"
+#include "MeshImport.h"
+#include "Meshlets.h"
+
+// Precompiled glTF scene. A pack holds the default scene of a glTF file run
+// through MeshImport: the vertices and indices of every primitive in a single
+// vertex stream and a single index stream, ready to upload, plus per-submesh
+// draw ranges and bounds, the material table, the texture paths, and the
+// meshlets and levels of detail of every submesh. Loading one is a memory map;
+// there is no JSON to parse and nothing to rebuild.
+//
+// File layout (little endian): a Header, then SubmeshCount Submesh structs,
+// MaterialCount Material structs, TextureCount Texture structs, StringDataSize
+// bytes of texture and buffer file paths, VertexCount vertices of VertexStride
+// bytes, IndexCount indices of IndexStride bytes, MeshletCount
+// Meshlets::Meshlet and Meshlets::Bounds structs, MeshletVertexCount uint32
+// meshlet vertices, MeshletTriangleCount uint32 meshlet triangles, LodCount
+// Lod structs and BufferFileCount BufferFile structs, each at its offset in
+// the Header. The indices of a submesh's levels of detail follow its own in
+// the index stream. Every offset is 16-byte aligned, and the
+// material table 64-byte aligned.
+namespace ScenePack {
+    // "SCPK".
+    const uint32_t Magic = 0x4B504353;
+
+    // Bump when any of the structs below change, or Compile lays the data out
+    // differently; packs of other versions are rebuilt.
+    const uint32_t Version = 7;
+
+    // Levels of detail that Compile builds per submesh, at most; fewer when a
+    // submesh stops simplifying (see MeshSimplify::BuildLodChain).
+    const int MaxLods = 4;
+
+    // Same layout as the Vertex of the samples that use tangents.
+    using Vertex = MeshCache::Vertex;
+
+    // A simplified index list of a submesh, drawn with the submesh's
+    // BaseVertexLocation.
+    using Lod = MeshCache::Lod;
+
+    struct Header {
+        uint32_t Magic;
+        uint32_t Version;
+        uint32_t VertexCount;
+        uint32_t VertexStride;
+        uint32_t IndexCount;
+        // 2 if every submesh has at most 0x10000 vertices, 4 otherwise.
+        uint32_t IndexStride;
+        uint32_t SubmeshCount;
+        uint32_t MaterialCount;
+        uint32_t TextureCount;
+        uint32_t StringDataSize;
+        uint32_t MeshletCount;
+        uint32_t MeshletVertexCount;
+        uint32_t MeshletTriangleCount;
+        uint32_t LodCount;
+        uint32_t BufferFileCount;
+        // MeshImport::Options that the scene was compiled with: the transform,
+        // and the rest as OptionFlags.
+        DirectX::XMFLOAT4X4 Transform;
+        uint32_t OptionFlags;
+        // Of the whole scene.
+        DirectX::XMFLOAT3 BoundsCenter;
+        DirectX::XMFLOAT3 BoundsExtents;
+        uint64_t SubmeshOffset;
+        uint64_t MaterialOffset;
+        uint64_t TextureOffset;
+        uint64_t StringOffset;
+        uint64_t VertexOffset;
+        uint64_t IndexOffset;
+        uint64_t MeshletOffset;
+        uint64_t MeshletBoundsOffset;
+        uint64_t MeshletVertexOffset;
+        uint64_t MeshletTriangleOffset;
+        uint64_t LodOffset;
+        uint64_t BufferFileOffset;
+    };
+
+    // Header::OptionFlags. Compile always builds meshlets and MaxLods levels
+    // of detail, so only these options change what it outputs.
+    const uint32_t OptimizeFlag = 1u << 0;
+    const uint32_t GenerateTangentsFlag = 1u << 1;
+
+    uint32_t OptionFlags(const MeshImport::Options& options);
+
+    // A glTF primitive. Indices are relative to BaseVertexLocation, which is
+    // what lets them be 16-bit.
+    struct Submesh {
+        uint32_t StartIndexLocation;
+        uint32_t IndexCount;
+        uint32_t BaseVertexLocation;
+        uint32_t VertexCount;
+        // Into the material and texture tables, -1 for none.
+        int32_t Material;
+        int32_t Texture;
+        // Into the meshlet tables. Meshlet vertices are relative to
+        // BaseVertexLocation, like the indices.
+        uint32_t MeshletOffset;
+        uint32_t MeshletCount;
+        // Into the level of detail table, finest first.
+        uint32_t LodOffset;
+        uint32_t LodCount;
+        DirectX::XMFLOAT3 BoundsCenter;
+        DirectX::XMFLOAT3 BoundsExtents;
+    };
+
+    enum AlphaMode : uint8_t {
+        AlphaOpaque,
+        AlphaMask,
+        AlphaBlend
+    };
+
+    // A glTF metallic-roughness material (see GLTFMaterialData), one cache
+    // line each. Texture indices are into the texture table, -1 for none.
+    struct Material {
+        DirectX::XMFLOAT4 BaseColorFactor;
+        DirectX::XMFLOAT3 EmissiveFactor;
+        float AlphaCutoff;
+        float MetallicFactor;
+        float RoughnessFactor;
+        float NormalScale;
+        float OcclusionStrength;
+        int16_t BaseColorTexture;
+        int16_t NormalTexture;
+        int16_t MetallicRoughnessTexture;
+        int16_t OcclusionTexture;
+        int16_t EmissiveTexture;
+        // An AlphaMode.
+        uint8_t AlphaMode;
+        uint8_t DoubleSided;
+        uint32_t Pad;
+    };
+    static_assert(sizeof(Material) == 64, "Material must fill a cache line");
+
+    // A unique image: glTF textures that resolve to the same DDS file share
+    // one entry, so the table is what a sample has to load. The path is
+    // relative to the directory of the pack, in the string data.
+    struct Texture {
+        uint32_t PathOffset;
+        uint32_t PathLength;
+        // Of the DDS surface data (all mips and array slices), 0 if the file
+        // couldn't be read when the pack was compiled.
+        uint64_t ByteSize;
+    };
+
+    // An external buffer file of the glTF scene (GLTFLoader::GetBufferFiles),
+    // for OpenOrCompile to check. The path is stored like a texture's.
+    struct BufferFile {
+        uint32_t PathOffset;
+        uint32_t PathLength;
+    };
+
+    // What texture deduplication saved, for reporting.
+    struct TextureStats {
+        // glTF textures, and the material slots that reference one.
+        uint32_t SourceTextureCount = 0;
+        uint32_t MaterialSlotCount = 0;
+        // Unique DDS files.
+        uint32_t ImageCount = 0;
+        // Surface bytes of every glTF texture loaded on its own, and of the
+        // unique images.
+        uint64_t SourceTextureBytes = 0;
+        uint64_t ImageBytes = 0;
+    };
+
+    struct SceneData {
+        std::vector<uint8_t> VertexData;
+        uint32_t VertexCount = 0;
+        std::vector<uint8_t> IndexData;
+        uint32_t IndexCount = 0;
+        uint32_t IndexStride = sizeof(uint16_t);
+        std::vector<Submesh> Submeshes;
+        std::vector<Material> Materials;
+        // DDS paths of the unique images (GLTFLoader::DeduplicateTextures).
+        std::vector<std::string> Textures;
+        std::vector<uint64_t> TextureByteSizes;
+        TextureStats TextureStatistics;
+        // Of each submesh; not stored in the pack.
+        std::vector<MeshImport::OptimizeReport> SubmeshOptimization;
+        // Of every submesh, one after another (see Submesh::MeshletOffset).
+        Meshlets::MeshletData Meshlets;
+        // Of every submesh, one after another (see Submesh::LodOffset).
+        std::vector<Lod> Lods;
+        DirectX::XMFLOAT4X4 Transform;
+        uint32_t OptionFlags = 0;
+        // External buffer files of the glTF file.
+        std::vector<std::string> BufferFiles;
+        DirectX::XMFLOAT3 BoundsCenter = { 0.0f, 0.0f, 0.0f };
+        DirectX::XMFLOAT3 BoundsExtents = { 0.0f, 0.0f, 0.0f };
+    };
+
+    // Imports the default scene of a glTF file with MeshImport::ImportScene,
+    // meshlets and up to MaxLods levels of detail included, and concatenates
+    // its primitives. Textures are deduplicated by DDS file and material and
+    // submesh texture indices remapped to the unique images.
+    bool Compile(const std::string& gltfFilename, const MeshImport::Options& options, SceneData& scene);
+
+    bool Write(const std::string& filename, const SceneData& scene);
+
+    bool CompileFile(const std::string& gltfFilename, const std::string& packFilename, const MeshImport::Options& options);
+
+    // A pack file mapped into memory. The data pointers point into the mapping
+    // and are valid while the File is open.
+    class File {
+    public:
+        // Fails if the file is missing, truncated or of another version.
+        bool Open(const std::string& filename);
+
+        const Header& GetHeader() const;
+
+        const Submesh* Submeshes() const;
+        const Material* Materials() const;
+
+        const Meshlets::Meshlet* Meshlets() const;
+        const Meshlets::Bounds* MeshletBounds() const;
+        const uint32_t* MeshletVertices() const;
+        const uint32_t* MeshletTriangles() const;
+
+        const Lod* Lods() const;
+
+        // Path of a texture, relative to the working directory like the pack
+        // filename was.
+        std::string TexturePath(uint32_t textureIdx) const;
+
+        uint64_t TextureByteSize(uint32_t textureIdx) const;
+
+        // Path of a buffer file of the glTF scene, relative to the working
+        // directory like TexturePath.
+        std::string BufferFilePath(uint32_t bufferFileIdx) const;
+
+        const void* VertexData() const;
+        size_t VertexDataSize() const;
+
+        const void* IndexData() const;
+        size_t IndexDataSize() const;
+
+    private:
+        MappedFile mFile;
+        const Header* mHeader = nullptr;
+        std::string mDirectory;
+
+        std::string Path(uint32_t offset, uint32_t length) const;
+    };
+
+    // Opens packFilename, first (re)compiling it from gltfFilename if it is
+    // missing, older than the glTF file or one of its buffer files, of another
+    // version or compiled with other options.
+    bool OpenOrCompile(
+        const std::string& gltfFilename, const std::string& packFilename, const MeshImport::Options& options, File& file
+    );
+};
@@ -0,0 +1,253 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+
+namespace {
+    int64_t NowNanoseconds() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()
+        ).count();
+    }
+}
+
+// A single ParallelFor call. Lives on the caller's stack until all of its
+// tasks have run.
+struct ThreadPool::Job {
+    const std::function<void(int, int)>* fn = nullptr;
+    std::atomic<int> remaining{ 0 };
+
+    // The first exception fn threw; chunks that start after it are skipped.
+    std::atomic<bool> failed{ false };
+    std::mutex errorMutex;
+    std::exception_ptr error;
+};
+
+ThreadPool::ThreadPool(unsigned int workerCount) {
+    if (workerCount == 0) {
+        unsigned int hardwareThreads = std::thread::hardware_concurrency();
+        workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+    }
+
+    mWorkerCount = workerCount;
+
+    // The extra slot holds the deque and stats of the calling threads.
+    for (unsigned int i = 0; i <= mWorkerCount; ++i) {
+        mWorkers.push_back(std::make_unique<Worker>());
+    }
+
+    ResetStats();
+
+    for (unsigned int i = 0; i < mWorkerCount; ++i) {
+        mWorkers[i]->thread = std::thread(&ThreadPool::WorkerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mWakeMutex);
+        mStopping = true;
+    }
+    mWakeCondition.notify_all();
+
+    for (unsigned int i = 0; i < mWorkerCount; ++i) {
+        mWorkers[i]->thread.join();
+    }
+}
+
+ThreadPool& ThreadPool::Default() {
+    static ThreadPool pool;
+    return pool;
+}
+
+unsigned int ThreadPool::WorkerCount() const {
+    return mWorkerCount;
+}
+
+void ThreadPool::ParallelFor(int begin, int end, int grain, const std::function<void(int, int)>& fn) {
+    if (begin >= end) {
+        return;
+    }
+
+    grain = std::max(grain, 1);
+    const int taskCount = (end - begin + grain - 1) / grain;
+
+    Job job;
+    job.fn = &fn;
+
+    job.remaining = taskCount;
+
+    // Not worth a round trip through the deques.
+    if (taskCount == 1 || mWorkerCount == 0) {
+        for (int chunkBegin = begin; chunkBegin < end; chunkBegin += grain) {
+            RunTask(mWorkerCount, Task{ &job, chunkBegin, std::min(chunkBegin + grain, end) }, false);
+        }
+        if (job.error) {
+            std::rethrow_exception(job.error);
+        }
+        return;
+    }
+
+    // Deal the chunks out round-robin, starting at a different deque on every
+    // call so that concurrent callers don't all pile onto worker 0.
+    const unsigned int queueCount = static_cast<unsigned int>(mWorkers.size());
+    unsigned int queue = mNextQueue.fetch_add(1, std::memory_order_relaxed) % queueCount;
+    for (int chunkBegin = begin; chunkBegin < end; chunkBegin += grain) {
+        Worker& worker = *mWorkers[queue];
+        {
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            worker.tasks.push_back(Task{ &job, chunkBegin, std::min(chunkBegin + grain, end) });
+        }
+        queue = (queue + 1) % queueCount;
+    }
+
+    mQueuedTasks.fetch_add(taskCount);
+    {
+        // Taking the lock orders the increment above before any worker's
+        // predicate check, so no wakeup is lost.
+        std::lock_guard<std::mutex> lock(mWakeMutex);
+    }
+    mWakeCondition.notify_all();
+
+    // Help until every chunk of this job has run. The caller may end up
+    // running tasks of other jobs too, which is fine.
+    while (job.remaining.load(std::memory_order_acquire) > 0) {
+        Task task;
+        bool stolen = false;
+        if (PopTask(mWorkerCount, task, stolen)) {
+            RunTask(mWorkerCount, task, stolen);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+    if (job.error) {
+        std::rethrow_exception(job.error);
+    }
+}
+
+void ThreadPool::ParallelFor2D(
+    int rowBegin, int rowEnd, int colBegin, int colEnd,
+    int tileRows, int tileCols,
+    const std::function<void(int, int, int, int)>& fn
+) {
+    if (rowBegin >= rowEnd || colBegin >= colEnd) {
+        return;
+    }
+
+    tileRows = std::max(tileRows, 1);
+    tileCols = std::max(tileCols, 1);
+    const int tilesPerRow = (colEnd - colBegin + tileCols - 1) / tileCols;
+    const int tileCount = ((rowEnd - rowBegin + tileRows - 1) / tileRows) * tilesPerRow;
+
+    ParallelFor(0, tileCount, 1, [&](int tileBegin, int tileEnd) {
+        for (int tile = tileBegin; tile < tileEnd; ++tile) {
+            int r0 = rowBegin + (tile / tilesPerRow) * tileRows;
+            int c0 = colBegin + (tile % tilesPerRow) * tileCols;
+            fn(r0, std::min(r0 + tileRows, rowEnd), c0, std::min(c0 + tileCols, colEnd));
+        }
+    });
+}
+
+std::vector<ThreadPool::WorkerStats> ThreadPool::GetStats() const {
+    double elapsedSeconds = (NowNanoseconds() - mStatsStartNanoseconds.load()) * 1e-9;
+
+    std::vector<WorkerStats> stats(mWorkers.size());
+    for (size_t i = 0; i < mWorkers.size(); ++i) {
+        stats[i].tasks = mWorkers[i]->taskCount.load(std::memory_order_relaxed);
+        stats[i].steals = mWorkers[i]->stealCount.load(std::memory_order_relaxed);
+        stats[i].busySeconds = mWorkers[i]->busyNanoseconds.load(std::memory_order_relaxed) * 1e-9;
+        stats[i].utilization = elapsedSeconds > 0.0 ? stats[i].busySeconds / elapsedSeconds : 0.0;
+    }
+    return stats;
+}
+
+void ThreadPool::ResetStats() {
+    for (auto& worker : mWorkers) {
+        worker->taskCount = 0;
+        worker->stealCount = 0;
+        worker->busyNanoseconds = 0;
+    }
+    mStatsStartNanoseconds = NowNanoseconds();
+}
+
+void ThreadPool::WorkerLoop(unsigned int workerIdx) {
+    for (;;) {
+        Task task;
+        bool stolen = false;
+        if (PopTask(workerIdx, task, stolen)) {
+            RunTask(workerIdx, task, stolen);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mWakeMutex);
+        mWakeCondition.wait(lock, [this]() {
+            return mStopping || mQueuedTasks.load() > 0;
+        });
+        if (mStopping) {
+            return;
+        }
+    }
+}
+
+bool ThreadPool::PopTask(unsigned int workerIdx, Task& task, bool& stolen) {
+    if (mQueuedTasks.load() == 0) {
+        return false;
+    }
+
+    // Own deque first, oldest task first.
+    {
+        Worker& worker = *mWorkers[workerIdx];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (!worker.tasks.empty()) {
+            task = worker.tasks.front();
+            worker.tasks.pop_front();
+            mQueuedTasks.fetch_sub(1);
+            stolen = false;
+            return true;
+        }
+    }
+
+    // Then steal the newest task of the next nonempty deque.
+    const unsigned int queueCount = static_cast<unsigned int>(mWorkers.size());
+    for (unsigned int i = 1; i < queueCount; ++i) {
+        Worker& victim = *mWorkers[(workerIdx + i) % queueCount];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = victim.tasks.back();
+            victim.tasks.pop_back();
+            mQueuedTasks.fetch_sub(1);
+            stolen = true;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ThreadPool::RunTask(unsigned int statsIdx, const Task& task, bool stolen) {
+    int64_t start = NowNanoseconds();
+    if (!task.job->failed.load(std::memory_order_relaxed)) {
+        try {
+            (*task.job->fn)(task.begin, task.end);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(task.job->errorMutex);
+            if (!task.job->error) {
+                task.job->error = std::current_exception();
+            }
+            task.job->failed = true;
+        }
+    }
+    int64_t busy = NowNanoseconds() - start;
+
+    Worker& worker = *mWorkers[statsIdx];
+    worker.taskCount.fetch_add(1, std::memory_order_relaxed);
+    if (stolen) {
+        worker.stealCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    worker.busyNanoseconds.fetch_add(static_cast<uint64_t>(busy), std::memory_order_relaxed);
+
+    // Last: once remaining hits 0 the caller may return and destroy the job.
+    task.job->remaining.fetch_sub(1, std::memory_order_release);
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size pool of worker threads with one task deque per worker. A worker
+// pops tasks from the front of its own deque and, when it runs dry, steals from
+// the back of the others. The thread that calls ParallelFor helps execute the
+// loop until it completes, so nested ParallelFor calls don't deadlock.
+class ThreadPool {
+public:
+    struct WorkerStats {
+        // Number of tasks (chunks or tiles) executed.
+        uint64_t tasks = 0;
+        // Number of those tasks that were taken from another worker's deque.
+        uint64_t steals = 0;
+        // Time spent executing tasks, in seconds.
+        double busySeconds = 0.0;
+        // busySeconds divided by the time elapsed since the last ResetStats.
+        double utilization = 0.0;
+    };
+
+    // workerCount == 0 uses one worker per hardware thread, minus the caller's.
+    explicit ThreadPool(unsigned int workerCount = 0);
+    ThreadPool(const ThreadPool& rhs) = delete;
+    ThreadPool& operator=(const ThreadPool& rhs) = delete;
+    ~ThreadPool();
+
+    // Process-wide pool, created on first use.
+    static ThreadPool& Default();
+
+    unsigned int WorkerCount() const;
+
+    // Calls fn(chunkBegin, chunkEnd) over [begin, end) split into chunks of
+    // at most grain iterations, and returns when all chunks have run. If fn
+    // throws, the chunks that haven't started are skipped and the first
+    // exception is rethrown once the others have finished.
+    void ParallelFor(int begin, int end, int grain, const std::function<void(int, int)>& fn);
+
+    // Calls fn(rowBegin, rowEnd, colBegin, colEnd) over the 2D range split into
+    // tiles of at most tileRows x tileCols, and returns when all tiles have run.
+    void ParallelFor2D(
+        int rowBegin, int rowEnd, int colBegin, int colEnd,
+        int tileRows, int tileCols,
+        const std::function<void(int, int, int, int)>& fn
+    );
+
+    // One entry per worker, followed by one for the calling threads.
+    std::vector<WorkerStats> GetStats() const;
+    void ResetStats();
+
+private:
+    struct Job;
+
+    struct Task {
+        Job* job = nullptr;
+        int begin = 0;
+        int end = 0;
+    };
+
+    // Aligned so that one worker's counters don't share a cache line with
+    // another's.
+    struct alignas(64) Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::thread thread;
+
+        std::atomic<uint64_t> taskCount{ 0 };
+        std::atomic<uint64_t> stealCount{ 0 };
+        std::atomic<uint64_t> busyNanoseconds{ 0 };
+    };
+
+    // Workers followed by the stats slot shared by calling threads.
+    std::vector<std::unique_ptr<Worker>> mWorkers;
+    unsigned int mWorkerCount = 0;
+
+    // Tasks queued but not yet taken; workers sleep when it reaches 0.
+    std::atomic<int> mQueuedTasks{ 0 };
+    std::mutex mWakeMutex;
+    std::condition_variable mWakeCondition;
+    bool mStopping = false;
+
+    std::atomic<unsigned int> mNextQueue{ 0 };
+    std::atomic<int64_t> mStatsStartNanoseconds{ 0 };
+
+    void WorkerLoop(unsigned int workerIdx);
+
+    bool PopTask(unsigned int workerIdx, Task& task, bool& stolen);
+
+    void RunTask(unsigned int statsIdx, const Task& task, bool stolen);
+};
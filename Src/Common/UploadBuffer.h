@@ -48,4 +48,16 @@ public:
   {
     memcpy(&mMappedData[elementIndex * mElementByteSize], &data, sizeof(T));
   }
+
+  // For writing many elements in place. Elements are ElementByteSize() apart.
+  // The memory is write-combined: write it sequentially and don't read it.
+  BYTE* MappedData() const
+  {
+    return mMappedData;
+  }
+
+  UINT ElementByteSize() const
+  {
+    return mElementByteSize;
+  }
 };
\ No newline at end of file
@@ -0,0 +1,126 @@
+#include "VertexQuantize.h"
+
+#include <DirectXPackedVector.h>
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+namespace VertexQuantize {
+    namespace {
+        float EncodeAxis(float v, float center, float extent) {
+            return extent > 0.0f ? (v - center) / extent : 0.0f;
+        }
+
+        // Angle between two directions, 0 if either is zero. From the sine and
+        // the cosine, because the arc cosine alone can't resolve the small
+        // angles that quantization makes.
+        float AngleDegrees(const XMFLOAT3& a, const XMFLOAT3& b) {
+            XMVECTOR va = XMLoadFloat3(&a);
+            XMVECTOR vb = XMLoadFloat3(&b);
+            float sine = XMVectorGetX(XMVector3Length(XMVector3Cross(va, vb)));
+            float cosine = XMVectorGetX(XMVector3Dot(va, vb));
+            return sine == 0.0f && cosine == 0.0f ? 0.0f : XMConvertToDegrees(atan2f(sine, cosine));
+        }
+    }
+
+    int16_t EncodeSnorm16(float v) {
+        v = std::min(std::max(v, -1.0f), 1.0f);
+        return static_cast<int16_t>(lrintf(v * 32767.0f));
+    }
+
+    float DecodeSnorm16(int16_t v) {
+        return std::max(v / 32767.0f, -1.0f);
+    }
+
+    void EncodeOctahedral(const XMFLOAT3& v, int16_t encoded[2]) {
+        float l1 = fabsf(v.x) + fabsf(v.y) + fabsf(v.z);
+        if (l1 == 0.0f) {
+            encoded[0] = encoded[1] = 0;
+            return;
+        }
+
+        float x = v.x / l1;
+        float y = v.y / l1;
+        // The lower half folds over the diagonals onto the corners.
+        if (v.z < 0.0f) {
+            float fx = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+            float fy = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+            x = fx;
+            y = fy;
+        }
+        encoded[0] = EncodeSnorm16(x);
+        encoded[1] = EncodeSnorm16(y);
+    }
+
+    XMFLOAT3 DecodeOctahedral(const int16_t encoded[2]) {
+        float x = DecodeSnorm16(encoded[0]);
+        float y = DecodeSnorm16(encoded[1]);
+        float z = 1.0f - fabsf(x) - fabsf(y);
+        float t = std::max(-z, 0.0f);
+        x += x >= 0.0f ? -t : t;
+        y += y >= 0.0f ? -t : t;
+
+        XMFLOAT3 v;
+        XMStoreFloat3(&v, XMVector3Normalize(XMVectorSet(x, y, z, 0.0f)));
+        return v;
+    }
+
+    PackedVertex Encode(const MeshCache::Vertex& vertex, const Bounds& bounds) {
+        PackedVertex packed;
+        packed.Position[0] = EncodeSnorm16(EncodeAxis(vertex.Pos.x, bounds.Center.x, bounds.Extents.x));
+        packed.Position[1] = EncodeSnorm16(EncodeAxis(vertex.Pos.y, bounds.Center.y, bounds.Extents.y));
+        packed.Position[2] = EncodeSnorm16(EncodeAxis(vertex.Pos.z, bounds.Center.z, bounds.Extents.z));
+        packed.Position[3] = 0;
+        EncodeOctahedral(vertex.Normal, packed.Normal);
+        EncodeOctahedral(vertex.TangentU, packed.Tangent);
+        packed.TexC[0] = XMConvertFloatToHalf(vertex.TexC.x);
+        packed.TexC[1] = XMConvertFloatToHalf(vertex.TexC.y);
+        return packed;
+    }
+
+    MeshCache::Vertex Decode(const PackedVertex& vertex, const Bounds& bounds) {
+        MeshCache::Vertex decoded;
+        decoded.Pos.x = bounds.Center.x + DecodeSnorm16(vertex.Position[0]) * bounds.Extents.x;
+        decoded.Pos.y = bounds.Center.y + DecodeSnorm16(vertex.Position[1]) * bounds.Extents.y;
+        decoded.Pos.z = bounds.Center.z + DecodeSnorm16(vertex.Position[2]) * bounds.Extents.z;
+        decoded.Normal = DecodeOctahedral(vertex.Normal);
+        decoded.TangentU = DecodeOctahedral(vertex.Tangent);
+        decoded.TexC.x = XMConvertHalfToFloat(vertex.TexC[0]);
+        decoded.TexC.y = XMConvertHalfToFloat(vertex.TexC[1]);
+        return decoded;
+    }
+
+    void Encode(const MeshCache::Vertex* vertices, size_t count, const Bounds& bounds, PackedVertex* dst) {
+        for (size_t i = 0; i < count; ++i) {
+            dst[i] = Encode(vertices[i], bounds);
+        }
+    }
+
+    ErrorStats MeasureError(const MeshCache::Vertex* vertices, size_t count, const Bounds& bounds, const PackedVertex* packed) {
+        ErrorStats error;
+        for (size_t i = 0; i < count; ++i) {
+            const MeshCache::Vertex& v = vertices[i];
+            MeshCache::Vertex decoded = Decode(packed[i], bounds);
+
+            float position = XMVectorGetX(XMVector3Length(XMLoadFloat3(&v.Pos) - XMLoadFloat3(&decoded.Pos)));
+            float texC = std::max(fabsf(v.TexC.x - decoded.TexC.x), fabsf(v.TexC.y - decoded.TexC.y));
+
+            error.Position = std::max(error.Position, position);
+            error.Normal = std::max(error.Normal, AngleDegrees(v.Normal, decoded.Normal));
+            error.Tangent = std::max(error.Tangent, AngleDegrees(v.TangentU, decoded.TangentU));
+            error.TexC = std::max(error.TexC, texC);
+        }
+        return error;
+    }
+
+    ErrorStats Max(const ErrorStats& lhs, const ErrorStats& rhs) {
+        ErrorStats error;
+        error.Position = std::max(lhs.Position, rhs.Position);
+        error.Normal = std::max(lhs.Normal, rhs.Normal);
+        error.Tangent = std::max(lhs.Tangent, rhs.Tangent);
+        error.TexC = std::max(lhs.TexC, rhs.TexC);
+        return error;
+    }
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+
+#include "MeshCache.h"
+
+// Compact encodings of the vertex of the samples that use tangents
+// (MeshCache::Vertex, 44 bytes):
+//
+//   PackedVertex (20 bytes): snorm16x4 position relative to the bounds of its
+//   submesh, octahedral snorm16x2 normal and tangent, half2 texture coordinates.
+//
+// Passes that only write depth read the same encodings from streams of their
+// own (see VertexStreams).
+//
+// Every format decodes in the input assembler to what a shader can use after
+// a multiply-add (positions) or a few ALU instructions (directions), so the
+// formats are DXGI formats: R16G16B16A16_SNORM, R16G16_SNORM, R16G16_FLOAT.
+namespace VertexQuantize {
+    struct PackedVertex {
+        // x, y, z in [-1, 1] over Center -/+ Extents of the bounds; w is 0.
+        int16_t Position[4];
+        int16_t Normal[2];
+        int16_t Tangent[2];
+        uint16_t TexC[2];
+    };
+
+    // What positions are quantized against; a zero extent (a flat mesh) is
+    // fine and decodes to the center.
+    struct Bounds {
+        DirectX::XMFLOAT3 Center = { 0.0f, 0.0f, 0.0f };
+        DirectX::XMFLOAT3 Extents = { 0.0f, 0.0f, 0.0f };
+    };
+
+    // Round to nearest over [-32767, 32767], which is how D3D converts snorm
+    // both ways, so -1, 0 and 1 are exact.
+    int16_t EncodeSnorm16(float v);
+    float DecodeSnorm16(int16_t v);
+
+    // Unit vector onto the octahedron, unfolded onto [-1, 1]^2. A zero vector
+    // decodes to +z.
+    void EncodeOctahedral(const DirectX::XMFLOAT3& v, int16_t encoded[2]);
+    DirectX::XMFLOAT3 DecodeOctahedral(const int16_t encoded[2]);
+
+    PackedVertex Encode(const MeshCache::Vertex& vertex, const Bounds& bounds);
+    MeshCache::Vertex Decode(const PackedVertex& vertex, const Bounds& bounds);
+
+    void Encode(const MeshCache::Vertex* vertices, size_t count, const Bounds& bounds, PackedVertex* dst);
+
+    // Largest differences between vertices and their packed form decoded.
+    struct ErrorStats {
+        // In the units of the positions.
+        float Position = 0.0f;
+        // In degrees.
+        float Normal = 0.0f;
+        float Tangent = 0.0f;
+        // In texture coordinates.
+        float TexC = 0.0f;
+    };
+
+    ErrorStats MeasureError(const MeshCache::Vertex* vertices, size_t count, const Bounds& bounds, const PackedVertex* packed);
+
+    // The larger of each error.
+    ErrorStats Max(const ErrorStats& lhs, const ErrorStats& rhs);
+};
@@ -0,0 +1,116 @@
+#include "VertexStreams.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "MeshCache.h"
+#include "VertexQuantize.h"
+
+namespace VertexStreams {
+    namespace {
+        const char* const gSemanticNames[AttributeCount] = { "POSITION", "NORMAL", "TEXCOORD" };
+
+        const DXGI_FORMAT gPackedFormats[AttributeCount] = {
+            DXGI_FORMAT_R16G16B16A16_SNORM, DXGI_FORMAT_R16G16_SNORM, DXGI_FORMAT_R16G16_FLOAT
+        };
+
+        const DXGI_FORMAT gFormats[AttributeCount] = {
+            DXGI_FORMAT_R32G32B32_FLOAT, DXGI_FORMAT_R32G32B32_FLOAT, DXGI_FORMAT_R32G32_FLOAT
+        };
+
+        uint64_t StreamSize(uint32_t vertexCount, uint32_t stride, uint32_t elementSize) {
+            return vertexCount > 0 ? uint64_t(vertexCount - 1) * stride + elementSize : 0;
+        }
+    }
+
+    Layout Split(uint32_t vertexCount, bool packed) {
+        const DXGI_FORMAT* formats = packed ? gPackedFormats : gFormats;
+
+        Layout layout;
+        uint64_t offset = 0;
+        for (uint32_t a = 0; a < AttributeCount; ++a) {
+            Stream& stream = layout.Streams[a];
+            stream.Format = formats[a];
+            stream.Stride = FormatSize(formats[a]);
+            stream.Offset = offset;
+            stream.Size = StreamSize(vertexCount, stream.Stride, stream.Stride);
+            offset = (offset + stream.Size + StreamAlignment - 1) & ~(StreamAlignment - 1);
+        }
+        return layout;
+    }
+
+    Layout Interleaved(uint32_t vertexCount, bool packed) {
+        const DXGI_FORMAT* formats = packed ? gPackedFormats : gFormats;
+        const uint32_t stride = packed ? sizeof(VertexQuantize::PackedVertex) : sizeof(MeshCache::Vertex);
+        const uint64_t offsets[AttributeCount] = {
+            packed ? offsetof(VertexQuantize::PackedVertex, Position) : offsetof(MeshCache::Vertex, Pos),
+            packed ? offsetof(VertexQuantize::PackedVertex, Normal) : offsetof(MeshCache::Vertex, Normal),
+            packed ? offsetof(VertexQuantize::PackedVertex, TexC) : offsetof(MeshCache::Vertex, TexC)
+        };
+
+        Layout layout;
+        for (uint32_t a = 0; a < AttributeCount; ++a) {
+            Stream& stream = layout.Streams[a];
+            stream.Format = formats[a];
+            stream.Stride = stride;
+            stream.Offset = offsets[a];
+            stream.Size = StreamSize(vertexCount, stride, FormatSize(formats[a]));
+        }
+        return layout;
+    }
+
+    uint64_t BufferSize(const Layout& layout) {
+        uint64_t size = 0;
+        for (const Stream& stream : layout.Streams) {
+            size = std::max(size, stream.Offset + stream.Size);
+        }
+        return size;
+    }
+
+    uint32_t FormatSize(DXGI_FORMAT format) {
+        switch (format) {
+        case DXGI_FORMAT_R16G16_SNORM:
+        case DXGI_FORMAT_R16G16_FLOAT:
+            return 4;
+        case DXGI_FORMAT_R16G16B16A16_SNORM:
+        case DXGI_FORMAT_R32G32_FLOAT:
+            return 8;
+        case DXGI_FORMAT_R32G32B32_FLOAT:
+            return 12;
+        default:
+            return 0;
+        }
+    }
+
+    bool Copy(const void* src, const Layout& srcLayout, uint32_t count, const Layout& dstLayout, void* dst) {
+        for (uint32_t a = 0; a < AttributeCount; ++a) {
+            if (srcLayout.Streams[a].Format != dstLayout.Streams[a].Format) {
+                return false;
+            }
+        }
+
+        for (uint32_t a = 0; a < AttributeCount; ++a) {
+            const Stream& from = srcLayout.Streams[a];
+            const Stream& to = dstLayout.Streams[a];
+            const uint32_t size = FormatSize(from.Format);
+            const uint8_t* in = static_cast<const uint8_t*>(src) + from.Offset;
+            uint8_t* out = static_cast<uint8_t*>(dst) + to.Offset;
+            for (uint32_t i = 0; i < count; ++i) {
+                memcpy(out + uint64_t(i) * to.Stride, in + uint64_t(i) * from.Stride, size);
+            }
+        }
+        return true;
+    }
+
+    std::vector<InputElement> InputLayout(bool packed, uint32_t attributeMask) {
+        const DXGI_FORMAT* formats = packed ? gPackedFormats : gFormats;
+
+        std::vector<InputElement> elements;
+        for (uint32_t a = 0; a < AttributeCount; ++a) {
+            if (attributeMask & (1u << a)) {
+                elements.push_back({ gSemanticNames[a], formats[a], a });
+            }
+        }
+        return elements;
+    }
+};
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <dxgiformat.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Vertex attributes as separate streams, so that a pass binds only the ones
+// its vertex shader reads: the shadow map pass reads positions (and texture
+// coordinates when alpha tested), the normals and depth pass positions and
+// normals. Tangents have no stream; only the main pass reads them, from the
+// interleaved buffer.
+//
+// A Layout says where each attribute is in a buffer. Split lays the streams
+// out one after the other, each tightly packed; Interleaved describes the
+// same attributes in place in an interleaved buffer of MeshCache::Vertex or
+// VertexQuantize::PackedVertex, so the draw code binds either the same way.
+namespace VertexStreams {
+    enum Attribute : uint32_t {
+        Position,
+        Normal,
+        TexC,
+        AttributeCount
+    };
+
+    // Sets of attributes, for InputLayout.
+    const uint32_t PositionBit = 1u << Position;
+    const uint32_t NormalBit = 1u << Normal;
+    const uint32_t TexCBit = 1u << TexC;
+
+    // Of every stream of a Split layout.
+    const uint64_t StreamAlignment = 16;
+
+    struct Stream {
+        DXGI_FORMAT Format = DXGI_FORMAT_UNKNOWN;
+        // Bytes from one vertex to the next.
+        uint32_t Stride = 0;
+        // Of the first vertex from the start of the buffer.
+        uint64_t Offset = 0;
+        // Bytes from Offset to the end of the last vertex, which is what a
+        // vertex buffer view of the stream spans.
+        uint64_t Size = 0;
+    };
+
+    struct Layout {
+        Stream Streams[AttributeCount];
+    };
+
+    // Packed: snorm16x4 positions, octahedral snorm16x2 normals and half2
+    // texture coordinates (see VertexQuantize). Otherwise float3, float3 and
+    // float2.
+    Layout Split(uint32_t vertexCount, bool packed);
+    Layout Interleaved(uint32_t vertexCount, bool packed);
+
+    // Bytes of the buffer that a layout's streams span.
+    uint64_t BufferSize(const Layout& layout);
+
+    // Bytes of an element of one of the formats above; 0 for any other.
+    uint32_t FormatSize(DXGI_FORMAT format);
+
+    // Copies every attribute of count vertices between two layouts with the
+    // same formats, e.g. from an interleaved buffer into BufferSize(dstLayout)
+    // bytes of split streams. False, with nothing copied, if the formats
+    // differ.
+    bool Copy(const void* src, const Layout& srcLayout, uint32_t count, const Layout& dstLayout, void* dst);
+
+    // An element of an input layout, minus what is the same for all of them:
+    // semantic index 0, offset 0 in its slot, per-vertex data.
+    struct InputElement {
+        const char* SemanticName;
+        DXGI_FORMAT Format;
+        uint32_t InputSlot;
+    };
+
+    // The attributes in attributeMask, each from the slot numbered as its
+    // Attribute, so one set of bound streams serves every pass.
+    std::vector<InputElement> InputLayout(bool packed, uint32_t attributeMask);
+};
@@ -23,6 +23,8 @@
 #include <cassert>
 #include "d3dx12.h"
 #include "Math.h"
+#include "Meshlets.h"
+#include "VertexStreams.h"
 
 // const variables have internal linkage by default; change it to external.
 // Application source code that includes this header will set its value.
@@ -85,6 +87,15 @@ public:
   );
 };
 
+// A simplified index range of a submesh, drawn with its BaseVertexLocation.
+struct SubmeshLod {
+  UINT IndexCount = 0;
+  UINT StartIndexLocation = 0;
+  // Largest distance of the simplified surface from the full one, in the
+  // units of the vertices.
+  float Error = 0.0f;
+};
+
 // A component mesh of a MeshGeometry. The vertices and indices of a SubmeshGeometry
 // are contained in the same buffers as other components of a MeshGeometry. The
 // vertices and indices of a given SubmeshGeometry are stored contiguously in the buffers.
@@ -92,9 +103,18 @@ struct SubmeshGeometry {
   UINT IndexCount = 0;
   UINT StartIndexLocation = 0;
   INT BaseVertexLocation = 0;
+  // From BaseVertexLocation; 0 if unknown.
+  UINT VertexCount = 0;
   DirectX::BoundingBox Bounds;
   int TextureIndex;
   int MaterialIndex;
+  // Range of MeshGeometry::Meshlets.Meshlets; meshlet vertices are relative
+  // to BaseVertexLocation.
+  UINT MeshletOffset = 0;
+  UINT MeshletCount = 0;
+  // Coarser ranges of the same vertices, finest first; empty if the submesh
+  // has no levels of detail.
+  std::vector<SubmeshLod> Lods;
 };
 
 // Groups a vertex and index buffer together. May be made of component SubmeshGeometry's.
@@ -123,10 +143,22 @@ struct MeshGeometry {
   Microsoft::WRL::ComPtr<ID3D12Resource> VertexBufferUploader = nullptr;
   Microsoft::WRL::ComPtr<ID3D12Resource> IndexBufferUploader = nullptr;
 
+  // The positions, normals and texture coordinates of the vertices, each in a
+  // stream of its own, for passes that don't read every attribute. Where they
+  // are in StreamBufferGPU or, if there is none, in VertexBufferGPU.
+  Microsoft::WRL::ComPtr<ID3D12Resource> StreamBufferGPU = nullptr;
+  Microsoft::WRL::ComPtr<ID3D12Resource> StreamBufferUploader = nullptr;
+  VertexStreams::Layout StreamLayout;
+
   // Component SubmeshGeometry's. The vertices and indices of component 
   // SubmeshGeometry's coexist in the same vertex and index buffers.
   std::unordered_map<std::string, SubmeshGeometry> DrawArgs;
 
+  // Clusters of the submeshes' triangles, with bounds for culling them one by
+  // one instead of a submesh at a time. Empty unless the geometry came with
+  // them (a ScenePack).
+  Meshlets::MeshletData Meshlets;
+
   // Vertex buffer resource descriptor.
   D3D12_VERTEX_BUFFER_VIEW VertexBufferView() const {
     D3D12_VERTEX_BUFFER_VIEW vbv;
@@ -136,6 +168,18 @@ struct MeshGeometry {
     return vbv;
   }
 
+  // Vertex buffer resource descriptors of the streams, one per
+  // VertexStreams::Attribute, for input slots 0 on.
+  void StreamBufferViews(D3D12_VERTEX_BUFFER_VIEW views[VertexStreams::AttributeCount]) const {
+    ID3D12Resource* buffer = StreamBufferGPU ? StreamBufferGPU.Get() : VertexBufferGPU.Get();
+    for (UINT i = 0; i < VertexStreams::AttributeCount; ++i) {
+      const VertexStreams::Stream& stream = StreamLayout.Streams[i];
+      views[i].BufferLocation = buffer->GetGPUVirtualAddress() + stream.Offset;
+      views[i].StrideInBytes = stream.Stride;
+      views[i].SizeInBytes = (UINT)stream.Size;
+    }
+  }
+
   // Index buffer resource descriptor.
   D3D12_INDEX_BUFFER_VIEW IndexBufferView() const {
     D3D12_INDEX_BUFFER_VIEW ibv;
@@ -148,6 +192,7 @@ struct MeshGeometry {
   void DisposeUploaders() {
     VertexBufferUploader = nullptr;
     IndexBufferUploader = nullptr;
+    StreamBufferUploader = nullptr;
   }
 };
 
@@ -186,6 +231,13 @@ struct Material {
   // [0,1], where 0 is perfectly smooth and 1 is the roughest possible.
   float Roughness = 0.25f;
 
+  // Light emitted by the surface, added to the lit color.
+  DirectX::XMFLOAT3 Emissive = { 0.0f, 0.0f, 0.0f };
+
+  // Pixels whose diffuse alpha is below this are discarded by alpha-tested
+  // pipelines.
+  float AlphaCutoff = 0.5f;
+
   // This Material will be part of a FrameResource in a constant buffer. If the application
   // modifies it, it has to be updated on the constant buffer of all the frame resources.
   int NumFramesDirty = gNumFrameResources;
@@ -19,7 +19,9 @@ struct MaterialData {
 	float4x4 MatTransform;
 	uint DiffuseMapIndex;
 	uint NormalMapIndex;
+	float AlphaCutoff;
 	uint MatPad1;
+	float3 Emissive;
 	uint MatPad2;
 };
 
@@ -47,6 +49,10 @@ cbuffer cbPerObject : register(b0) {
 	uint gObjPad0;
 	uint gObjPad1;
 	uint gObjPad2;
+	float3 gPositionCenter;
+	uint gObjPad3;
+	float3 gPositionExtents;
+	uint gObjPad4;
 };
 
 cbuffer cbPass : register(b1) {
@@ -70,12 +76,43 @@ cbuffer cbPass : register(b1) {
 	Light gLights[MaxLights];
 };
 
+// With PACKED_VERTICES, vertices are VertexQuantize::PackedVertex: positions
+// are snorm16 over the bounds in cbPerObject, normals and tangents octahedral
+// snorm16, and texture coordinates half. The input assembler converts each to
+// float; these finish decoding.
+#ifdef PACKED_VERTICES
+typedef float2 VertexDirection;
+#else
+typedef float3 VertexDirection;
+#endif
+
+float3 DecodePosition(float3 posL) {
+#ifdef PACKED_VERTICES
+	return gPositionCenter + posL * gPositionExtents;
+#else
+	return posL;
+#endif
+}
+
+float3 DecodeDirection(float3 v) {
+	return v;
+}
+
+// Unfolds the octahedron (see VertexQuantize::DecodeOctahedral).
+float3 DecodeDirection(float2 e) {
+	float3 v = float3(e, 1.0f - abs(e.x) - abs(e.y));
+	float t = saturate(-v.z);
+	v.xy += v.xy >= 0.0f ? -t : t;
+	return normalize(v);
+}
+
 float3 NormalSampleToWorldSpace(float3 normalMapSample, float3 unitNormalW, float3 tangentW) {
 	float3 normalT = 2.0f * normalMapSample - 1.0f;
 
-	// Orthonormal basis using Gram-Schmidt.
+	// The tangents are orthonormalized against the normals on import
+	// (MeshImport::GenerateTangents), so no Gram-Schmidt step here.
 	float3 N = unitNormalW;
-	float3 T = normalize(tangentW - dot(tangentW, N)*N);
+	float3 T = normalize(tangentW);
 	// Unit binormal vector.
 	float3 B = cross(N, T);
 
@@ -18,7 +18,9 @@ struct MaterialData{
 	DirectX::XMFLOAT4X4 MatTransform = Math::Identity4x4();
 	UINT DiffuseMapIndex = 0;
 	UINT NormalMapIndex = 0;
+	float AlphaCutoff = 0.5f;
 	UINT MaterialPad1;
+	DirectX::XMFLOAT3 Emissive = { 0.0f, 0.0f, 0.0f };
 	UINT MaterialPad2;
 };
 
@@ -50,6 +52,12 @@ struct ObjectConstants {
 	UINT ObjPad0;
 	UINT ObjPad1;
 	UINT ObjPad2;
+  // Bounds that packed positions are relative to (see gPackedVertices in
+  // ShadowMappingApp.cpp).
+  DirectX::XMFLOAT3 PositionCenter = { 0.0f, 0.0f, 0.0f };
+  UINT ObjPad3;
+  DirectX::XMFLOAT3 PositionExtents = { 0.0f, 0.0f, 0.0f };
+  UINT ObjPad4;
 };
 
 struct SSAOConstants {
@@ -1,30 +1,34 @@
 #include "Common.hlsl"
 
+// Reads the position and normal streams of the geometry, and its texture
+// coordinate stream when alpha tested (see VertexStreams).
 struct VertexIn {
     float3 PosL     : POSITION;
-    float3 NormalL  : NORMAL;
+    VertexDirection NormalL  : NORMAL;
+#ifdef ALPHA_TEST
     float2 TexC     : TEXCOORD;
-    float3 TangentU : TANGENT;
+#endif
 };
 
 struct VertexOut {
     float4 PosH     : SV_POSITION;
     float3 NormalW  : NORMAL;
-    float3 TangentW : TANGENT;
+#ifdef ALPHA_TEST
     float2 TexC     : TEXCOORD;
+#endif
 };
 
 VertexOut VS(VertexIn vin) {
     VertexOut vout = (VertexOut) 0.0f;
 
+    // gWorld is a 4x4 homogeneous matrix. Normals are 3x1 and don't need
+    // translation.
+    vout.NormalW = mul(DecodeDirection(vin.NormalL), (float3x3) gWorld);
+    vout.PosH = mul(mul(float4(DecodePosition(vin.PosL), 1.0f), gWorld), gViewProj);
+#ifdef ALPHA_TEST
     MaterialData material = gMaterialData[gMaterialIndex];
-
-    // gWorld is a 4x4 homogeneous matrix. Normals and tangents are
-    // 3x1 and don't need translation.
-    vout.NormalW = mul(vin.NormalL, (float3x3) gWorld);
-    vout.TangentW = mul(vin.TangentU, (float3x3) gWorld);
-    vout.PosH = mul(mul(float4(vin.PosL, 1.0f), gWorld), gViewProj);
     vout.TexC = mul(mul(float4(vin.TexC, 0.0f, 1.0f), gTexTransform), material.MatTransform).xy;
+#endif
 
     return vout;
 }
@@ -32,6 +36,11 @@ VertexOut VS(VertexIn vin) {
 float4 PS(VertexOut pin) : SV_Target {
     MaterialData material = gMaterialData[gMaterialIndex];
 
+#ifdef ALPHA_TEST
+    float4 diffuseAlbedo = material.DiffuseAlbedo * gTextureMaps[material.DiffuseMapIndex].Sample(gsamAnisotropicWrap, pin.TexC);
+    clip(diffuseAlbedo.a - material.AlphaCutoff);
+#endif
+
     // Normal in view space.
     return float4(mul(normalize(pin.NormalW), (float3x3) gView), 0.0f);
 }
\ No newline at end of file
@@ -12,7 +12,7 @@ struct VertexOut {
 
 VertexOut VS(VertexIn vin) {
 	VertexOut vout = (VertexOut)0.0f;
-    vout.PosH = float4(vin.PosL, 1.0f);	
+    vout.PosH = float4(DecodePosition(vin.PosL), 1.0f);	
 	vout.TexC = vin.TexC;
 
     return vout;
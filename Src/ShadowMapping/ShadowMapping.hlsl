@@ -15,9 +15,9 @@
 struct VertexIn {
     // Local coordinates.
     float3 PosL : POSITION;
-    float3 NormalL : NORMAL;
+    VertexDirection NormalL : NORMAL;
     float2 TexC : TEXCOORD;
-    float3 TangentU : TANGENT;
+    VertexDirection TangentU : TANGENT;
 };
 
 struct VertexOut {
@@ -34,10 +34,10 @@ VertexOut VS(VertexIn vin) {
     VertexOut vout = (VertexOut) 0.0f;
     MaterialData matData = gMaterialData[gMaterialIndex];
 
-    float4 posW = mul(float4(vin.PosL, 1.0f), gWorld);
+    float4 posW = mul(float4(DecodePosition(vin.PosL), 1.0f), gWorld);
     vout.PosW = posW.xyz;
-    vout.NormalW = mul(vin.NormalL, (float3x3) gWorld);
-    vout.TangentW = mul(vin.TangentU, (float3x3) gWorld);
+    vout.NormalW = mul(DecodeDirection(vin.NormalL), (float3x3) gWorld);
+    vout.TangentW = mul(DecodeDirection(vin.TangentU), (float3x3) gWorld);
     vout.PosH = mul(posW, gViewProj);
 
     float4 texC = mul(float4(vin.TexC, 0.0f, 1.0f), gTexTransform);
@@ -61,7 +61,7 @@ float4 PS(VertexOut pin) : SV_TARGET {
     diffuseAlbedo *= gTextureMaps[diffuseMapIndex].Sample(gsamAnisotropicWrap, pin.TexC);
 
 #ifdef ALPHA_TEST
-    clip(diffuseAlbedo.a - 0.1f);
+    clip(diffuseAlbedo.a - matData.AlphaCutoff);
 #endif
 
     pin.NormalW = normalize(pin.NormalW);
@@ -90,6 +90,7 @@ float4 PS(VertexOut pin) : SV_TARGET {
     float4 reflectionColor = gCubeMap.Sample(gsamLinearWrap, r);
     float3 fresnelFactor = SchlickFresnel(fresnelR0, bumpedNormalW, r);
     litColor.rgb += shininess * fresnelFactor * reflectionColor.rgb;
+    litColor.rgb += matData.Emissive;
     litColor.a = diffuseAlbedo.a;
 
     return litColor;
@@ -1,10 +1,16 @@
 #include "../Common/d3dApp.h"
+#include "../Common/AssetLoader.h"
 #include "../Common/Math.h"
 #include "../Common/UploadBuffer.h"
 #include "../Common/GeometryGenerator.h"
 #include "../Common/DDSTextureLoader.h"
 #include "../Common/Camera.h"
 #include "../Common/GLTFLoader.h"
+#include "../Common/MeshCache.h"
+#include "../Common/MeshImport.h"
+#include "../Common/ScenePack.h"
+#include "../Common/VertexQuantize.h"
+#include "../Common/VertexStreams.h"
 #include "FrameResource.h"
 #include "ShadowMap.h"
 #include "SSAOMap.h"
@@ -20,6 +26,24 @@ using namespace DirectX::PackedVector;
 
 const int gNumFrameResources = 3;
 
+// Size of gTextureMaps in Common.hlsl.
+const int gNumTextureMaps = 100;
+
+// Streamed glTF textures uploaded per frame.
+const size_t gMaxTextureUploadsPerFrame = 8;
+
+// Vertex buffers hold VertexQuantize::PackedVertex (20 bytes) instead of
+// Vertex (44 bytes), with positions relative to the bounds of their submesh,
+// and the vertex shaders are compiled with PACKED_VERTICES to decode them.
+// The CPU copies of the vertices, which picking reads, stay unpacked.
+const bool gPackedVertices = true;
+
+// Geometries also carry their positions, normals and texture coordinates in
+// separate streams, so the shadow map and normals and depth passes fetch only
+// what their vertex shaders read. Otherwise those passes read the same
+// attributes out of the interleaved vertex buffer.
+const bool gSplitVertexStreams = true;
+
 struct RenderItem {
   RenderItem() = default;
   RenderItem(const RenderItem &) = delete;
@@ -42,10 +66,23 @@ struct RenderItem {
   bool Visible = true;
 
   BoundingBox BBox;
+
+  // Of the submesh, which Geo's packed positions are relative to (see
+  // gPackedVertices).
+  BoundingBox PositionBounds;
+
+  // Ranges to draw from, the first being the full submesh, and which one
+  // IndexCount and StartIndexLocation currently are (see SelectLods).
+  std::vector<SubmeshLod> Lods;
+  UINT Lod = 0;
 };
 
 enum class RenderLayer : int {
 	Opaque = 0,
+  // Drawn without back-face culling, discarding pixels below the material's
+  // alpha cutoff. Only glTF materials with alphaMode MASK (or BLEND) go here,
+  // so that the rest of the scene doesn't pay for clip().
+  AlphaTested,
   Debug,
 	Sky,
   Picking,
@@ -63,9 +100,13 @@ public:
 
 private:
   void InitializeGUI();
-  void LoadModelFromGLTF();
+  bool LoadModelFromGLTF();
   void LoadTextures();
   void LoadTexturesFromGLTF();
+  void OnGLTFTextureRead(int slot, AssetLoader::TextureData& data);
+  void BindUploadedGLTFTextures();
+  void CullGLTFMeshlets();
+  void SelectLods();
   void LoadMaterialsFromFromGLTF();
   void BuildRootSignature();
   void BuildSSAORootSignature();
@@ -75,13 +116,16 @@ private:
   void BuildShapeGeometry();
   void BuildMainModelGeometry();
   void BuildGeometryFromGLTF();
+  void UploadVertices(MeshGeometry* geo, const Vertex* vertices, UINT vertexCount);
+  // Builds geo->StreamLayout over the vertices just uploaded, packed or not.
+  void UploadVertexStreams(MeshGeometry* geo, const void* vertices, UINT vertexCount);
   void BuildPSOs();
   void BuildFrameResources();
   void BuildMaterials();
   void BuildRenderItems();
 
   virtual void Draw(const GameTimer& gt) override;
-  void DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& ritems);
+  void DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& ritems, bool vertexStreams = false);
   void DrawSceneToShadowMap();
   void DrawNormalsAndDepth();
 
@@ -109,12 +153,42 @@ private:
   CD3DX12_CPU_DESCRIPTOR_HANDLE GetRtv(int index) const;
 
 private:
-  std::unique_ptr<GLTFLoader> mGLTFLoader;
+  // Sponza, compiled from its glTF file into a scene pack.
+  ScenePack::File mScenePack;
 
+  // The pack's unique images that some material samples, in the order of
+  // mUnnamedTextures and of their SRVs at mGLTFTexSrvIndex.
   std::vector<GLTFTextureData> mGLTFTextures;
+  // Index into mGLTFTextures of each pack texture, -1 if it isn't resident.
+  std::vector<int> mGLTFTextureSlots;
+
+  // A glTF texture whose upload was recorded in the frame that signals Fence.
+  // Until that fence passes, materials keep sampling their placeholder.
+  struct PendingGLTFTexture {
+    int Slot;
+    UINT64 Fence;
+  };
+  std::vector<PendingGLTFTexture> mPendingGLTFTextures;
+  UINT mBoundGLTFTextureCount = 0;
+
+  // The car; converted or mapped on the asset loader during Initialize.
+  MeshCache::File mMainModelMesh;
+
+  // Declared after what its jobs write to, so that it's destroyed (and its
+  // workers joined) first.
+  AssetLoader mAssetLoader;
 
   std::vector<GLTFMaterialData> mGLTFMaterials;
 
+  // Sponza's meshlets that survive CPU frustum and back-face culling this
+  // frame, as indices into the geometry's meshlet table. Only reported for
+  // now; the submeshes are still drawn whole.
+  std::vector<uint32_t> mVisibleMeshlets;
+
+  // Largest on-screen error, in pixels, that a render item's level of detail
+  // may have at its nearest point to the camera.
+  float mLodPixelError = 1.0f;
+
   // Contains every vertex of the scene.
   DirectX::BoundingSphere mSceneBounds;
 
@@ -155,9 +229,13 @@ private:
   std::unordered_map<std::string, ComPtr<ID3DBlob>> mShaders;
 
   std::vector<D3D12_INPUT_ELEMENT_DESC> mInputLayout;
+  // Of the passes that read MeshGeometry::StreamLayout.
+  std::vector<D3D12_INPUT_ELEMENT_DESC> mShadowInputLayout;
+  std::vector<D3D12_INPUT_ELEMENT_DESC> mShadowAlphaTestedInputLayout;
+  std::vector<D3D12_INPUT_ELEMENT_DESC> mNormalsInputLayout;
+  std::vector<D3D12_INPUT_ELEMENT_DESC> mNormalsAlphaTestedInputLayout;
 
   std::unordered_map<std::string, std::unique_ptr<MeshGeometry>> mGeometries;
-  std::vector<std::unique_ptr<MeshGeometry>> mUnnamedGeometries;
 
   std::unordered_map<std::string, std::unique_ptr<Material>> mMaterials;
   std::vector<std::unique_ptr<Material>> mUnnamedMaterials;
@@ -242,18 +320,41 @@ bool ShadowMappingApp::Initialize() {
 
   mPickedRitem = nullptr;
 
-  LoadModelFromGLTF();
+  // The scene pack and the car mesh are opened (or compiled, the first time)
+  // on the asset loader while the textures are read and the shaders compiled
+  // here.
+  std::future<bool> sceneOpened = mAssetLoader.Submit([this]() {
+    return LoadModelFromGLTF();
+  });
+  std::future<bool> mainModelOpened = mAssetLoader.Submit([this]() {
+    return MeshCache::OpenOrConvert("Assets/car.txt", "Assets/car.mesh", mMainModelMesh);
+  });
 
   LoadTextures();
-  LoadTexturesFromGLTF();
-  LoadMaterialsFromFromGLTF();
   BuildRootSignature();
   BuildSSAORootSignature();
-  BuildDescriptorHeaps();
-  InitializeGUI();
   BuildShadersAndInputLayout();
   BuildShapeGeometry();
-  BuildMainModelGeometry();
+
+  if (!sceneOpened.get()) {
+    MessageBox(0, L"Assets/Sponza/Sponza.gltf not found.", 0, 0);
+    return false;
+  }
+
+  // Sponza's textures stream in after the first frame.
+  LoadTexturesFromGLTF();
+  LoadMaterialsFromFromGLTF();
+  BuildDescriptorHeaps();
+  if (mGLTFTexSrvIndex + mUnnamedTextures.size() > gNumTextureMaps) {
+    MessageBox(0, L"Too many glTF textures for gTextureMaps.", 0, 0);
+    return false;
+  }
+  InitializeGUI();
+  if (mainModelOpened.get()) {
+    BuildMainModelGeometry();
+  } else {
+    MessageBox(0, L"Assets/car.txt not found.", 0, 0);
+  }
   BuildGeometryFromGLTF();
   BuildMaterials();
   BuildRenderItems();
@@ -295,9 +396,17 @@ void ShadowMappingApp::InitializeGUI() {
   );
 }
 
-void ShadowMappingApp::LoadModelFromGLTF() {
-  mGLTFLoader = std::make_unique<GLTFLoader>(string("Assets/Sponza/Sponza.gltf"));
-  mGLTFLoader->LoadModel();
+bool ShadowMappingApp::LoadModelFromGLTF() {
+  // Sponza's root node scales it by 0.008; the sample draws it at 0.08. Node
+  // transforms are baked into the vertices and the render items keep an
+  // identity world.
+  MeshImport::Options options;
+  XMStoreFloat4x4(&options.Transform, XMMatrixScaling(10.0f, 10.0f, 10.0f));
+
+  // The pack is compiled from the glTF file on first run, or when the glTF
+  // file changes, and memory-mapped after that: no JSON parsing, no tangent
+  // generation. See Src/Tools/SceneCompiler.cpp to build it offline.
+  return ScenePack::OpenOrCompile("Assets/Sponza/Sponza.gltf", "Assets/Sponza/Sponza.scene", options, mScenePack);
 }
 
 void ShadowMappingApp::LoadTextures() {
@@ -312,25 +421,38 @@ void ShadowMappingApp::LoadTextures() {
     "defaultNormalMap",
     "skyCubeMap"
   };
-  std::vector<std::wstring> texFilenames =
+  std::vector<std::string> texFilenames =
   {
-      L"Assets/bricks2.dds",
-      L"Assets/bricks2_nmap.dds",
-      L"Assets/sponza_floor_a.dds",
-      L"Assets/sponza_floor_a_normal.dds",
-      L"Assets/white1x1.dds",
-      L"Assets/default_nmap.dds",
-      L"Assets/cosmic_sky.dds"
+      "Assets/bricks2.dds",
+      "Assets/bricks2_nmap.dds",
+      "Assets/sponza_floor_a.dds",
+      "Assets/sponza_floor_a_normal.dds",
+      "Assets/white1x1.dds",
+      "Assets/default_nmap.dds",
+      "Assets/cosmic_sky.dds"
   };
 
+  // The files are read on the asset loader, all at once; only the uploads
+  // happen here. These are needed before the first frame: the default maps
+  // are the placeholders of Sponza's textures.
+  std::vector<std::future<AssetLoader::TextureData>> reads;
+  for (const std::string &filename : texFilenames) {
+    reads.push_back(mAssetLoader.Submit([filename]() {
+      return AssetLoader::ReadTexture(filename);
+    }));
+  }
+
   for (int i = 0; i < (int)texNames.size(); ++i) {
+    AssetLoader::TextureData data = reads[i].get();
+
     auto textureMap = std::make_unique<Texture>();
     textureMap->Name = texNames[i];
-    textureMap->Filename = texFilenames[i];
-    ThrowIfFailed(CreateDDSTextureFromFile12(
+    textureMap->Filename = AnsiToWString(texFilenames[i]);
+    ThrowIfFailed(CreateDDSTextureFromMemory12(
       md3dDevice.Get(),
       mCommandList.Get(),
-      textureMap->Filename.c_str(),
+      data.FileData.data(),
+      data.FileData.size(),
       textureMap->Resource,
       textureMap->UploadHeap
     ));
@@ -339,30 +461,234 @@ void ShadowMappingApp::LoadTextures() {
 }
 
 void ShadowMappingApp::LoadTexturesFromGLTF() {
-  mGLTFTextures = mGLTFLoader->LoadTextures();
-  unsigned int textureCount = mGLTFTextures.size();
-  mUnnamedTextures.resize(textureCount);
+  // The pack's texture table is already deduplicated by image. Of those, only
+  // the maps that the shaders sample, base color and normal, are loaded.
+  const ScenePack::Header &header = mScenePack.GetHeader();
+  mGLTFTextureSlots.assign(header.TextureCount, -1);
+  mGLTFTextures.clear();
+  unsigned int slotCount = 0;
+  uint64_t residentBytes = 0;
+  for (unsigned int i = 0; i < header.MaterialCount; ++i) {
+    const ScenePack::Material &material = mScenePack.Materials()[i];
+    for (int texture : { material.BaseColorTexture, material.NormalTexture }) {
+      if (texture == -1) {
+        continue;
+      }
+      ++slotCount;
+      if (mGLTFTextureSlots[texture] == -1) {
+        mGLTFTextureSlots[texture] = (int)mGLTFTextures.size();
+        mGLTFTextures.push_back({ mScenePack.TexturePath(texture) });
+        residentBytes += mScenePack.TextureByteSize(texture);
+      }
+    }
+  }
 
-  for (int i = 0; i < textureCount; ++i) {
-    GLTFTextureData &gltfTexture = mGLTFTextures[i];
+  uint64_t packBytes = 0;
+  for (unsigned int i = 0; i < header.TextureCount; ++i) {
+    packBytes += mScenePack.TextureByteSize(i);
+  }
+  char report[256];
+  snprintf(
+    report, sizeof(report),
+    "glTF textures: %u material slots -> %zu resident of %u unique images, %.1f of %.1f MB\n",
+    slotCount, mGLTFTextures.size(), header.TextureCount, residentBytes / (1024.0 * 1024.0), packBytes / (1024.0 * 1024.0)
+  );
+  ::OutputDebugStringA(report);
 
-    auto texture = make_unique<Texture>();
-    texture->Filename = AnsiToWString(gltfTexture.uri);
+  // Filled in by OnGLTFTextureRead as the reads complete. Their SRV slots are
+  // reserved now.
+  mUnnamedTextures.resize(mGLTFTextures.size());
 
-    ThrowIfFailed(DirectX::CreateDDSTextureFromFile12(
-      md3dDevice.Get(),
-      mCommandList.Get(),
-      texture->Filename.c_str(),
-      texture->Resource,
-      texture->UploadHeap
-    ));
+  for (int i = 0; i < mGLTFTextures.size(); ++i) {
+    mAssetLoader.Submit(
+      [uri = mGLTFTextures[i].uri]() { return AssetLoader::ReadTexture(uri); },
+      [this, i](AssetLoader::TextureData &data) { OnGLTFTextureRead(i, data); }
+    );
+  }
+}
+
+// Runs from Draw, with the frame's command list open.
+void ShadowMappingApp::OnGLTFTextureRead(int slot, AssetLoader::TextureData &data) {
+  if (!data.Loaded) {
+    // The materials that use it keep their placeholder.
+    ::OutputDebugStringA(("Failed to load " + data.Filename + "\n").c_str());
+    return;
+  }
+
+  auto texture = make_unique<Texture>();
+  texture->Filename = AnsiToWString(data.Filename);
+
+  ThrowIfFailed(DirectX::CreateDDSTextureFromMemory12(
+    md3dDevice.Get(),
+    mCommandList.Get(),
+    data.FileData.data(),
+    data.FileData.size(),
+    texture->Resource,
+    texture->UploadHeap
+  ));
+
+  mUnnamedTextures[slot] = std::move(texture);
+  mPendingGLTFTextures.push_back({ slot, mCurrentFence + 1 });
+}
+
+// Points the materials at the glTF textures whose copies have executed. The
+// SRV is written into the texture's own slot, which nothing has referenced
+// yet, so frames in flight are unaffected; the materials switch over through
+// the frame resources' material buffers as usual.
+void ShadowMappingApp::BindUploadedGLTFTextures() {
+  UINT64 completedFence = mFence->GetCompletedValue();
 
-    mUnnamedTextures[i] = std::move(texture);
+  auto srvCpuStart = mSrvDescriptorHeap->GetCPUDescriptorHandleForHeapStart();
+  D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+  srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+  srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+  srvDesc.Texture2D.MostDetailedMip = 0;
+  srvDesc.Texture2D.ResourceMinLODClamp = 0.0f;
+
+  auto pending = mPendingGLTFTextures.begin();
+  while (pending != mPendingGLTFTextures.end()) {
+    if (pending->Fence > completedFence) {
+      ++pending;
+      continue;
+    }
+
+    int slot = pending->Slot;
+    auto &tex = mUnnamedTextures[slot];
+    srvDesc.Format = tex->Resource->GetDesc().Format;
+    srvDesc.Texture2D.MipLevels = tex->Resource->GetDesc().MipLevels;
+    md3dDevice->CreateShaderResourceView(
+      tex->Resource.Get(), &srvDesc,
+      CD3DX12_CPU_DESCRIPTOR_HANDLE(srvCpuStart, mGLTFTexSrvIndex + slot, mCbvSrvUavDescriptorSize)
+    );
+    // The copy is done.
+    tex->UploadHeap = nullptr;
+
+    for (int i = 0; i < mUnnamedMaterials.size(); ++i) {
+      int baseColorMap = mGLTFMaterials[i].baseColorMap;
+      int normalMap = mGLTFMaterials[i].normalMap;
+      Material *material = mUnnamedMaterials[i].get();
+      if (baseColorMap != -1 && mGLTFTextureSlots[baseColorMap] == slot) {
+        material->DiffuseSrvHeapIndex = mGLTFTexSrvIndex + slot;
+        material->NumFramesDirty = gNumFrameResources;
+      }
+      if (normalMap != -1 && mGLTFTextureSlots[normalMap] == slot) {
+        material->NormalSrvHeapIndex = mGLTFTexSrvIndex + slot;
+        material->NumFramesDirty = gNumFrameResources;
+      }
+    }
+
+    ++mBoundGLTFTextureCount;
+    pending = mPendingGLTFTextures.erase(pending);
   }
 }
 
+void ShadowMappingApp::CullGLTFMeshlets() {
+  const MeshGeometry *geo = mGeometries["gltfGeo"].get();
+  if (geo == nullptr || geo->Meshlets.Meshlets.empty()) {
+    return;
+  }
+
+  // The scene pack is in world space (its render items have identity World).
+  BoundingFrustum frustum(mCamera.GetProj());
+  frustum.Transform(frustum, XMMatrixInverse(nullptr, mCamera.GetView()));
+
+  mVisibleMeshlets.clear();
+  UINT visibleTriangles = 0;
+  UINT totalTriangles = 0;
+  for (const auto &[name, submesh] : geo->DrawArgs) {
+    size_t first = mVisibleMeshlets.size();
+    bool cullBackFaces = !mGLTFMaterials[submesh.MaterialIndex].doubleSided;
+    Meshlets::Cull(
+      geo->Meshlets.MeshletBounds.data() + submesh.MeshletOffset, submesh.MeshletCount,
+      frustum, mCamera.GetPosition(), cullBackFaces, mVisibleMeshlets
+    );
+
+    for (size_t i = first; i < mVisibleMeshlets.size(); ++i) {
+      mVisibleMeshlets[i] += submesh.MeshletOffset;
+      visibleTriangles += geo->Meshlets.Meshlets[mVisibleMeshlets[i]].TriangleCount;
+    }
+    totalTriangles += submesh.IndexCount / 3;
+  }
+
+  ImGui::Begin("Meshlets");
+  ImGui::Text("Visible: %zu of %zu meshlets", mVisibleMeshlets.size(), geo->Meshlets.Meshlets.size());
+  ImGui::Text("Triangles: %u of %u", visibleTriangles, totalTriangles);
+  ImGui::End();
+}
+
+void ShadowMappingApp::SelectLods() {
+  // A world-space error of e at distance d covers e * P11 * (height / 2) / d
+  // pixels. The shadow and normal/depth passes draw the same render items, so
+  // they follow the camera's choice.
+  const float pixelsPerUnit = 0.5f * mClientHeight * mCamera.GetProj4x4f()(1, 1);
+  const XMVECTOR eye = mCamera.GetPosition();
+
+  UINT drawnTriangles = 0;
+  UINT fullTriangles = 0;
+  for (auto &ritem : mAllRitems) {
+    if (ritem->Lods.size() < 2) {
+      continue;
+    }
+
+    XMMATRIX world = XMLoadFloat4x4(&ritem->World);
+    BoundingBox bounds;
+    ritem->BBox.Transform(bounds, world);
+
+    // Nearest point of the bounding sphere; errors are in the units of the
+    // mesh, so they grow with the largest scale of the world transform.
+    float distance = XMVectorGetX(XMVector3Length(XMLoadFloat3(&bounds.Center) - eye));
+    distance = std::max(distance - XMVectorGetX(XMVector3Length(XMLoadFloat3(&bounds.Extents))), mCamera.GetNearZ());
+    float scale = std::max({
+      XMVectorGetX(XMVector3Length(world.r[0])),
+      XMVectorGetX(XMVector3Length(world.r[1])),
+      XMVectorGetX(XMVector3Length(world.r[2]))
+    });
+
+    UINT lod = 0;
+    while (lod + 1 < ritem->Lods.size() &&
+           ritem->Lods[lod + 1].Error * scale * pixelsPerUnit / distance <= mLodPixelError) {
+      ++lod;
+    }
+
+    ritem->Lod = lod;
+    ritem->IndexCount = ritem->Lods[lod].IndexCount;
+    ritem->StartIndexLocation = ritem->Lods[lod].StartIndexLocation;
+
+    if (ritem->Visible) {
+      drawnTriangles += ritem->IndexCount / 3;
+      fullTriangles += ritem->Lods[0].IndexCount / 3;
+    }
+  }
+
+  ImGui::Begin("LOD");
+  ImGui::SliderFloat("Max error (px)", &mLodPixelError, 0.25f, 16.0f);
+  ImGui::Text("Triangles: %u of %u", drawnTriangles, fullTriangles);
+  ImGui::End();
+}
+
 void ShadowMappingApp::LoadMaterialsFromFromGLTF() {
-  mGLTFMaterials = mGLTFLoader->LoadMaterials(mGLTFTextures);
+  unsigned int materialCount = mScenePack.GetHeader().MaterialCount;
+  mGLTFMaterials.resize(materialCount);
+  for (unsigned int i = 0; i < materialCount; ++i) {
+    const ScenePack::Material &packMaterial = mScenePack.Materials()[i];
+    GLTFMaterialData &material = mGLTFMaterials[i];
+    material.baseColorMap = packMaterial.BaseColorTexture;
+    material.normalMap = packMaterial.NormalTexture;
+    material.metallicRoughnessMap = packMaterial.MetallicRoughnessTexture;
+    material.occlusionMap = packMaterial.OcclusionTexture;
+    material.emissiveMap = packMaterial.EmissiveTexture;
+    material.baseColorFactor = packMaterial.BaseColorFactor;
+    material.emissiveFactor = packMaterial.EmissiveFactor;
+    material.metallicFactor = packMaterial.MetallicFactor;
+    material.roughnessFactor = packMaterial.RoughnessFactor;
+    material.normalScale = packMaterial.NormalScale;
+    material.occlusionStrength = packMaterial.OcclusionStrength;
+    material.alphaMode =
+      packMaterial.AlphaMode == ScenePack::AlphaMask ? GLTFAlphaMode::Mask :
+      packMaterial.AlphaMode == ScenePack::AlphaBlend ? GLTFAlphaMode::Blend : GLTFAlphaMode::Opaque;
+    material.alphaCutoff = packMaterial.AlphaCutoff;
+    material.doubleSided = packMaterial.DoubleSided != 0;
+  }
 }
 
 void ShadowMappingApp::BuildRootSignature() {
@@ -374,8 +700,8 @@ void ShadowMappingApp::BuildRootSignature() {
   // Texture2D gTextureMaps[100] : register(t2).
   // Sponza glTF file comes with about 70 textures, that's why 100.
   CD3DX12_DESCRIPTOR_RANGE texTable1;
-  // 100 descriptors in range, base shader register 3, register space 0.
-  texTable1.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 100, 3, 0);
+  // gNumTextureMaps descriptors in range, base shader register 3, register space 0.
+  texTable1.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, gNumTextureMaps, 3, 0);
 
 #define NUM_ROOT_PARAMETERS 5
   CD3DX12_ROOT_PARAMETER rootParameters[NUM_ROOT_PARAMETERS];
@@ -589,26 +915,8 @@ void ShadowMappingApp::BuildDescriptorHeaps() {
   srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
   srvDesc.Texture2D.MostDetailedMip = 0;
   srvDesc.Texture2D.ResourceMinLODClamp = 0.0f;
-  // mUnnamedMaterials hasn't been initialized yet.
-  for (int i = 0; i < mGLTFMaterials.size(); ++i) {
-    // hDescriptor is pointing at the start of the block in the SRV heap where
-    // we are going to create this SRV.
-    auto &tex = mUnnamedTextures[mGLTFMaterials[i].baseColorMap];
-    srvDesc.Format = tex->Resource->GetDesc().Format;
-    srvDesc.Texture2D.MipLevels = tex->Resource->GetDesc().MipLevels;
-    md3dDevice->CreateShaderResourceView(tex->Resource.Get(), &srvDesc, hDescriptor);
-    // Advance hDescriptor to point to the block where the next SRV will be created.
-    hDescriptor.Offset(1, mCbvSrvUavDescriptorSize);
-
-    if (mGLTFMaterials[i].normalMap != -1) {
-      auto &nor = mUnnamedTextures[mGLTFMaterials[i].normalMap];
-      srvDesc.Format = nor->Resource->GetDesc().Format;
-      srvDesc.Texture2D.MipLevels = nor->Resource->GetDesc().MipLevels;
-      md3dDevice->CreateShaderResourceView(nor->Resource.Get(), &srvDesc, hDescriptor);
-      // Advance hDescriptor to point to the block where the next SRV will be created.
-      hDescriptor.Offset(1, mCbvSrvUavDescriptorSize);
-    }
-  }
+  // One per resident image, shared by every material slot that samples it,
+  // created by BindUploadedGLTFTextures once the image has been uploaded.
 
   mShadowMap->BuildDescriptors(
     CD3DX12_CPU_DESCRIPTOR_HANDLE(srvCpuStart, mShadowMapHeapIndex, mCbvSrvUavDescriptorSize),
@@ -635,21 +943,38 @@ void ShadowMappingApp::BuildShadersAndInputLayout() {
 		NULL, NULL
 	};
 
-	mShaders["standardVS"] = d3dUtil::CompileShader(L"Src/ShadowMapping/ShadowMapping.hlsl", nullptr, "VS", "vs_5_1");
+  const D3D_SHADER_MACRO packedVertexDefines[] = {
+    "PACKED_VERTICES", "1",
+    NULL, NULL
+  };
+  const D3D_SHADER_MACRO *vertexDefines = gPackedVertices ? packedVertexDefines : nullptr;
+
+  const D3D_SHADER_MACRO alphaTestPackedVertexDefines[] = {
+    "ALPHA_TEST", "1",
+    "PACKED_VERTICES", "1",
+    NULL, NULL
+  };
+  const D3D_SHADER_MACRO *alphaTestVertexDefines = gPackedVertices ? alphaTestPackedVertexDefines : alphaTestDefines;
+
+	mShaders["standardVS"] = d3dUtil::CompileShader(L"Src/ShadowMapping/ShadowMapping.hlsl", vertexDefines, "VS", "vs_5_1");
 	mShaders["opaquePS"] = d3dUtil::CompileShader(L"Src/ShadowMapping/ShadowMapping.hlsl", nullptr, "PS", "ps_5_1");
+	mShaders["alphaTestedPS"] = d3dUtil::CompileShader(L"Src/ShadowMapping/ShadowMapping.hlsl", alphaTestDefines, "PS", "ps_5_1");
 
-  mShaders["shadowVS"] = d3dUtil::CompileShader(L"Src/ShadowMapping/Shadows.hlsl", nullptr, "VS", "vs_5_1");
+  mShaders["shadowVS"] = d3dUtil::CompileShader(L"Src/ShadowMapping/Shadows.hlsl", vertexDefines, "VS", "vs_5_1");
+  mShaders["shadowAlphaTestedVS"] = d3dUtil::CompileShader(L"Src/ShadowMapping/Shadows.hlsl", alphaTestVertexDefines, "VS", "vs_5_1");
   mShaders["shadowOpaquePS"] = d3dUtil::CompileShader(L"Src/ShadowMapping/Shadows.hlsl", nullptr, "PS", "ps_5_1");
   mShaders["shadowAlphaTestedPS"] = d3dUtil::CompileShader(L"Src/ShadowMapping/Shadows.hlsl", alphaTestDefines, "PS", "ps_5_1");
 
-  mShaders["debugVS"] = d3dUtil::CompileShader(L"Src/ShadowMapping/ShadowDebug.hlsl", nullptr, "VS", "vs_5_1");
+  mShaders["debugVS"] = d3dUtil::CompileShader(L"Src/ShadowMapping/ShadowDebug.hlsl", vertexDefines, "VS", "vs_5_1");
   mShaders["debugPS"] = d3dUtil::CompileShader(L"Src/ShadowMapping/ShadowDebug.hlsl", nullptr, "PS", "ps_5_1");
 
-	mShaders["skyVS"] = d3dUtil::CompileShader(L"Src/ShadowMapping/Sky.hlsl", nullptr, "VS", "vs_5_1");
+	mShaders["skyVS"] = d3dUtil::CompileShader(L"Src/ShadowMapping/Sky.hlsl", vertexDefines, "VS", "vs_5_1");
 	mShaders["skyPS"] = d3dUtil::CompileShader(L"Src/ShadowMapping/Sky.hlsl", nullptr, "PS", "ps_5_1");
 
-  mShaders["normalsVS"] = d3dUtil::CompileShader(L"Src/ShadowMapping/Normals.hlsl", nullptr, "VS", "vs_5_1");
+  mShaders["normalsVS"] = d3dUtil::CompileShader(L"Src/ShadowMapping/Normals.hlsl", vertexDefines, "VS", "vs_5_1");
+  mShaders["normalsAlphaTestedVS"] = d3dUtil::CompileShader(L"Src/ShadowMapping/Normals.hlsl", alphaTestVertexDefines, "VS", "vs_5_1");
   mShaders["normalsPS"] = d3dUtil::CompileShader(L"Src/ShadowMapping/Normals.hlsl", nullptr, "PS", "ps_5_1");
+  mShaders["normalsAlphaTestedPS"] = d3dUtil::CompileShader(L"Src/ShadowMapping/Normals.hlsl", alphaTestDefines, "PS", "ps_5_1");
 
   // No input layout. These shaders don't use a vertex buffer.
   mShaders["ssaoVS"] = d3dUtil::CompileShader(L"Src/ShadowMapping/SSAO.hlsl", nullptr, "VS", "vs_5_1");
@@ -658,12 +983,37 @@ void ShadowMappingApp::BuildShadersAndInputLayout() {
   mShaders["ssaoBlurVS"] = d3dUtil::CompileShader(L"Src/ShadowMapping/SSAOBlur.hlsl", nullptr, "VS", "vs_5_1");
   mShaders["ssaoBlurPS"] = d3dUtil::CompileShader(L"Src/ShadowMapping/SSAOBlur.hlsl", nullptr, "PS", "ps_5_1");
 
-  mInputLayout = {
-    { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-    { "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 24, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-		{ "TANGENT", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 32, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+  if (gPackedVertices) {
+    mInputLayout = {
+      { "POSITION", 0, DXGI_FORMAT_R16G16B16A16_SNORM, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+      { "NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, 8, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+      { "TANGENT", 0, DXGI_FORMAT_R16G16_SNORM, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+      { "TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT, 0, 16, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+    };
+  } else {
+    mInputLayout = {
+      { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+      { "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+      { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 24, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+      { "TANGENT", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 32, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+    };
+  }
+
+  auto streamInputLayout = [](uint32_t attributes) {
+    std::vector<D3D12_INPUT_ELEMENT_DESC> layout;
+    for (const VertexStreams::InputElement &element : VertexStreams::InputLayout(gPackedVertices, attributes)) {
+      layout.push_back({
+        element.SemanticName, 0, element.Format, element.InputSlot, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0
+      });
+    }
+    return layout;
   };
+  mShadowInputLayout = streamInputLayout(VertexStreams::PositionBit);
+  mShadowAlphaTestedInputLayout = streamInputLayout(VertexStreams::PositionBit | VertexStreams::TexCBit);
+  mNormalsInputLayout = streamInputLayout(VertexStreams::PositionBit | VertexStreams::NormalBit);
+  mNormalsAlphaTestedInputLayout = streamInputLayout(
+    VertexStreams::PositionBit | VertexStreams::NormalBit | VertexStreams::TexCBit
+  );
 }
 
 void ShadowMappingApp::BuildShapeGeometry() {
@@ -766,6 +1116,18 @@ void ShadowMappingApp::BuildShapeGeometry() {
     vertices[k].TangentU = quad.Vertices[i].TangentU;
   }
 
+  // Bounds of the other shapes too, which packed positions are relative to.
+  boxSubmesh.VertexCount = (UINT)box.Vertices.size();
+  gridSubmesh.VertexCount = (UINT)grid.Vertices.size();
+  sphereSubmesh.VertexCount = (UINT)sphere.Vertices.size();
+  cylinderSubmesh.VertexCount = (UINT)cylinder.Vertices.size();
+  quadSubmesh.VertexCount = (UINT)quad.Vertices.size();
+  for (SubmeshGeometry *submesh : { &boxSubmesh, &gridSubmesh, &cylinderSubmesh, &quadSubmesh }) {
+    BoundingBox::CreateFromPoints(
+      submesh->Bounds, submesh->VertexCount, &vertices[submesh->BaseVertexLocation].Pos, sizeof(Vertex)
+    );
+  }
+
 	std::vector<std::uint16_t> indices;
 	indices.insert(indices.end(), std::begin(box.GetIndices16()), std::end(box.GetIndices16()));
 	indices.insert(indices.end(), std::begin(grid.GetIndices16()), std::end(grid.GetIndices16()));
@@ -773,30 +1135,19 @@ void ShadowMappingApp::BuildShapeGeometry() {
 	indices.insert(indices.end(), std::begin(cylinder.GetIndices16()), std::end(cylinder.GetIndices16()));
   indices.insert(indices.end(), std::begin(quad.GetIndices16()), std::end(quad.GetIndices16()));
 
-  const UINT vbByteSize = (UINT)vertices.size() * sizeof(Vertex);
   const UINT ibByteSize = (UINT)indices.size() * sizeof(std::uint16_t);
 
 	auto geo = std::make_unique<MeshGeometry>();
 	geo->Name = "shapeGeo";
 
-	ThrowIfFailed(D3DCreateBlob(vbByteSize, &geo->VertexBufferCPU));
-	CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
-
 	ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
 	CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
 
-	geo->VertexBufferGPU = d3dUtil::CreateDefaultBuffer(
-    md3dDevice.Get(),
-		mCommandList.Get(), vertices.data(), vbByteSize, geo->VertexBufferUploader
-  );
-
 	geo->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(
     md3dDevice.Get(),
 		mCommandList.Get(), indices.data(), ibByteSize, geo->IndexBufferUploader
   );
 
-	geo->VertexByteStride = sizeof(Vertex);
-	geo->VertexBufferByteSize = vbByteSize;
 	geo->IndexFormat = DXGI_FORMAT_R16_UINT;
 	geo->IndexBufferByteSize = ibByteSize;
 
@@ -806,199 +1157,171 @@ void ShadowMappingApp::BuildShapeGeometry() {
 	geo->DrawArgs["cylinder"] = cylinderSubmesh;
   geo->DrawArgs["quad"] = quadSubmesh;
 
+  UploadVertices(geo.get(), vertices.data(), (UINT)vertices.size());
+
 	mGeometries[geo->Name] = std::move(geo);
 }
 
 void ShadowMappingApp::BuildMainModelGeometry() {
-  std::ifstream fin("Assets/car.txt");
-
-  if (!fin) {
-      MessageBox(0, L"Assets/car.txt not found.", 0, 0);
-      return;
-  }
-
-  UINT vcount = 0;
-  UINT tcount = 0;
-  std::string ignore;
-
-  fin >> ignore >> vcount;
-  fin >> ignore >> tcount;
-  fin >> ignore >> ignore >> ignore >> ignore;
-
-  XMFLOAT3 vMinf3(+Math::Infinity, +Math::Infinity, +Math::Infinity);
-  XMFLOAT3 vMaxf3(-Math::Infinity, -Math::Infinity, -Math::Infinity);
-
-  XMVECTOR vMin = XMLoadFloat3(&vMinf3);
-  XMVECTOR vMax = XMLoadFloat3(&vMaxf3);
-
-  std::vector<Vertex> vertices(vcount);
-  for (UINT i = 0; i < vcount; ++i) {
-    fin >> vertices[i].Pos.x >> vertices[i].Pos.y >> vertices[i].Pos.z;
-    fin >> vertices[i].Normal.x >> vertices[i].Normal.y >> vertices[i].Normal.z;
+  // The binary cache is built from the text mesh on first run, or when the
+  // text mesh changes, and memory-mapped after that. Initialize opens it on
+  // the asset loader.
+  const MeshCache::File &meshFile = mMainModelMesh;
 
-    vertices[i].TexC = { 0.0f, 0.0f };
+  static_assert(sizeof(Vertex) == sizeof(MeshCache::Vertex), "Vertex must match the mesh cache layout");
 
-    XMVECTOR P = XMLoadFloat3(&vertices[i].Pos);
-
-    XMVECTOR N = XMLoadFloat3(&vertices[i].Normal);
-
-    XMVECTOR up = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
-    if(fabsf(XMVectorGetX(XMVector3Dot(N, up))) < 1.0f - 0.001f) {
-        XMVECTOR T = XMVector3Normalize(XMVector3Cross(up, N));
-        XMStoreFloat3(&vertices[i].TangentU, T);
-    } else {
-        up = XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f);
-        XMVECTOR T = XMVector3Normalize(XMVector3Cross(N, up));
-        XMStoreFloat3(&vertices[i].TangentU, T);
-    }
-    
-    vMin = XMVectorMin(vMin, P);
-    vMax = XMVectorMax(vMax, P);
-  }
+  const MeshCache::Header& header = meshFile.GetHeader();
 
   BoundingBox bounds;
-  XMStoreFloat3(&bounds.Center, 0.5f*(vMin + vMax));
-  XMStoreFloat3(&bounds.Extents, 0.5f*(vMax - vMin));
+  bounds.Center = header.BoundsCenter;
+  bounds.Extents = header.BoundsExtents;
 
-  fin >> ignore;
-  fin >> ignore;
-  fin >> ignore;
-
-  std::vector<std::int32_t> indices(3 * tcount);
-  for (UINT i = 0; i < tcount; ++i) {
-      fin >> indices[i * 3 + 0] >> indices[i * 3 + 1] >> indices[i * 3 + 2];
-  }
-
-  fin.close();
-
-  const UINT vbByteSize = (UINT)vertices.size() * sizeof(Vertex);
-
-  const UINT ibByteSize = (UINT)indices.size() * sizeof(std::int32_t);
+  const UINT ibByteSize = (UINT)meshFile.IndexDataSize();
 
   auto geo = std::make_unique<MeshGeometry>();
   geo->Name = "mainModelGeo";
 
-  ThrowIfFailed(D3DCreateBlob(vbByteSize, &geo->VertexBufferCPU));
-  CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
-
   ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
-  CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
-
-  geo->VertexBufferGPU = d3dUtil::CreateDefaultBuffer(
-    md3dDevice.Get(), mCommandList.Get(), vertices.data(), vbByteSize, geo->VertexBufferUploader
-  );
+  CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), meshFile.IndexData(), ibByteSize);
 
   geo->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(
-    md3dDevice.Get(), mCommandList.Get(), indices.data(), ibByteSize, geo->IndexBufferUploader
+    md3dDevice.Get(), mCommandList.Get(), meshFile.IndexData(), ibByteSize, geo->IndexBufferUploader
   );
 
-  geo->VertexByteStride = sizeof(Vertex);
-  geo->VertexBufferByteSize = vbByteSize;
   geo->IndexFormat = DXGI_FORMAT_R32_UINT;
   geo->IndexBufferByteSize = ibByteSize;
 
   SubmeshGeometry submesh;
-  submesh.IndexCount = (UINT)indices.size();
+  submesh.IndexCount = header.IndexCount;
   submesh.StartIndexLocation = 0;
   submesh.BaseVertexLocation = 0;
+  submesh.VertexCount = header.VertexCount;
   submesh.Bounds = bounds;
 
+  for (UINT i = 0; i < header.LodCount; ++i) {
+    const MeshCache::Lod &lod = meshFile.Lods()[i];
+    submesh.Lods.push_back({ lod.IndexCount, lod.StartIndexLocation, lod.Error });
+  }
+
   geo->DrawArgs["mainModel"] = submesh;
 
+  UploadVertices(geo.get(), static_cast<const Vertex *>(meshFile.VertexData()), header.VertexCount);
+
   mGeometries[geo->Name] = std::move(geo);
 }
 
 void ShadowMappingApp::BuildGeometryFromGLTF() {
-    unsigned int primCount = mGLTFLoader->getPrimitiveCount();
-    mUnnamedGeometries.resize(primCount);
-
-    for (int primIdx = 0; primIdx < primCount; ++primIdx) {
-        GLTFPrimitiveData loadedData = mGLTFLoader->LoadPrimitive(0, primIdx);
-
-        std::vector<std::uint16_t> &indices = loadedData.indices;
-        std::vector<Vertex> vertices(loadedData.positions.size());
-
-        XMFLOAT3 f3MinVertex(+Math::Infinity, +Math::Infinity, +Math::Infinity);
-        XMFLOAT3 f3MaxVertex(-Math::Infinity, -Math::Infinity, -Math::Infinity);
-        XMVECTOR minVertex = XMLoadFloat3(&f3MinVertex);
-        XMVECTOR maxVertex = XMLoadFloat3(&f3MaxVertex);
-
-        float scale = 0.08;
-        for (int i = 0; i < loadedData.positions.size(); ++i) {
-            // TODO: overloaded operator XMFLOAT3 * float not recognized.
-            vertices[i].Pos.x = loadedData.positions[i].x * scale;
-            vertices[i].Pos.y = loadedData.positions[i].y * scale;
-            vertices[i].Pos.z = loadedData.positions[i].z * scale;
-            XMVECTOR P = XMLoadFloat3(&vertices[i].Pos);
-            minVertex = XMVectorMin(minVertex, P);
-            maxVertex = XMVectorMax(maxVertex, P);
-
-            vertices[i].Normal.x = loadedData.normals[i].x;
-            vertices[i].Normal.y = loadedData.normals[i].y;
-            vertices[i].Normal.z = loadedData.normals[i].z;
-
-            vertices[i].TexC.x = loadedData.uvs[i].x;
-            vertices[i].TexC.y = loadedData.uvs[i].y;
-
-            XMVECTOR N = XMLoadFloat3(&vertices[i].Normal);
-            XMVECTOR up = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
-            if (fabsf(XMVectorGetX(XMVector3Dot(N, up))) < 1.0f - 0.001f) {
-              XMVECTOR T = XMVector3Normalize(XMVector3Cross(up, N));
-              XMStoreFloat3(&vertices[i].TangentU, T);
-            } else {
-              up = XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f);
-              XMVECTOR T = XMVector3Normalize(XMVector3Cross(N, up));
-              XMStoreFloat3(&vertices[i].TangentU, T);
-            }
+    static_assert(sizeof(Vertex) == sizeof(ScenePack::Vertex), "Vertex must match the scene pack layout");
+
+    // The whole scene is one vertex buffer and one index buffer, uploaded
+    // straight out of the mapped pack; every primitive is a submesh.
+    const ScenePack::Header &header = mScenePack.GetHeader();
+
+    const UINT ibByteSize = (UINT)mScenePack.IndexDataSize();
+
+    auto geo = std::make_unique<MeshGeometry>();
+    geo->Name = "gltfGeo";
+
+    ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
+    CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), mScenePack.IndexData(), ibByteSize);
+
+    geo->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(
+        md3dDevice.Get(),
+        mCommandList.Get(),
+        mScenePack.IndexData(),
+        ibByteSize,
+        geo->IndexBufferUploader
+    );
+
+    geo->IndexFormat = header.IndexStride == sizeof(std::uint16_t) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+    geo->IndexBufferByteSize = ibByteSize;
+
+    for (UINT primIdx = 0; primIdx < header.SubmeshCount; ++primIdx) {
+        const ScenePack::Submesh &packSubmesh = mScenePack.Submeshes()[primIdx];
+
+        SubmeshGeometry submesh;
+        submesh.IndexCount = packSubmesh.IndexCount;
+        submesh.StartIndexLocation = packSubmesh.StartIndexLocation;
+        submesh.BaseVertexLocation = packSubmesh.BaseVertexLocation;
+        submesh.VertexCount = packSubmesh.VertexCount;
+        submesh.TextureIndex = packSubmesh.Texture;
+        submesh.MaterialIndex = packSubmesh.Material;
+        submesh.Bounds.Center = packSubmesh.BoundsCenter;
+        submesh.Bounds.Extents = packSubmesh.BoundsExtents;
+        submesh.MeshletOffset = packSubmesh.MeshletOffset;
+        submesh.MeshletCount = packSubmesh.MeshletCount;
+
+        for (UINT i = packSubmesh.LodOffset; i < packSubmesh.LodOffset + packSubmesh.LodCount; ++i) {
+            const ScenePack::Lod &lod = mScenePack.Lods()[i];
+            submesh.Lods.push_back({ lod.IndexCount, lod.StartIndexLocation, lod.Error });
         }
 
-        const UINT vbByteSize = (UINT)vertices.size() * sizeof(Vertex);
+        geo->DrawArgs[std::to_string(primIdx)] = submesh;
+    }
 
-        const UINT ibByteSize = (UINT)indices.size() * sizeof(std::uint16_t);
+    geo->Meshlets.Meshlets.assign(mScenePack.Meshlets(), mScenePack.Meshlets() + header.MeshletCount);
+    geo->Meshlets.MeshletBounds.assign(mScenePack.MeshletBounds(), mScenePack.MeshletBounds() + header.MeshletCount);
+    geo->Meshlets.Vertices.assign(mScenePack.MeshletVertices(), mScenePack.MeshletVertices() + header.MeshletVertexCount);
+    geo->Meshlets.Triangles.assign(mScenePack.MeshletTriangles(), mScenePack.MeshletTriangles() + header.MeshletTriangleCount);
 
-        auto geo = std::make_unique<MeshGeometry>();
-        geo->Name = std::to_string(primIdx);
+    UploadVertices(geo.get(), static_cast<const Vertex *>(mScenePack.VertexData()), header.VertexCount);
 
-        ThrowIfFailed(D3DCreateBlob(vbByteSize, &geo->VertexBufferCPU));
-        CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
+    mGeometries[geo->Name] = std::move(geo);
+}
 
-        ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
-        CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
+void ShadowMappingApp::UploadVertices(MeshGeometry *geo, const Vertex *vertices, UINT vertexCount) {
+  const UINT vbByteSize = vertexCount * sizeof(Vertex);
 
-        geo->VertexBufferGPU = d3dUtil::CreateDefaultBuffer(
-            md3dDevice.Get(),
-            mCommandList.Get(),
-            vertices.data(),
-            vbByteSize,
-            geo->VertexBufferUploader
-        );
+  ThrowIfFailed(D3DCreateBlob(vbByteSize, &geo->VertexBufferCPU));
+  CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), vertices, vbByteSize);
 
-        geo->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(
-            md3dDevice.Get(),
-            mCommandList.Get(),
-            indices.data(),
-            ibByteSize,
-            geo->IndexBufferUploader
-        );
+  if (!gPackedVertices) {
+    geo->VertexBufferGPU = d3dUtil::CreateDefaultBuffer(
+      md3dDevice.Get(), mCommandList.Get(), vertices, vbByteSize, geo->VertexBufferUploader
+    );
+    geo->VertexByteStride = sizeof(Vertex);
+    geo->VertexBufferByteSize = vbByteSize;
+    UploadVertexStreams(geo, vertices, vertexCount);
+    return;
+  }
 
-        geo->VertexByteStride = sizeof(Vertex);
-        geo->VertexBufferByteSize = vbByteSize;
-        geo->IndexFormat = DXGI_FORMAT_R16_UINT;
-        geo->IndexBufferByteSize = ibByteSize;
+  // Every submesh against its own bounds, which its render items pass to the
+  // shaders.
+  static_assert(sizeof(Vertex) == sizeof(MeshCache::Vertex), "Vertex must match VertexQuantize's input layout");
+  auto source = reinterpret_cast<const MeshCache::Vertex *>(vertices);
+  std::vector<VertexQuantize::PackedVertex> packed(vertexCount);
+  for (const auto &drawArg : geo->DrawArgs) {
+    const SubmeshGeometry &submesh = drawArg.second;
+    VertexQuantize::Bounds bounds;
+    bounds.Center = submesh.Bounds.Center;
+    bounds.Extents = submesh.Bounds.Extents;
+    VertexQuantize::Encode(
+      source + submesh.BaseVertexLocation, submesh.VertexCount, bounds, packed.data() + submesh.BaseVertexLocation
+    );
+  }
 
-        SubmeshGeometry submesh;
-        submesh.IndexCount = (UINT)indices.size();
-        submesh.StartIndexLocation = 0;
-        submesh.BaseVertexLocation = 0;
-        submesh.TextureIndex = loadedData.texture;
-        submesh.MaterialIndex = loadedData.material;
-        XMStoreFloat3(&submesh.Bounds.Center, 0.5f * (minVertex + maxVertex));
-        XMStoreFloat3(&submesh.Bounds.Extents, 0.5f * (maxVertex - minVertex));
+  const UINT packedByteSize = vertexCount * sizeof(VertexQuantize::PackedVertex);
+  geo->VertexBufferGPU = d3dUtil::CreateDefaultBuffer(
+    md3dDevice.Get(), mCommandList.Get(), packed.data(), packedByteSize, geo->VertexBufferUploader
+  );
+  geo->VertexByteStride = sizeof(VertexQuantize::PackedVertex);
+  geo->VertexBufferByteSize = packedByteSize;
+  UploadVertexStreams(geo, packed.data(), vertexCount);
+}
 
-        geo->DrawArgs["mainModel"] = submesh;
+void ShadowMappingApp::UploadVertexStreams(MeshGeometry *geo, const void *vertices, UINT vertexCount) {
+  VertexStreams::Layout interleaved = VertexStreams::Interleaved(vertexCount, gPackedVertices);
+  if (!gSplitVertexStreams) {
+    geo->StreamLayout = interleaved;
+    return;
+  }
 
-        mUnnamedGeometries[primIdx] = std::move(geo);
-    }
+  geo->StreamLayout = VertexStreams::Split(vertexCount, gPackedVertices);
+  std::vector<uint8_t> streams(VertexStreams::BufferSize(geo->StreamLayout));
+  VertexStreams::Copy(vertices, interleaved, vertexCount, geo->StreamLayout, streams.data());
+  geo->StreamBufferGPU = d3dUtil::CreateDefaultBuffer(
+    md3dDevice.Get(), mCommandList.Get(), streams.data(), streams.size(), geo->StreamBufferUploader
+  );
 }
 
 void ShadowMappingApp::BuildMaterials() {
@@ -1054,21 +1377,34 @@ void ShadowMappingApp::BuildMaterials() {
   mMaterials["sky"] = std::move(sky);
 
   int cbIndex = 5;
-  int srvHeapIndex = 8;
   mUnnamedMaterials.resize(mGLTFMaterials.size());
   for (int i = 0; i < mUnnamedMaterials.size(); ++i) {
     auto material = std::make_unique<Material>();
     // TODO.
     material->Name = "unnamed";
     material->MatCBIndex = cbIndex++;
-    material->DiffuseSrvHeapIndex = srvHeapIndex++;
-    if (mGLTFMaterials[i].normalMap != -1) {
-      material->NormalSrvHeapIndex = srvHeapIndex++;
+    // defaultDiffuseMap and defaultNormalMap, until BindUploadedGLTFTextures
+    // replaces them with the material's maps (materials without maps keep
+    // them).
+    material->DiffuseSrvHeapIndex = 4;
+    material->NormalSrvHeapIndex = 5;
+    material->DiffuseAlbedo = mGLTFMaterials[i].baseColorFactor;
+    material->Emissive = mGLTFMaterials[i].emissiveFactor;
+    material->AlphaCutoff = mGLTFMaterials[i].alphaCutoff;
+    if (mGLTFMaterials[i].metallicRoughnessMap == -1) {
+      // Without a metallic-roughness map the factors are the material's
+      // values; metals reflect their base color.
+      XMVECTOR fresnelR0 = XMVectorLerp(
+        XMVectorReplicate(0.04f), XMLoadFloat4(&mGLTFMaterials[i].baseColorFactor), mGLTFMaterials[i].metallicFactor
+      );
+      XMStoreFloat3(&material->FresnelR0, fresnelR0);
+      material->Roughness = mGLTFMaterials[i].roughnessFactor;
+    } else {
+      // The factors scale a map that isn't sampled yet.
+      material->FresnelR0 = XMFLOAT3(0.05f, 0.05f, 0.05f);
+      // Rougher than brick.
+      material->Roughness = 0.3f;
     }
-    material->DiffuseAlbedo = XMFLOAT4(Colors::White);
-    material->FresnelR0 = XMFLOAT3(0.05f, 0.05f, 0.05f);
-    // Rougher than brick.
-    material->Roughness = 0.3f;
 
     mUnnamedMaterials[i] = std::move(material);
   }
@@ -1077,7 +1413,8 @@ void ShadowMappingApp::BuildMaterials() {
   auto picking = std::make_unique<Material>();
 	picking->Name = "picking";
 	picking->MatCBIndex = cbIndex++;
-	picking->DiffuseSrvHeapIndex = srvHeapIndex++;
+	// Pick() replaces it with the picked item's map.
+	picking->DiffuseSrvHeapIndex = 4;
 	picking->DiffuseAlbedo = XMFLOAT4(1.0f, 0.0f, 0.0f, 1.0f);
 	picking->FresnelR0 = XMFLOAT3(0.06f, 0.06f, 0.06f);
 	picking->Roughness = 1.0f;
@@ -1095,6 +1432,7 @@ void ShadowMappingApp::BuildRenderItems() {
 	skyRitem->IndexCount = skyRitem->Geo->DrawArgs["sphere"].IndexCount;
 	skyRitem->StartIndexLocation = skyRitem->Geo->DrawArgs["sphere"].StartIndexLocation;
 	skyRitem->BaseVertexLocation = skyRitem->Geo->DrawArgs["sphere"].BaseVertexLocation;
+	skyRitem->PositionBounds = skyRitem->Geo->DrawArgs["sphere"].Bounds;
 
 	mRitemLayer[(int)RenderLayer::Sky].push_back(skyRitem.get());
 	mAllRitems.push_back(std::move(skyRitem));
@@ -1109,6 +1447,7 @@ void ShadowMappingApp::BuildRenderItems() {
   quadRitem->IndexCount = quadRitem->Geo->DrawArgs["quad"].IndexCount;
   quadRitem->StartIndexLocation = quadRitem->Geo->DrawArgs["quad"].StartIndexLocation;
   quadRitem->BaseVertexLocation = quadRitem->Geo->DrawArgs["quad"].BaseVertexLocation;
+  quadRitem->PositionBounds = quadRitem->Geo->DrawArgs["quad"].Bounds;
 
   mRitemLayer[(int)RenderLayer::Debug].push_back(quadRitem.get());
   mAllRitems.push_back(std::move(quadRitem));
@@ -1123,6 +1462,7 @@ void ShadowMappingApp::BuildRenderItems() {
 	boxRitem->IndexCount = boxRitem->Geo->DrawArgs["box"].IndexCount;
 	boxRitem->StartIndexLocation = boxRitem->Geo->DrawArgs["box"].StartIndexLocation;
 	boxRitem->BaseVertexLocation = boxRitem->Geo->DrawArgs["box"].BaseVertexLocation;
+	boxRitem->PositionBounds = boxRitem->Geo->DrawArgs["box"].Bounds;
 
 	// mRitemLayer[(int)RenderLayer::Opaque].push_back(boxRitem.get());
 	mAllRitems.push_back(std::move(boxRitem));
@@ -1137,6 +1477,11 @@ void ShadowMappingApp::BuildRenderItems() {
   mainModelRitem->IndexCount = mainModelRitem->Geo->DrawArgs["mainModel"].IndexCount;
   mainModelRitem->StartIndexLocation = mainModelRitem->Geo->DrawArgs["mainModel"].StartIndexLocation;
   mainModelRitem->BaseVertexLocation = mainModelRitem->Geo->DrawArgs["mainModel"].BaseVertexLocation;
+  mainModelRitem->PositionBounds = mainModelRitem->Geo->DrawArgs["mainModel"].Bounds;
+  mainModelRitem->BBox = mainModelRitem->Geo->DrawArgs["mainModel"].Bounds;
+  const std::vector<SubmeshLod> &mainModelLods = mainModelRitem->Geo->DrawArgs["mainModel"].Lods;
+  mainModelRitem->Lods.push_back({ mainModelRitem->IndexCount, mainModelRitem->StartIndexLocation, 0.0f });
+  mainModelRitem->Lods.insert(mainModelRitem->Lods.end(), mainModelLods.begin(), mainModelLods.end());
 
   // mRitemLayer[(int)RenderLayer::Opaque].push_back(mainModelRitem.get());
   mAllRitems.push_back(std::move(mainModelRitem));
@@ -1151,6 +1496,7 @@ void ShadowMappingApp::BuildRenderItems() {
   gridRitem->IndexCount = gridRitem->Geo->DrawArgs["grid"].IndexCount;
   gridRitem->StartIndexLocation = gridRitem->Geo->DrawArgs["grid"].StartIndexLocation;
   gridRitem->BaseVertexLocation = gridRitem->Geo->DrawArgs["grid"].BaseVertexLocation;
+  gridRitem->PositionBounds = gridRitem->Geo->DrawArgs["grid"].Bounds;
 
 	// mRitemLayer[(int)RenderLayer::Opaque].push_back(gridRitem.get());
 	mAllRitems.push_back(std::move(gridRitem));
@@ -1178,6 +1524,7 @@ void ShadowMappingApp::BuildRenderItems() {
 		leftCylRitem->IndexCount = leftCylRitem->Geo->DrawArgs["cylinder"].IndexCount;
 		leftCylRitem->StartIndexLocation = leftCylRitem->Geo->DrawArgs["cylinder"].StartIndexLocation;
 		leftCylRitem->BaseVertexLocation = leftCylRitem->Geo->DrawArgs["cylinder"].BaseVertexLocation;
+		leftCylRitem->PositionBounds = leftCylRitem->Geo->DrawArgs["cylinder"].Bounds;
 
 		XMStoreFloat4x4(&rightCylRitem->World, leftCylWorld);
 		XMStoreFloat4x4(&rightCylRitem->TexTransform, brickTexTransform);
@@ -1188,6 +1535,7 @@ void ShadowMappingApp::BuildRenderItems() {
 		rightCylRitem->IndexCount = rightCylRitem->Geo->DrawArgs["cylinder"].IndexCount;
 		rightCylRitem->StartIndexLocation = rightCylRitem->Geo->DrawArgs["cylinder"].StartIndexLocation;
 		rightCylRitem->BaseVertexLocation = rightCylRitem->Geo->DrawArgs["cylinder"].BaseVertexLocation;
+		rightCylRitem->PositionBounds = rightCylRitem->Geo->DrawArgs["cylinder"].Bounds;
 
 		XMStoreFloat4x4(&leftSphereRitem->World, leftSphereWorld);
 		leftSphereRitem->TexTransform = Math::Identity4x4();
@@ -1198,6 +1546,7 @@ void ShadowMappingApp::BuildRenderItems() {
 		leftSphereRitem->IndexCount = leftSphereRitem->Geo->DrawArgs["sphere"].IndexCount;
 		leftSphereRitem->StartIndexLocation = leftSphereRitem->Geo->DrawArgs["sphere"].StartIndexLocation;
 		leftSphereRitem->BaseVertexLocation = leftSphereRitem->Geo->DrawArgs["sphere"].BaseVertexLocation;
+		leftSphereRitem->PositionBounds = leftSphereRitem->Geo->DrawArgs["sphere"].Bounds;
     leftSphereRitem->BBox = leftSphereRitem->Geo->DrawArgs["sphere"].Bounds;
 
 		XMStoreFloat4x4(&rightSphereRitem->World, rightSphereWorld);
@@ -1209,6 +1558,7 @@ void ShadowMappingApp::BuildRenderItems() {
 		rightSphereRitem->IndexCount = rightSphereRitem->Geo->DrawArgs["sphere"].IndexCount;
 		rightSphereRitem->StartIndexLocation = rightSphereRitem->Geo->DrawArgs["sphere"].StartIndexLocation;
 		rightSphereRitem->BaseVertexLocation = rightSphereRitem->Geo->DrawArgs["sphere"].BaseVertexLocation;
+		rightSphereRitem->PositionBounds = rightSphereRitem->Geo->DrawArgs["sphere"].Bounds;
     rightSphereRitem->BBox = rightSphereRitem->Geo->DrawArgs["sphere"].Bounds;
 
 		// mRitemLayer[(int)RenderLayer::Opaque].push_back(leftCylRitem.get());
@@ -1222,19 +1572,25 @@ void ShadowMappingApp::BuildRenderItems() {
 		mAllRitems.push_back(std::move(rightSphereRitem));
 	}
 
-  for (int i = 0; i < mUnnamedGeometries.size(); ++i) {
+  MeshGeometry *gltfGeo = mGeometries["gltfGeo"].get();
+  for (int i = 0; i < gltfGeo->DrawArgs.size(); ++i) {
+    const SubmeshGeometry &submesh = gltfGeo->DrawArgs[std::to_string(i)];
     auto unnamedGeomRenderItem = std::make_unique<RenderItem>();
     unnamedGeomRenderItem->World = Math::Identity4x4();
     unnamedGeomRenderItem->TexTransform = Math::Identity4x4();
     unnamedGeomRenderItem->ObjCBIndex = objCBIndex++;
-    unnamedGeomRenderItem->Geo = mUnnamedGeometries[i].get();
-    unnamedGeomRenderItem->Mat = mUnnamedMaterials[unnamedGeomRenderItem->Geo->DrawArgs["mainModel"].MaterialIndex].get();
+    unnamedGeomRenderItem->Geo = gltfGeo;
+    unnamedGeomRenderItem->Mat = mUnnamedMaterials[submesh.MaterialIndex].get();
     unnamedGeomRenderItem->PrimitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
-    unnamedGeomRenderItem->IndexCount = unnamedGeomRenderItem->Geo->DrawArgs["mainModel"].IndexCount;
-    unnamedGeomRenderItem->StartIndexLocation = unnamedGeomRenderItem->Geo->DrawArgs["mainModel"].StartIndexLocation;
-    unnamedGeomRenderItem->BaseVertexLocation = unnamedGeomRenderItem->Geo->DrawArgs["mainModel"].BaseVertexLocation;
-    unnamedGeomRenderItem->BBox = unnamedGeomRenderItem->Geo->DrawArgs["mainModel"].Bounds;
-    mRitemLayer[(int)RenderLayer::Opaque].push_back(unnamedGeomRenderItem.get());
+    unnamedGeomRenderItem->IndexCount = submesh.IndexCount;
+    unnamedGeomRenderItem->StartIndexLocation = submesh.StartIndexLocation;
+    unnamedGeomRenderItem->BaseVertexLocation = submesh.BaseVertexLocation;
+    unnamedGeomRenderItem->BBox = submesh.Bounds;
+    unnamedGeomRenderItem->PositionBounds = submesh.Bounds;
+    unnamedGeomRenderItem->Lods.push_back({ submesh.IndexCount, submesh.StartIndexLocation, 0.0f });
+    unnamedGeomRenderItem->Lods.insert(unnamedGeomRenderItem->Lods.end(), submesh.Lods.begin(), submesh.Lods.end());
+    bool alphaTested = mGLTFMaterials[submesh.MaterialIndex].alphaMode != GLTFAlphaMode::Opaque;
+    mRitemLayer[(int)(alphaTested ? RenderLayer::AlphaTested : RenderLayer::Opaque)].push_back(unnamedGeomRenderItem.get());
     mAllRitems.push_back(std::move(unnamedGeomRenderItem));
   }
 
@@ -1287,10 +1643,23 @@ void ShadowMappingApp::BuildPSOs() {
     IID_PPV_ARGS(&mPSOs["opaque"])
   ));
 
+  // Alpha-tested glTF materials (foliage, chains) are double-sided.
+  D3D12_GRAPHICS_PIPELINE_STATE_DESC alphaTestedPsoDesc = opaquePsoDesc;
+  alphaTestedPsoDesc.PS = {
+    reinterpret_cast<BYTE*>(mShaders["alphaTestedPS"]->GetBufferPointer()),
+    mShaders["alphaTestedPS"]->GetBufferSize()
+  };
+  alphaTestedPsoDesc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE;
+  ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(
+    &alphaTestedPsoDesc,
+    IID_PPV_ARGS(&mPSOs["alphaTested"])
+  ));
+
   D3D12_GRAPHICS_PIPELINE_STATE_DESC smapPsoDesc = opaquePsoDesc;
   smapPsoDesc.RasterizerState.DepthBias = 100000;
   smapPsoDesc.RasterizerState.DepthBiasClamp = 0.0f;
   smapPsoDesc.RasterizerState.SlopeScaledDepthBias = 1.0f;
+  smapPsoDesc.InputLayout = { mShadowInputLayout.data(), (UINT)mShadowInputLayout.size() };
   smapPsoDesc.pRootSignature = mRootSignature.Get();
   smapPsoDesc.VS = {
     reinterpret_cast<BYTE*>(mShaders["shadowVS"]->GetBufferPointer()),
@@ -1306,6 +1675,23 @@ void ShadowMappingApp::BuildPSOs() {
     &smapPsoDesc, IID_PPV_ARGS(&mPSOs["shadow_opaque"]))
   );
 
+  D3D12_GRAPHICS_PIPELINE_STATE_DESC smapAlphaTestedPsoDesc = smapPsoDesc;
+  smapAlphaTestedPsoDesc.InputLayout = {
+    mShadowAlphaTestedInputLayout.data(), (UINT)mShadowAlphaTestedInputLayout.size()
+  };
+  smapAlphaTestedPsoDesc.VS = {
+    reinterpret_cast<BYTE*>(mShaders["shadowAlphaTestedVS"]->GetBufferPointer()),
+    mShaders["shadowAlphaTestedVS"]->GetBufferSize()
+  };
+  smapAlphaTestedPsoDesc.PS = {
+    reinterpret_cast<BYTE*>(mShaders["shadowAlphaTestedPS"]->GetBufferPointer()),
+    mShaders["shadowAlphaTestedPS"]->GetBufferSize()
+  };
+  smapAlphaTestedPsoDesc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE;
+  ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(
+    &smapAlphaTestedPsoDesc, IID_PPV_ARGS(&mPSOs["shadow_alphaTested"]))
+  );
+
   D3D12_GRAPHICS_PIPELINE_STATE_DESC debugPsoDesc = opaquePsoDesc;
   debugPsoDesc.pRootSignature = mRootSignature.Get();
   debugPsoDesc.VS = {
@@ -1378,6 +1764,7 @@ void ShadowMappingApp::BuildPSOs() {
   basePsoDesc.DSVFormat = mDepthStencilFormat;
 
   D3D12_GRAPHICS_PIPELINE_STATE_DESC normalsPsoDesc = basePsoDesc;
+  normalsPsoDesc.InputLayout = { mNormalsInputLayout.data(), (UINT)mNormalsInputLayout.size() };
   normalsPsoDesc.VS = {
     reinterpret_cast<BYTE*>(mShaders["normalsVS"]->GetBufferPointer()),
     mShaders["normalsVS"]->GetBufferSize()
@@ -1392,6 +1779,21 @@ void ShadowMappingApp::BuildPSOs() {
   normalsPsoDesc.DSVFormat = mDepthStencilFormat;
   ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&normalsPsoDesc, IID_PPV_ARGS(&mPSOs["normals"])));
 
+  D3D12_GRAPHICS_PIPELINE_STATE_DESC normalsAlphaTestedPsoDesc = normalsPsoDesc;
+  normalsAlphaTestedPsoDesc.InputLayout = {
+    mNormalsAlphaTestedInputLayout.data(), (UINT)mNormalsAlphaTestedInputLayout.size()
+  };
+  normalsAlphaTestedPsoDesc.VS = {
+    reinterpret_cast<BYTE*>(mShaders["normalsAlphaTestedVS"]->GetBufferPointer()),
+    mShaders["normalsAlphaTestedVS"]->GetBufferSize()
+  };
+  normalsAlphaTestedPsoDesc.PS = {
+    reinterpret_cast<BYTE*>(mShaders["normalsAlphaTestedPS"]->GetBufferPointer()),
+    mShaders["normalsAlphaTestedPS"]->GetBufferSize()
+  };
+  normalsAlphaTestedPsoDesc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE;
+  ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&normalsAlphaTestedPsoDesc, IID_PPV_ARGS(&mPSOs["normals_alphaTested"])));
+
   D3D12_GRAPHICS_PIPELINE_STATE_DESC ssaoPsoDesc = basePsoDesc;
   // SSAO shader doesn't use a vertex buffer, which means that there aren't vertex
   // attribute and, therefore, there's no need for an input layout.
@@ -1454,6 +1856,11 @@ void ShadowMappingApp::Draw(const GameTimer &gt) {
   
   ThrowIfFailed(mCommandList->Reset(cmdListAlloc.Get(), mPSOs["opaque"].Get()));
 
+  // Records the uploads of some of the textures that have finished loading;
+  // a few per frame, so that no frame copies all of Sponza. They are sampled
+  // from a later frame, see BindUploadedGLTFTextures.
+  mAssetLoader.Poll(gMaxTextureUploadsPerFrame);
+
   ID3D12DescriptorHeap *descriptorHeaps[] = {
     mSrvDescriptorHeap.Get()
   };
@@ -1510,6 +1917,9 @@ void ShadowMappingApp::Draw(const GameTimer &gt) {
   mCommandList->SetPipelineState(mPSOs["opaque"].Get());
   DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Opaque]);
 
+  mCommandList->SetPipelineState(mPSOs["alphaTested"].Get());
+  DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::AlphaTested]);
+
   mCommandList->SetPipelineState(mPSOs["debug"].Get());
   DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Debug]);
 
@@ -1557,7 +1967,7 @@ void ShadowMappingApp::Draw(const GameTimer &gt) {
 }
 
 void ShadowMappingApp::DrawRenderItems(
-  ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& ritems
+  ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& ritems, bool vertexStreams
 ) {
   UINT objCBByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(ObjectConstants));
 
@@ -1567,9 +1977,15 @@ void ShadowMappingApp::DrawRenderItems(
     auto ri = ritems[i];
     if (!ri->Visible) continue;
 
-    D3D12_VERTEX_BUFFER_VIEW vertexBufferView = ri->Geo->VertexBufferView();
     D3D12_INDEX_BUFFER_VIEW indexBufferView = ri->Geo->IndexBufferView();
-    cmdList->IASetVertexBuffers(0, 1, &vertexBufferView);
+    if (vertexStreams) {
+      D3D12_VERTEX_BUFFER_VIEW streamBufferViews[VertexStreams::AttributeCount];
+      ri->Geo->StreamBufferViews(streamBufferViews);
+      cmdList->IASetVertexBuffers(0, VertexStreams::AttributeCount, streamBufferViews);
+    } else {
+      D3D12_VERTEX_BUFFER_VIEW vertexBufferView = ri->Geo->VertexBufferView();
+      cmdList->IASetVertexBuffers(0, 1, &vertexBufferView);
+    }
     cmdList->IASetIndexBuffer(&indexBufferView);
     cmdList->IASetPrimitiveTopology(ri->PrimitiveType);
     D3D12_GPU_VIRTUAL_ADDRESS objCBAddress = objectCB->GetGPUVirtualAddress() + ri->ObjCBIndex*objCBByteSize;
@@ -1603,7 +2019,11 @@ void ShadowMappingApp::DrawSceneToShadowMap() {
 
   mCommandList->SetPipelineState(mPSOs["shadow_opaque"].Get());
 
-  DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Opaque]);
+  DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Opaque], true);
+
+  mCommandList->SetPipelineState(mPSOs["shadow_alphaTested"].Get());
+
+  DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::AlphaTested], true);
 
   CD3DX12_RESOURCE_BARRIER shadowMapReadBarrier = CD3DX12_RESOURCE_BARRIER::Transition(
     mShadowMap->Resource(), D3D12_RESOURCE_STATE_DEPTH_WRITE, D3D12_RESOURCE_STATE_GENERIC_READ
@@ -1634,7 +2054,11 @@ void ShadowMappingApp::DrawNormalsAndDepth() {
   mCommandList->SetGraphicsRootConstantBufferView(1, passCB->GetGPUVirtualAddress());
   mCommandList->SetPipelineState(mPSOs["normals"].Get());
 
-  DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Opaque]);
+  DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Opaque], true);
+
+  mCommandList->SetPipelineState(mPSOs["normals_alphaTested"].Get());
+
+  DrawRenderItems(mCommandList.Get(), mRitemLayer[(int)RenderLayer::AlphaTested], true);
 
   mCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(
     normalMap,
@@ -1741,6 +2165,18 @@ void ShadowMappingApp::Update(const GameTimer &gt) {
     DirectX::XMStoreFloat3(&mRotatedLightDirections[i], lightDir);
   }
 
+  BindUploadedGLTFTextures();
+  CullGLTFMeshlets();
+  SelectLods();
+
+  AssetLoader::Progress progress = mAssetLoader.GetProgress();
+  if (progress.Ready < progress.Submitted || !mPendingGLTFTextures.empty()) {
+    ImGui::Begin("Loading");
+    ImGui::Text("Sponza textures: %u of %zu", mBoundGLTFTextureCount, mGLTFTextures.size());
+    ImGui::ProgressBar(mGLTFTextures.empty() ? 1.0f : (float)mBoundGLTFTextureCount / mGLTFTextures.size());
+    ImGui::End();
+  }
+
   AnimateMaterials(gt);
 	UpdateObjectCBs(gt);
 	UpdateMaterialBuffer(gt);
@@ -1760,6 +2196,8 @@ void ShadowMappingApp::UpdateObjectCBs(const GameTimer &gt) {
       DirectX::XMStoreFloat4x4(&objConstants.World, DirectX::XMMatrixTranspose(world));
       DirectX::XMStoreFloat4x4(&objConstants.TexTransform, DirectX::XMMatrixTranspose(texTransform));
       objConstants.MaterialIndex = ritem->Mat->MatCBIndex;
+      objConstants.PositionCenter = ritem->PositionBounds.Center;
+      objConstants.PositionExtents = ritem->PositionBounds.Extents;
       currObjectCB->CopyData(ritem->ObjCBIndex, objConstants);
       ritem->NumFramesDirty--;
     }
@@ -1779,6 +2217,8 @@ void ShadowMappingApp::UpdateMaterialBuffer(const GameTimer &gt) {
 			DirectX::XMStoreFloat4x4(&matData.MatTransform, DirectX::XMMatrixTranspose(matTransform));
 			matData.DiffuseMapIndex = mat->DiffuseSrvHeapIndex;
 			matData.NormalMapIndex = mat->NormalSrvHeapIndex;
+			matData.AlphaCutoff = mat->AlphaCutoff;
+			matData.Emissive = mat->Emissive;
 			currMaterialBuffer->CopyData(mat->MatCBIndex, matData);
 			mat->NumFramesDirty--;
     }
@@ -1797,6 +2237,8 @@ void ShadowMappingApp::UpdateMaterialBuffer(const GameTimer &gt) {
       XMStoreFloat4x4(&matConstants.MatTransform, XMMatrixTranspose(matTransform));
       matConstants.DiffuseMapIndex = mat->DiffuseSrvHeapIndex;
       matConstants.NormalMapIndex = mat->NormalSrvHeapIndex;
+      matConstants.AlphaCutoff = mat->AlphaCutoff;
+      matConstants.Emissive = mat->Emissive;
       currMaterialBuffer->CopyData(mat->MatCBIndex, matConstants);
       mat->NumFramesDirty--;
     }
@@ -2038,7 +2480,13 @@ void ShadowMappingApp::Pick(int sx, int sy) {
 
   mPickedRitem->Visible = false;
 
-  for (auto ritem : mRitemLayer[(int)RenderLayer::Opaque]) {
+  // Alpha-tested items (foliage, chains) are pickable too.
+  std::vector<RenderItem*> pickable = mRitemLayer[(int)RenderLayer::Opaque];
+  pickable.insert(
+    pickable.end(), mRitemLayer[(int)RenderLayer::AlphaTested].begin(), mRitemLayer[(int)RenderLayer::AlphaTested].end()
+  );
+
+  for (auto ritem : pickable) {
     if (!ritem->Visible) {
       continue;
     }
@@ -2057,16 +2505,19 @@ void ShadowMappingApp::Pick(int sx, int sy) {
 
     // Test ray against object bounding box for intersection.
     if (ritem->BBox.Intersects(pickingRayOrigin, pickingRayDirection, minT)) {
-      auto vertices = (Vertex *) geo->VertexBufferCPU->GetBufferPointer();
-      auto indices = (uint16_t *) geo->IndexBufferCPU->GetBufferPointer();
+      // Render items may share a geometry; only this item's range of it.
+      auto vertices = (Vertex *) geo->VertexBufferCPU->GetBufferPointer() + ritem->BaseVertexLocation;
+      auto indices16 = (uint16_t *) geo->IndexBufferCPU->GetBufferPointer() + ritem->StartIndexLocation;
+      auto indices32 = (uint32_t *) geo->IndexBufferCPU->GetBufferPointer() + ritem->StartIndexLocation;
+      bool indices16Bit = geo->IndexFormat == DXGI_FORMAT_R16_UINT;
 
       UINT triangleCount = ritem->IndexCount / 3;
 
       minT = Math::Infinity;
       for (UINT i = 0; i < triangleCount; ++i) {
-        UINT i0 = indices[3*i];
-        UINT i1 = indices[3*i + 1];
-        UINT i2 = indices[3*i + 2];
+        UINT i0 = indices16Bit ? indices16[3*i] : indices32[3*i];
+        UINT i1 = indices16Bit ? indices16[3*i + 1] : indices32[3*i + 1];
+        UINT i2 = indices16Bit ? indices16[3*i + 2] : indices32[3*i + 2];
 
         XMVECTOR v0 = XMLoadFloat3(&vertices[i0].Pos);
         XMVECTOR v1 = XMLoadFloat3(&vertices[i1].Pos);
@@ -2086,12 +2537,13 @@ void ShadowMappingApp::Pick(int sx, int sy) {
           mPickedRitem->Visible = true;
           // Only the 3 vertices of the picked triangle.
           mPickedRitem->IndexCount = 3;
-          mPickedRitem->BaseVertexLocation = 0;
+          mPickedRitem->BaseVertexLocation = ritem->BaseVertexLocation;
           mPickedRitem->World = ritem->World;
           mPickedRitem->Mat = mMaterials["picking"].get();
           mPickedRitem->Geo = ritem->Geo;
+          mPickedRitem->PositionBounds = ritem->PositionBounds;
           // Offset into the original index buffer.
-          mPickedRitem->StartIndexLocation = 3*i;
+          mPickedRitem->StartIndexLocation = ritem->StartIndexLocation + 3*i;
           mPickedRitem->NumFramesDirty = gNumFrameResources;
           // mPickedRitem->ObjCBIndex = ritem->ObjCBIndex;
 
@@ -1,36 +1,43 @@
 #include "Common.hlsl"
 
+// Reads the position stream of the geometry, and its texture coordinate
+// stream when alpha tested (see VertexStreams).
 struct VertexIn {
 	float3 PosL: POSITION;
+#ifdef ALPHA_TEST
 	float2 TexC: TEXCOORD;
+#endif
 };
 
 struct VertexOut {
 	float4 PosH: SV_POSITION;
+#ifdef ALPHA_TEST
 	float2 TexC: TEXCOORD;
+#endif
 };
 
 VertexOut VS(VertexIn vin) {
 	VertexOut vout = (VertexOut) 0.0f;
 
-	MaterialData matData = gMaterialData[gMaterialIndex];
-
-	float4 posW = mul(float4(vin.PosL, 1.0f), gWorld);
+	float4 posW = mul(float4(DecodePosition(vin.PosL), 1.0f), gWorld);
 
 	vout.PosH = mul(posW, gViewProj);
 
+#ifdef ALPHA_TEST
+	MaterialData matData = gMaterialData[gMaterialIndex];
 	float4 texC = mul(float4(vin.TexC, 0.0f, 1.0f), gTexTransform);
 	vout.TexC = mul(texC, matData.MatTransform).xy;
+#endif
 
 	return vout;
 }
 
 void PS(VertexOut pin) {
+#ifdef ALPHA_TEST
 	MaterialData matData = gMaterialData[gMaterialIndex];
 	float4 diffuseAlbedo = matData.DiffuseAlbedo;
 	uint diffuseMapIndex = matData.DiffuseMapIndex;
 	diffuseAlbedo *= gTextureMaps[diffuseMapIndex].Sample(gsamAnisotropicWrap, pin.TexC);
-#ifdef ALPHA_TEST
-	clip(diffuseAlbedo.a - 0.1f);
+	clip(diffuseAlbedo.a - matData.AlphaCutoff);
 #endif
 }
\ No newline at end of file
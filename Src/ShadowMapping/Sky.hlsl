@@ -2,7 +2,7 @@
 
 struct VertexIn {
 	float3 PosL : POSITION;
-	float3 NormalL : NORMAL;
+	VertexDirection NormalL : NORMAL;
 	float2 TexC : TEXCOORD;
 };
 
@@ -13,8 +13,8 @@ struct VertexOut {
  
 VertexOut VS(VertexIn vin) {
 	VertexOut vout;
-	vout.PosL = vin.PosL;
-	float4 posW = mul(float4(vin.PosL, 1.0f), gWorld);
+	vout.PosL = DecodePosition(vin.PosL);
+	float4 posW = mul(float4(vout.PosL, 1.0f), gWorld);
 	posW.xyz += gEyePosW;
 	vout.PosH = mul(posW, gViewProj).xyww;	
 	return vout;
@@ -5,6 +5,7 @@
 #include "../Common/DDSTextureLoader.h"
 #include "../Common/Camera.h"
 #include "../Common/GLTFLoader.h"
+#include "../Common/MeshImport.h"
 #include "FrameResource.h"
 #include "RenderItem.h"
 #include <iostream>
@@ -411,42 +412,28 @@ void StencilingApp::BuildGeometry() {
 }
 
 void StencilingApp::BuildMainModelGeometry() {
-    std::ifstream fin("Assets/car.txt");
-	
-	if(!fin) {
+	MeshImport::VertexLayout layout;
+	layout.Stride = sizeof(Vertex);
+	layout.PositionOffset = offsetof(Vertex, Pos);
+	layout.NormalOffset = offsetof(Vertex, Normal);
+	layout.TexCOffset = offsetof(Vertex, TexC);
+
+	// No normal mapping in this sample.
+	MeshImport::Options options;
+	options.GenerateTangents = false;
+
+	MeshImport::Mesh mesh;
+	if (!MeshImport::Import("Assets/car.txt", layout, options, mesh)) {
 		MessageBox(0, L"Assets/car.txt not found.", 0, 0);
 		return;
 	}
 
-	UINT vcount = 0;
-	UINT tcount = 0;
-	std::string ignore;
-
-	fin >> ignore >> vcount;
-	fin >> ignore >> tcount;
-	fin >> ignore >> ignore >> ignore >> ignore;
-	
-	std::vector<Vertex> vertices(vcount);
-	for(UINT i = 0; i < vcount; ++i) {
-		fin >> vertices[i].Pos.x >> vertices[i].Pos.y >> vertices[i].Pos.z;
-		fin >> vertices[i].Normal.x >> vertices[i].Normal.y >> vertices[i].Normal.z;
-		vertices[i].TexC = { 0.0f, 0.0f };
-	}
-
-	fin >> ignore;
-	fin >> ignore;
-	fin >> ignore;
-
-	std::vector<std::int32_t> indices(3 * tcount);
-	for(UINT i = 0; i < tcount; ++i) {
-		fin >> indices[i*3+0] >> indices[i*3+1] >> indices[i*3+2];
-	}
-
-	fin.close();
+	const std::vector<uint8_t>& vertices = mesh.VertexData;
+	const std::vector<uint8_t>& indices = mesh.IndexData;
 
-	const UINT vbByteSize = (UINT)vertices.size() * sizeof(Vertex);
+	const UINT vbByteSize = (UINT)vertices.size();
 
-	const UINT ibByteSize = (UINT)indices.size() * sizeof(std::int32_t);
+	const UINT ibByteSize = (UINT)indices.size();
 
 	auto geo = std::make_unique<MeshGeometry>();
 	geo->Name = "mainModelGeo";
@@ -475,11 +462,11 @@ void StencilingApp::BuildMainModelGeometry() {
 
 	geo->VertexByteStride = sizeof(Vertex);
 	geo->VertexBufferByteSize = vbByteSize;
-	geo->IndexFormat = DXGI_FORMAT_R32_UINT;
+	geo->IndexFormat = mesh.IndexStride == sizeof(std::uint16_t) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
 	geo->IndexBufferByteSize = ibByteSize;
 
 	SubmeshGeometry submesh;
-	submesh.IndexCount = (UINT)indices.size();
+	submesh.IndexCount = mesh.IndexCount;
 	submesh.StartIndexLocation = 0;
 	submesh.BaseVertexLocation = 0;
 
@@ -498,7 +485,6 @@ void StencilingApp::BuildGeometryFromGLTF() {
     for (int primIdx = 0; primIdx < primCount; ++primIdx) {
         GLTFPrimitiveData loadedData = gltfLoader->LoadPrimitive(0, primIdx);
 
-        std::vector<std::uint16_t> &indices = loadedData.indices;
         std::vector<Vertex> vertices(loadedData.positions.size());
 
         float scale = 0.005;
@@ -510,7 +496,7 @@ void StencilingApp::BuildGeometryFromGLTF() {
 
         const UINT vbByteSize = (UINT)vertices.size() * sizeof(Vertex);
 
-        const UINT ibByteSize = (UINT)indices.size() * sizeof(std::uint16_t);
+        const UINT ibByteSize = (UINT)(loadedData.indexCount() * loadedData.indexStride());
 
         auto geo = std::make_unique<MeshGeometry>();
         geo->Name = std::to_string(primIdx);
@@ -519,7 +505,7 @@ void StencilingApp::BuildGeometryFromGLTF() {
         CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
 
         ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
-        CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
+        CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), loadedData.indexData(), ibByteSize);
 
         geo->VertexBufferGPU = d3dUtil::CreateDefaultBuffer(
             md3dDevice.Get(),
@@ -532,18 +518,18 @@ void StencilingApp::BuildGeometryFromGLTF() {
         geo->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(
             md3dDevice.Get(),
             mCommandList.Get(),
-            indices.data(),
+            loadedData.indexData(),
             ibByteSize,
             geo->IndexBufferUploader
         );
 
         geo->VertexByteStride = sizeof(Vertex);
         geo->VertexBufferByteSize = vbByteSize;
-        geo->IndexFormat = DXGI_FORMAT_R16_UINT;
+        geo->IndexFormat = loadedData.indexStride() == 2 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
         geo->IndexBufferByteSize = ibByteSize;
 
         SubmeshGeometry submesh;
-        submesh.IndexCount = (UINT)indices.size();
+        submesh.IndexCount = (UINT)loadedData.indexCount();
         submesh.StartIndexLocation = 0;
         submesh.BaseVertexLocation = 0;
 
@@ -713,7 +713,6 @@ void TexturingApp::BuildGeometryFromGLTF() {
     for (int primIdx = 0; primIdx < primCount; ++primIdx) {
         GLTFPrimitiveData loadedData = mGLTFLoader->LoadPrimitive(0, primIdx);
 
-        std::vector<std::uint16_t> &indices = loadedData.indices;
         std::vector<Vertex> vertices(loadedData.positions.size());
 
         float scale = 1.005;
@@ -733,7 +732,7 @@ void TexturingApp::BuildGeometryFromGLTF() {
 
         const UINT vbByteSize = (UINT)vertices.size() * sizeof(Vertex);
 
-        const UINT ibByteSize = (UINT)indices.size() * sizeof(std::uint16_t);
+        const UINT ibByteSize = (UINT)(loadedData.indexCount() * loadedData.indexStride());
 
         auto geo = std::make_unique<MeshGeometry>();
         geo->Name = std::to_string(primIdx);
@@ -742,7 +741,7 @@ void TexturingApp::BuildGeometryFromGLTF() {
         CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
 
         ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
-        CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
+        CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), loadedData.indexData(), ibByteSize);
 
         geo->VertexBufferGPU = d3dUtil::CreateDefaultBuffer(
             md3dDevice.Get(),
@@ -755,18 +754,18 @@ void TexturingApp::BuildGeometryFromGLTF() {
         geo->IndexBufferGPU = d3dUtil::CreateDefaultBuffer(
             md3dDevice.Get(),
             mCommandList.Get(),
-            indices.data(),
+            loadedData.indexData(),
             ibByteSize,
             geo->IndexBufferUploader
         );
 
         geo->VertexByteStride = sizeof(Vertex);
         geo->VertexBufferByteSize = vbByteSize;
-        geo->IndexFormat = DXGI_FORMAT_R16_UINT;
+        geo->IndexFormat = loadedData.indexStride() == 2 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
         geo->IndexBufferByteSize = ibByteSize;
 
         SubmeshGeometry submesh;
-        submesh.IndexCount = (UINT)indices.size();
+        submesh.IndexCount = (UINT)loadedData.indexCount();
         submesh.StartIndexLocation = 0;
         submesh.BaseVertexLocation = 0;
         submesh.TextureIndex = loadedData.texture;
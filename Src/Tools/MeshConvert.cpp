@@ -0,0 +1,59 @@
+// Converts text meshes (Assets/car.txt, Assets/skull.txt) to the binary mesh
+// cache format read by MeshCache::File, and reports the vertex cache
+// efficiency of the mesh before and after reordering, its levels of detail
+// and the error of its vertices packed by VertexQuantize.
+//
+// Usage: mesh_convert input.txt [output.mesh]
+//   The output defaults to the input with its extension replaced by .mesh.
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "../Common/MeshCache.h"
+#include "../Common/VertexQuantize.h"
+
+int main(int argc, char** argv) {
+    if (argc < 2 || argc > 3) {
+        printf("Usage: %s input.txt [output.mesh]\n", argv[0]);
+        return 1;
+    }
+
+    std::string input = argv[1];
+    std::string output = argc == 3
+        ? std::string(argv[2])
+        : std::filesystem::path(input).replace_extension("mesh").string();
+
+    MeshCache::MeshData mesh;
+    if (!MeshCache::LoadTextMesh(input, mesh)) {
+        printf("Failed to parse %s\n", input.c_str());
+        return 1;
+    }
+
+    if (!MeshCache::Write(output, mesh)) {
+        printf("Failed to write %s\n", output.c_str());
+        return 1;
+    }
+
+    printf("%s: %zu vertices, %zu triangles -> %s\n",
+        input.c_str(), mesh.Vertices.size(), mesh.Indices.size() / 3, output.c_str());
+
+    const MeshImport::OptimizeReport& report = mesh.Optimization;
+    printf("vertex cache (FIFO %u): ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n",
+        MeshOptimize::DefaultCacheSize, report.Before.ACMR, report.After.ACMR, report.Before.ATVR, report.After.ATVR);
+
+    for (size_t i = 0; i < mesh.Lods.size(); ++i) {
+        printf("LOD %zu: %zu triangles, error %g\n", i + 1, mesh.Lods[i].Indices.size() / 3, mesh.Lods[i].Error);
+    }
+
+    VertexQuantize::Bounds bounds;
+    bounds.Center = mesh.BoundsCenter;
+    bounds.Extents = mesh.BoundsExtents;
+    std::vector<VertexQuantize::PackedVertex> packed(mesh.Vertices.size());
+    VertexQuantize::Encode(mesh.Vertices.data(), mesh.Vertices.size(), bounds, packed.data());
+    VertexQuantize::ErrorStats error = VertexQuantize::MeasureError(mesh.Vertices.data(), mesh.Vertices.size(), bounds, packed.data());
+    printf("packed vertices (%zu -> %zu bytes): position %g, normal %g deg, tangent %g deg, texC %g\n",
+        sizeof(MeshCache::Vertex), sizeof(VertexQuantize::PackedVertex), error.Position, error.Normal, error.Tangent, error.TexC);
+    return 0;
+}
@@ -0,0 +1,146 @@
+// Compiles the default scene of a glTF file to the pack format read by
+// ScenePack::File: interleaved vertices with tangents, indices, submesh draw
+// ranges and bounds, materials, the paths of the unique texture images,
+// meshlets and levels of detail. Also reports the error of the vertices packed
+// by VertexQuantize against their submesh bounds, as ShadowMapping packs them.
+//
+// Usage: scene_compiler input.gltf [output.scene] [--scale s] [--report]
+//   The output defaults to the input with its extension replaced by .scene.
+//   --scale bakes a uniform scale into the vertices; ShadowMapping draws
+//   Sponza at --scale 10.
+//   --report prints the vertex cache efficiency of every submesh before and
+//   after reordering, and its levels of detail, not just the scene totals.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "../Common/ScenePack.h"
+#include "../Common/VertexQuantize.h"
+
+int main(int argc, char** argv) {
+    std::string input;
+    std::string output;
+    float scale = 1.0f;
+    bool report = false;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--scale") == 0 && i + 1 < argc) {
+            scale = static_cast<float>(atof(argv[++i]));
+        } else if (strcmp(argv[i], "--report") == 0) {
+            report = true;
+        } else if (input.empty()) {
+            input = argv[i];
+        } else if (output.empty()) {
+            output = argv[i];
+        } else {
+            input.clear();
+            break;
+        }
+    }
+
+    if (input.empty()) {
+        printf("Usage: %s input.gltf [output.scene] [--scale s] [--report]\n", argv[0]);
+        return 1;
+    }
+    if (output.empty()) {
+        output = std::filesystem::path(input).replace_extension("scene").string();
+    }
+
+    MeshImport::Options options;
+    DirectX::XMStoreFloat4x4(&options.Transform, DirectX::XMMatrixScaling(scale, scale, scale));
+
+    ScenePack::SceneData scene;
+    if (!ScenePack::Compile(input, options, scene)) {
+        printf("Failed to load %s\n", input.c_str());
+        return 1;
+    }
+
+    if (!ScenePack::Write(output, scene)) {
+        printf("Failed to write %s\n", output.c_str());
+        return 1;
+    }
+
+    uint64_t triangleCount = 0;
+    for (const ScenePack::Submesh& submesh : scene.Submeshes) {
+        triangleCount += submesh.IndexCount / 3;
+    }
+
+    printf("%s: %zu submeshes, %u vertices, %llu triangles, %zu materials, %zu textures -> %s\n",
+        input.c_str(), scene.Submeshes.size(), scene.VertexCount, (unsigned long long)triangleCount,
+        scene.Materials.size(), scene.Textures.size(), output.c_str());
+
+    const ScenePack::TextureStats& stats = scene.TextureStatistics;
+    printf("textures: %u material slots -> %u glTF textures (%.1f MB) -> %u unique images (%.1f MB)\n",
+        stats.MaterialSlotCount, stats.SourceTextureCount, stats.SourceTextureBytes / (1024.0 * 1024.0),
+        stats.ImageCount, stats.ImageBytes / (1024.0 * 1024.0));
+
+    // Scene totals weigh each submesh by its triangles and vertices.
+    uint64_t trianglesTotal = 0, verticesTotal = 0, missesBefore = 0, missesAfter = 0;
+    for (size_t i = 0; i < scene.SubmeshOptimization.size(); ++i) {
+        const MeshImport::OptimizeReport& submesh = scene.SubmeshOptimization[i];
+        trianglesTotal += submesh.Before.TriangleCount;
+        verticesTotal += submesh.Before.VertexCount;
+        missesBefore += submesh.Before.Misses;
+        missesAfter += submesh.After.Misses;
+        if (report) {
+            printf("  submesh %3zu: %7u triangles, ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n",
+                i, submesh.Before.TriangleCount, submesh.Before.ACMR, submesh.After.ACMR, submesh.Before.ATVR, submesh.After.ATVR);
+        }
+    }
+    if (trianglesTotal > 0 && verticesTotal > 0) {
+        printf("vertex cache (FIFO %u): ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", MeshOptimize::DefaultCacheSize,
+            double(missesBefore) / trianglesTotal, double(missesAfter) / trianglesTotal,
+            double(missesBefore) / verticesTotal, double(missesAfter) / verticesTotal);
+    }
+
+    // Triangles of each level over the whole scene; a submesh whose chain
+    // ended early counts with its coarsest level.
+    std::vector<uint64_t> lodTriangles(ScenePack::MaxLods, 0);
+    std::vector<float> lodErrors(ScenePack::MaxLods, 0.0f);
+    for (size_t i = 0; i < scene.Submeshes.size(); ++i) {
+        const ScenePack::Submesh& submesh = scene.Submeshes[i];
+        for (int level = 0; level < ScenePack::MaxLods; ++level) {
+            uint32_t indexCount = submesh.IndexCount;
+            if (submesh.LodCount > 0) {
+                const ScenePack::Lod& lod = scene.Lods[submesh.LodOffset + std::min<uint32_t>(level, submesh.LodCount - 1)];
+                indexCount = lod.IndexCount;
+                lodErrors[level] = std::max(lodErrors[level], lod.Error);
+            }
+            lodTriangles[level] += indexCount / 3;
+        }
+        if (report) {
+            printf("  submesh %3zu LODs:", i);
+            for (uint32_t l = 0; l < submesh.LodCount; ++l) {
+                const ScenePack::Lod& lod = scene.Lods[submesh.LodOffset + l];
+                printf(" %u (%.3g)", lod.IndexCount / 3, lod.Error);
+            }
+            printf("\n");
+        }
+    }
+    printf("levels of detail (triangles, largest error):");
+    for (int level = 0; level < ScenePack::MaxLods; ++level) {
+        printf(" %llu (%.3g)", (unsigned long long)lodTriangles[level], lodErrors[level]);
+    }
+    printf("\n");
+
+    VertexQuantize::ErrorStats packedError;
+    const ScenePack::Vertex* vertices = reinterpret_cast<const ScenePack::Vertex*>(scene.VertexData.data());
+    for (const ScenePack::Submesh& submesh : scene.Submeshes) {
+        VertexQuantize::Bounds bounds;
+        bounds.Center = submesh.BoundsCenter;
+        bounds.Extents = submesh.BoundsExtents;
+        std::vector<VertexQuantize::PackedVertex> packed(submesh.VertexCount);
+        VertexQuantize::Encode(vertices + submesh.BaseVertexLocation, submesh.VertexCount, bounds, packed.data());
+        packedError = VertexQuantize::Max(packedError,
+            VertexQuantize::MeasureError(vertices + submesh.BaseVertexLocation, submesh.VertexCount, bounds, packed.data()));
+    }
+    printf("packed vertices (%zu -> %zu bytes): position %g, normal %g deg, tangent %g deg, texC %g\n",
+        sizeof(ScenePack::Vertex), sizeof(VertexQuantize::PackedVertex),
+        packedError.Position, packedError.Normal, packedError.Tangent, packedError.TexC);
+    return 0;
+}